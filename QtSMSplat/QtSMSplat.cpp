@@ -4,6 +4,7 @@
 #include <QFileInfo>
 #include <QDebug>
 #include <QDateTime>
+#include <QtConcurrent>
 
 QObject *QtSMSplat::createQtSMSplatSingleton(QQmlEngine *engine, QJSEngine *scriptEngine) {
     Q_UNUSED(scriptEngine)
@@ -29,6 +30,9 @@ QtSMSplat::QtSMSplat(QObject *parent)
       m_imageProvider(new SMSplatImageProvider()) {
     m_splatManager = std::make_unique<SMSplatManager>();
 
+    connect(&m_generateWatcher, &QFutureWatcher<GenerateResult>::finished, this,
+            &QtSMSplat::finishGenerate);
+
    // connect(&m_splatModel, &SMSplatListModel::countChanged, this, [this]() {
    //     for (const auto &name : m_splatModel.names()) {
    //         auto inputInfo = m_inputModel.getByName(name);
@@ -41,7 +45,13 @@ QtSMSplat::QtSMSplat(QObject *parent)
    // });
 }
 
-QtSMSplat::~QtSMSplat() = default;
+QtSMSplat::~QtSMSplat() {
+    // The worker uses m_splatManager; stop it before that goes
+    if (m_generateCancel) {
+        *m_generateCancel = true;
+    }
+    m_generateWatcher.waitForFinished();
+}
 
 SMSplatListModel *QtSMSplat::splatModel() const {
     return const_cast<SMSplatListModel *>(&m_splatModel);
@@ -51,7 +61,11 @@ InputListModel *QtSMSplat::inputModel() const {
     return const_cast<InputListModel *>(&m_inputModel);
 }
 
-bool QtSMSplat::busy() const { return m_busy; }
+bool QtSMSplat::busy() const { return m_busy || m_generating; }
+
+QtSMSplat::Phase QtSMSplat::phase() const { return m_phase; }
+
+double QtSMSplat::progress() const { return m_progress; }
 
 SMSplatImageProvider* QtSMSplat::imageProvider() const { return m_imageProvider; }
 
@@ -108,45 +122,109 @@ bool QtSMSplat::generate(QtSMSplatInputInfo *inputInfo) {
         return false;
     }
 
-    setBusy(true);
+    if (m_generating) {
+        setLastError("A SPLAT generation is already running");
+        return false;
+    }
 
-    try {
-        SMSplatInputInfo nativeInput = inputInfo->toStruct();
-        auto genInfo = m_splatManager->generate(nativeInput);
-        auto resultInfo = std::make_shared<QtSMSplatGenInfo>(genInfo);
-        resultInfo->setIsSavedInDb(false);
-        resultInfo->setImageId(inputInfo->generateImageId());
-
-        QString name = resultInfo->coverageName();
-        updateImageProvider(resultInfo->imageId(), resultInfo->image());
-
-        QString inputName = inputInfo->transmitterName();
-        if (m_inputModel.contains(inputName)) {
-            m_inputModel.updateByName(inputName, inputInfo);
-        } else {
-            m_inputModel.append(inputInfo);
-        }
+    // The worker gets its own copies of the input's strings, so the
+    // input may change or go away while it runs
+    SMSplatInputInfo nativeInput = inputInfo->toStruct();
+    QByteArray name = inputInfo->transmitterName().toUtf8();
+    QByteArray covType = inputInfo->itmCovType().toUtf8();
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    SMSplatManager *manager = m_splatManager.get();
+
+    m_generateInput = inputInfo;
+    m_generateName = name;
+    m_generateCancel = cancel;
+    setProgress(TerrainPhase, 0.0);
+    setGenerating(true);
+
+    auto report = [this](SMSplatPhase phase, double fraction) {
+        QMetaObject::invokeMethod(
+            this, [this, phase, fraction]() { setProgress(static_cast<Phase>(phase), fraction); },
+            Qt::QueuedConnection);
+    };
+
+    m_generateWatcher.setFuture(QtConcurrent::run(
+        [manager, nativeInput, name, covType, cancel, report]() {
+            GenerateResult result;
+            SMSplatInputInfo input = nativeInput;
+
+            input.transmitter_name = name.constData();
+            input.itm_cov_type = covType.constData();
+
+            try {
+                result.info = manager->generate(input, report, cancel.get());
+            } catch (const SplatCancelled &) {
+                result.cancelled = true;
+            } catch (const std::exception &e) {
+                result.error = QString("Error generating SPLAT: %1").arg(e.what());
+            } catch (...) {
+                result.error = "Unknown error generating SPLAT";
+            }
 
-        if (m_splatModel.contains(name)) {
-            m_splatModel.updateByName(name, resultInfo);
-        } else {
-            m_splatModel.append(resultInfo);
-        }
+            // coverage_name points into this thread's copy of the name
+            result.info.coverage_name = nullptr;
+            return result;
+        }));
 
+    return true;
+}
 
+void QtSMSplat::cancelGenerate() {
+    if (m_generating && m_generateCancel) {
+        *m_generateCancel = true;
+    }
+}
 
-        setBusy(false);
-        emit splatGenerated(name);
-        return true;
-    } catch (const std::exception &e) {
-        setBusy(false);
-        setLastError(QString("Error generating SPLAT: %1").arg(e.what()));
-        return false;
-    } catch (...) {
-        setBusy(false);
-        setLastError("Unknown error generating SPLAT");
-        return false;
+void QtSMSplat::finishGenerate() {
+    GenerateResult result = m_generateWatcher.result();
+    QPointer<QtSMSplatInputInfo> inputInfo = m_generateInput;
+    QByteArray generatedName = m_generateName;
+
+    m_generateInput = nullptr;
+    m_generateCancel.reset();
+    setGenerating(false);
+
+    if (result.cancelled) {
+        emit splatCancelled(QString::fromUtf8(generatedName));
+        return;
+    }
+
+    if (!result.error.isEmpty()) {
+        setLastError(result.error);
+        return;
+    }
+
+    if (!inputInfo) {
+        setLastError("Input info was deleted during generation");
+        return;
+    }
+
+    result.info.coverage_name = generatedName.constData();
+    auto resultInfo = std::make_shared<QtSMSplatGenInfo>(result.info);
+    resultInfo->setIsSavedInDb(false);
+    resultInfo->setImageId(inputInfo->generateImageId());
+
+    QString name = resultInfo->coverageName();
+    updateImageProvider(resultInfo->imageId(), resultInfo->image());
+
+    QString inputName = inputInfo->transmitterName();
+    if (m_inputModel.contains(inputName)) {
+        m_inputModel.updateByName(inputName, inputInfo);
+    } else {
+        m_inputModel.append(inputInfo);
+    }
+
+    if (m_splatModel.contains(name)) {
+        m_splatModel.updateByName(name, resultInfo);
+    } else {
+        m_splatModel.append(resultInfo);
     }
+
+    emit splatGenerated(name);
 }
 
 bool QtSMSplat::save(const QString &name) {
@@ -303,12 +381,34 @@ QtSMSplatInputInfo *QtSMSplat::createInputInfo() {
 }
 
 void QtSMSplat::setBusy(bool busy) {
-    if (m_busy != busy) {
-        m_busy = busy;
+    bool wasBusy = this->busy();
+    m_busy = busy;
+    if (this->busy() != wasBusy) {
+        emit busyChanged();
+    }
+}
+
+void QtSMSplat::setGenerating(bool generating) {
+    bool wasBusy = busy();
+    m_generating = generating;
+    if (busy() != wasBusy) {
         emit busyChanged();
     }
 }
 
+void QtSMSplat::setProgress(Phase phase, double progress) {
+    // Reports queued by a finished generation are stale
+    if (!m_generating && progress > 0.0) {
+        return;
+    }
+
+    if (m_phase != phase || m_progress != progress) {
+        m_phase = phase;
+        m_progress = progress;
+        emit progressChanged();
+    }
+}
+
 void QtSMSplat::setLastError(const QString &error) {
     m_lastError = error;
     if (!error.isEmpty()) {
@@ -4,6 +4,9 @@
 #include <QObject>
 #include <QQmlEngine>
 #include <QSet>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <atomic>
 #include <memory>
 #include "SMSplatDB.h"
 #include "SMSplatListModel.h"
@@ -23,8 +26,14 @@ class QtSMSplat : public QObject {
     Q_PROPERTY(bool busy READ busy NOTIFY busyChanged)
     Q_PROPERTY(QString lastError READ lastError NOTIFY lastErrorChanged)
     Q_PROPERTY(bool isInitialized READ isInitialized NOTIFY initializedChanged)
+    Q_PROPERTY(Phase phase READ phase NOTIFY progressChanged)
+    Q_PROPERTY(double progress READ progress NOTIFY progressChanged)
 
    public:
+    // Stages of generate(), in order (see SMSplatPhase)
+    enum Phase { TerrainPhase, SweepPhase, RenderPhase, ReprojectPhase };
+    Q_ENUM(Phase)
+
     explicit QtSMSplat(QObject *parent = nullptr);
     ~QtSMSplat();
 
@@ -33,9 +42,17 @@ class QtSMSplat : public QObject {
     bool busy() const;
     QString lastError() const;
     bool isInitialized() const;
+    Phase phase() const;
+    double progress() const;
 
     Q_INVOKABLE bool initDatabase(const QString &dbPath);
+    // Starts generating a coverage on a worker thread and returns at
+    // once; false if the input is invalid or a generation is already
+    // running.  Progress is reported by progressChanged(), the result
+    // by splatGenerated(), splatCancelled() or lastErrorChanged().
     Q_INVOKABLE bool generate(QtSMSplatInputInfo *inputInfo);
+    // Stops the running generation at its next check
+    Q_INVOKABLE void cancelGenerate();
     Q_INVOKABLE bool save(const QString &name);
     Q_INVOKABLE QStringList getAvailableSplatsFromDb();
     Q_INVOKABLE bool importFromDb(const QStringList &names);
@@ -64,7 +81,9 @@ class QtSMSplat : public QObject {
     void busyChanged();
     void lastErrorChanged();
     void initializedChanged();
+    void progressChanged();
     void splatGenerated(const QString &name);
+    void splatCancelled(const QString &name);
     void splatSaved(const QString &name);
     void splatDeleted(const QString &name);
     void splatImported(const QStringList &names);
@@ -72,6 +91,12 @@ class QtSMSplat : public QObject {
     void savedInDbChanged();
 
    private:
+    struct GenerateResult {
+        SMSplatGenInfo info{};
+        QString error;  // Empty on success
+        bool cancelled = false;
+    };
+
     SMSplatListModel m_splatModel;
     InputListModel m_inputModel;
     SMSplatDB m_db;
@@ -81,7 +106,18 @@ class QtSMSplat : public QObject {
     bool m_initialized;
     SMSplatImageProvider* m_imageProvider{nullptr};
 
+    QFutureWatcher<GenerateResult> m_generateWatcher;
+    std::shared_ptr<std::atomic<bool>> m_generateCancel;  // Cancels the running generation
+    QPointer<QtSMSplatInputInfo> m_generateInput;  // Input of the running generation
+    QByteArray m_generateName;                     // Its transmitter name
+    bool m_generating{false};
+    Phase m_phase{TerrainPhase};
+    double m_progress{0.0};
+
     void setBusy(bool busy);
+    void setGenerating(bool generating);
+    void setProgress(Phase phase, double progress);
+    void finishGenerate();
     void setLastError(const QString &error);
 };
 
@@ -0,0 +1,69 @@
+#include "antenna_pattern.h"
+
+#include <cmath>
+#include <list>
+#include <mutex>
+#include <sys/stat.h>
+#include <utility>
+
+/* Antennas in use at once are few; each pattern is about 4 MB */
+
+#define ANTENNA_PATTERN_CACHE_ENTRIES 16
+
+namespace {
+
+typedef std::pair<std::string, std::shared_ptr<const AntennaPattern>> Entry;
+
+std::mutex cache_mutex;
+std::list<Entry> cache;  // Most recently used first
+
+}  // namespace
+
+AntennaPattern::AntennaPattern(std::vector<float> amplitude, bool azimuth, bool elevation)
+    : amplitude_(std::move(amplitude)),
+      db_(amplitude_.size()),
+      azimuth_(azimuth),
+      elevation_(elevation) {
+    for (size_t i = 0; i < amplitude_.size(); i++)
+        db_[i] = amplitude_[i] != 0.0f ? 20.0 * log10((double)amplitude_[i]) : 0.0;
+}
+
+std::string AntennaPattern::fileKey(const char *path) {
+    struct stat info;
+
+    if (stat(path, &info) != 0) return "";
+
+    return std::string(path) + ":" + std::to_string((long long)info.st_size) + ":" +
+           std::to_string((long long)info.st_mtime);
+}
+
+std::shared_ptr<const AntennaPattern> AntennaPattern::find(const std::string &key) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    for (auto it = cache.begin(); it != cache.end(); ++it)
+        if (it->first == key) {
+            cache.splice(cache.begin(), cache, it);
+            return cache.front().second;
+        }
+
+    return nullptr;
+}
+
+std::shared_ptr<const AntennaPattern> AntennaPattern::insert(
+    const std::string &key, std::shared_ptr<const AntennaPattern> pattern) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    /* Another processor may have built the same pattern meanwhile */
+
+    for (auto it = cache.begin(); it != cache.end(); ++it)
+        if (it->first == key) {
+            cache.erase(it);
+            break;
+        }
+
+    cache.emplace_front(key, pattern);
+
+    while (cache.size() > ANTENNA_PATTERN_CACHE_ENTRIES) cache.pop_back();
+
+    return pattern;
+}
@@ -0,0 +1,77 @@
+#ifndef ANTENNA_PATTERN_H
+#define ANTENNA_PATTERN_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+  Radiation pattern of a transmitting antenna, tabulated for every
+  degree of azimuth and every tenth of a degree of elevation, both
+  as the normalized field amplitude read from the antenna's files
+  and pre-converted to dB for the path loss.  A pattern is read-only
+  once built, so the one built from an antenna's files is cached
+  process-wide and shared by every job using the same files.
+  Processors without a pattern hold none at all.
+*/
+
+class AntennaPattern {
+   public:
+    static constexpr int AZIMUTHS = 361;     // 0 to 360 degrees, 360 repeating 0
+    static constexpr int ELEVATIONS = 1001;  // +10 (index 0) down to -90 degrees (index 1000)
+
+    AntennaPattern(std::vector<float> amplitude, bool azimuth, bool elevation);
+    // "amplitude" holds AZIMUTHS x ELEVATIONS values, [azimuth][elevation];
+    // "azimuth" and "elevation" tell which patterns were read into it
+
+    float amplitude(int azimuth, int elevation) const {
+        return amplitude_[(size_t)azimuth * ELEVATIONS + elevation];
+    }
+
+    double gain(double azimuth, double elevation) const {
+        // dB gain towards "azimuth" and "elevation" (degrees), interpolated
+        // bilinearly between table entries; 0 above +10 or below -90 degrees.
+        // Next to a zero amplitude, whose dB entry is 0, the nearest entry
+        // is taken, so nulls are not blended with the gain around them
+
+        double row = 10.0 * (10.0 - elevation), col = azimuth;
+
+        if (!(row >= -0.5 && row <= 1000.5)) return 0.0;
+
+        row = row < 0.0 ? 0.0 : (row > 1000.0 ? 1000.0 : row);
+        col = col < 0.0 ? 0.0 : (col > 360.0 ? 360.0 : col);
+
+        int r = row < 999.0 ? (int)row : 999, c = col < 359.0 ? (int)col : 359;
+        double fr = row - r, fc = col - c;
+        const float *a = &amplitude_[(size_t)c * ELEVATIONS + r];
+        const double *db = &db_[(size_t)c * ELEVATIONS + r];
+
+        if (a[0] == 0.0f || a[1] == 0.0f || a[ELEVATIONS] == 0.0f || a[ELEVATIONS + 1] == 0.0f)
+            return db[(fc < 0.5 ? 0 : ELEVATIONS) + (fr < 0.5 ? 0 : 1)];
+
+        return (1.0 - fc) * ((1.0 - fr) * db[0] + fr * db[1]) +
+               fc * ((1.0 - fr) * db[ELEVATIONS] + fr * db[ELEVATIONS + 1]);
+    }
+
+    bool azimuthPattern() const { return azimuth_; }
+    bool elevationPattern() const { return elevation_; }
+
+    static std::string fileKey(const char *path);
+    // Identifies a pattern file by name, size and modification time, or
+    // returns "" if it does not exist
+
+    static std::shared_ptr<const AntennaPattern> find(const std::string &key);
+    // Returns the pattern cached under "key", or nullptr
+
+    static std::shared_ptr<const AntennaPattern> insert(
+        const std::string &key, std::shared_ptr<const AntennaPattern> pattern);
+    // Caches a freshly built pattern, dropping the oldest ones as needed,
+    // and returns it
+
+   private:
+    std::vector<float> amplitude_;
+    std::vector<double> db_;  // 20 log10(amplitude), 0 where the amplitude is 0
+    bool azimuth_, elevation_;
+};
+
+#endif  // ANTENNA_PATTERN_H
@@ -0,0 +1,78 @@
+#ifndef COVERAGE_RASTER_H
+#define COVERAGE_RASTER_H
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/*
+  Per-job coverage state (the mask and signal bytes) of every page
+  in the DEM pool, kept apart from the read-only terrain so terrain
+  tiles can be shared while each job writes only its own raster.
+
+  Every pixel keeps its mask and signal side by side, since the
+  sweeps and the map writers always touch both.  A page is stored
+  as consecutive 16 x 16 pixel blocks rather than row by row, so a
+  radial crossing the page at any angle, or a map row scanning it,
+  stays within a few cache lines per block.
+*/
+
+class CoverageRaster {
+   public:
+    struct Cell {
+        unsigned char mask;
+        unsigned char signal;
+    };
+
+    void reset(int pages) {
+        /* Frees every page, leaving room for "pages" pages */
+
+        pages_.clear();
+        pages_.shrink_to_fit();
+        pages_.resize(pages);
+        ippd_.assign(pages, 0);
+    }
+
+    void allocate(int page, int ippd) {
+        /* Gives "page" a zeroed ippd x ippd raster; throws
+           std::bad_alloc if memory is exhausted. */
+
+        size_t cells = PageCells(ippd);
+
+        if (ippd_[page] != ippd) {
+            ippd_[page] = 0;
+            pages_[page].reset(new Cell[cells]);
+            ippd_[page] = ippd;
+        }
+
+        memset(pages_[page].get(), 0, sizeof(Cell) * cells);
+    }
+
+    void release(int page) {
+        pages_[page].reset();
+        ippd_[page] = 0;
+    }
+
+    Cell &at(int page, int x, int y) const {
+        int blocks = (ippd_[page] + BLOCK - 1) >> BLOCK_SHIFT;
+
+        return pages_[page][((size_t)(x >> BLOCK_SHIFT) * blocks + (y >> BLOCK_SHIFT))
+                                << (2 * BLOCK_SHIFT) |
+                            (x & (BLOCK - 1)) << BLOCK_SHIFT | (y & (BLOCK - 1))];
+    }
+
+   private:
+    static const int BLOCK_SHIFT = 4;
+    static const int BLOCK = 1 << BLOCK_SHIFT;
+
+    static size_t PageCells(int ippd) {
+        size_t blocks = (ippd + BLOCK - 1) >> BLOCK_SHIFT;
+
+        return blocks * blocks * BLOCK * BLOCK;
+    }
+
+    std::vector<std::unique_ptr<Cell[]>> pages_;
+    std::vector<int> ippd_;
+};
+
+#endif  // COVERAGE_RASTER_H
@@ -50,6 +50,43 @@ struct tcomplex
 	double tcimag;
 };
 
+/* Values computed by the d==0 (setup) calls of adiff(), adiff2(),
+   ascat() and alos(), the flags of lrprop()/lrprop2() and the
+   coefficients of avar().  These used to be function statics;
+   keeping them in propa_type/propv_type makes every model call
+   depend only on its own arguments, so paths can be evaluated
+   concurrently. */
+
+struct adiff_type
+{	double wd1, xd1, afo, qk, aht, xht;
+};
+
+struct adiff2_type
+{	double wd1, xd1, qk, aht, xht, toh, toho, roh, roho, dto, dto1, dtro, dro,
+		dro2, drto, dtr, dhh1, dhh2, dtof, dto1f, drof, dro2f;
+};
+
+struct ascat_type
+{	double ad, rr, etq, h0s;
+};
+
+struct alos_type
+{	double wls;
+};
+
+struct lrprop_type
+{	bool wlos, wscat;
+	double dmin, xae;
+};
+
+struct avar_type
+{	int kdv;
+	double dexa, de, vmd, vs0, sgl, sgtm, sgtp, sgtd, tgtd, gm, gp, cv1, cv2,
+		yv1, yv2, yv3, csm1, csm2, ysm1, ysm2, ysm3, csp1, csp2, ysp1, ysp2,
+		ysp3, csd1, zd, cfm1, cfm2, cfm3, cfp1, cfp2, cfp3, dexw;
+	bool ws, w1;
+};
+
 struct prop_type
 {	double aref;
 	double dist;
@@ -90,6 +127,7 @@ struct propv_type
 	int lvar;
 	int mdvar;
 	int klim;
+	avar_type av;
 };
 
 struct propa_type
@@ -105,6 +143,12 @@ struct propa_type
 	double dls[2];
 	double dla;
 	double tha;
+	adiff_type ad;
+	adiff2_type ad2;
+	ascat_type asc;
+	alos_type alo;
+	lrprop_type lrp;
+	lrprop_type lrp2;
 };
 
 int mymin(const int &i, const int &j)
@@ -421,7 +465,8 @@ double saalos(double d, prop_type &prop, propa_type &propa)
 double adiff(double d, prop_type &prop, propa_type &propa)
 {
 	complex<double> prop_zgnd(prop.zgndreal,prop.zgndimag);
-	static double wd1, xd1, afo, qk, aht, xht;
+	double &wd1=propa.ad.wd1, &xd1=propa.ad.xd1, &afo=propa.ad.afo, &qk=propa.ad.qk,
+		&aht=propa.ad.aht, &xht=propa.ad.xht;
 	double a, q, pk, ds, th, wa, ar, wd, adiffv;
 
 	if (d==0)
@@ -478,8 +523,12 @@ double adiff(double d, prop_type &prop, propa_type &propa)
 double adiff2(double d, prop_type &prop, propa_type &propa)
 {
 	complex<double> prop_zgnd(prop.zgndreal,prop.zgndimag);
-	static double wd1, xd1, qk, aht, xht, toh, toho, roh, roho, dto, dto1, dtro, dro, 
-	dro2, drto, dtr, dhh1, dhh2, /* dhec, */ dtof, dto1f, drof, dro2f;
+	double &wd1=propa.ad2.wd1, &xd1=propa.ad2.xd1, &qk=propa.ad2.qk, &aht=propa.ad2.aht,
+		&xht=propa.ad2.xht, &toh=propa.ad2.toh, &toho=propa.ad2.toho, &roh=propa.ad2.roh,
+		&roho=propa.ad2.roho, &dto=propa.ad2.dto, &dto1=propa.ad2.dto1, &dtro=propa.ad2.dtro,
+		&dro=propa.ad2.dro, &dro2=propa.ad2.dro2, &drto=propa.ad2.drto, &dtr=propa.ad2.dtr,
+		&dhh1=propa.ad2.dhh1, &dhh2=propa.ad2.dhh2, &dtof=propa.ad2.dtof,
+		&dto1f=propa.ad2.dto1f, &drof=propa.ad2.drof, &dro2f=propa.ad2.dro2f;
 	double a, q, pk, rd, ds, dsl, /* dfdh, */ th, wa, /* ar, wd, sf1, */ sf2, /* ec, */ vv, kedr=0.0, arp=0.0,
 	sdr=0.0, pd=0.0, srp=0.0, kem=0.0, csd=0.0, sdl=0.0, adiffv2=0.0, closs=0.0;
 
@@ -754,7 +803,7 @@ double adiff2(double d, prop_type &prop, propa_type &propa)
 
 double ascat( double d, prop_type &prop, propa_type &propa)
 {
-	static double ad, rr, etq, h0s;
+	double &ad=propa.asc.ad, &rr=propa.asc.rr, &etq=propa.asc.etq, &h0s=propa.asc.h0s;
 	double h0, r1, r2, z0, ss, et, ett, th, q;
 	double ascatv, temp;
 
@@ -872,7 +921,7 @@ void qlrps(double fmhz, double zsys, double en0, int ipol, double eps, double sg
 double alos(double d, prop_type &prop, propa_type &propa)
 {
 	complex<double> prop_zgnd(prop.zgndreal,prop.zgndimag);
-	static double wls;
+	double &wls=propa.alo.wls;
 	complex<double> r;
 	double s, sps, q;
 	double alosv;
@@ -1054,8 +1103,8 @@ void qlra(int kst[], int klimx, int mdvarx, prop_type &prop, propv_type &propv)
 void lrprop (double d, prop_type &prop, propa_type &propa)
 {
 	/* PaulM_lrprop used for ITM */
-	static bool wlos, wscat;
-	static double dmin, xae;
+	bool &wlos=propa.lrp.wlos, &wscat=propa.lrp.wscat;
+	double &dmin=propa.lrp.dmin, &xae=propa.lrp.xae;
 	complex<double> prop_zgnd(prop.zgndreal,prop.zgndimag);
 	double a0, a1, a2, a3, a4, a5, a6;
 	double d0, d1, d2, d3, d4, d5, d6;
@@ -1234,8 +1283,8 @@ void lrprop (double d, prop_type &prop, propa_type &propa)
 void lrprop2(double d, prop_type &prop, propa_type &propa)
 {
 	/* ITWOM_lrprop2 */
-	static bool wlos, wscat;
-	static double dmin, xae;
+	bool &wlos=propa.lrp2.wlos, &wscat=propa.lrp2.wscat;
+	double &dmin=propa.lrp2.dmin, &xae=propa.lrp2.xae;
 	complex<double> prop_zgnd(prop.zgndreal,prop.zgndimag);
 	double pd1;	
 	double a0, a1, a2, a3, a4, a5, a6, iw;
@@ -1502,11 +1551,16 @@ double curve (double const &c1, double const &c2, double const &x1,
 
 double avar(double zzt, double zzl, double zzc, prop_type &prop, propv_type &propv)
 {
-	static	int kdv;
-	static	double dexa, de, vmd, vs0, sgl, sgtm, sgtp, sgtd, tgtd,
-		gm, gp, cv1, cv2, yv1, yv2, yv3, csm1, csm2, ysm1, ysm2,
-		ysm3, csp1, csp2, ysp1, ysp2, ysp3, csd1, zd, cfm1, cfm2,
-		cfm3, cfp1, cfp2, cfp3;
+	int &kdv=propv.av.kdv;
+	double &dexa=propv.av.dexa, &de=propv.av.de, &vmd=propv.av.vmd, &vs0=propv.av.vs0,
+		&sgl=propv.av.sgl, &sgtm=propv.av.sgtm, &sgtp=propv.av.sgtp, &sgtd=propv.av.sgtd,
+		&tgtd=propv.av.tgtd, &gm=propv.av.gm, &gp=propv.av.gp, &cv1=propv.av.cv1,
+		&cv2=propv.av.cv2, &yv1=propv.av.yv1, &yv2=propv.av.yv2, &yv3=propv.av.yv3,
+		&csm1=propv.av.csm1, &csm2=propv.av.csm2, &ysm1=propv.av.ysm1, &ysm2=propv.av.ysm2,
+		&ysm3=propv.av.ysm3, &csp1=propv.av.csp1, &csp2=propv.av.csp2, &ysp1=propv.av.ysp1,
+		&ysp2=propv.av.ysp2, &ysp3=propv.av.ysp3, &csd1=propv.av.csd1, &zd=propv.av.zd,
+		&cfm1=propv.av.cfm1, &cfm2=propv.av.cfm2, &cfm3=propv.av.cfm3, &cfp1=propv.av.cfp1,
+		&cfp2=propv.av.cfp2, &cfp3=propv.av.cfp3, &dexw=propv.av.dexw;
 
 	double bv1[7]={-9.67,-0.62,1.26,-9.21,-0.62,-0.39,3.15};
 	double bv2[7]={12.7,9.19,15.5,9.05,9.19,2.86,857.9};
@@ -1531,7 +1585,7 @@ double avar(double zzt, double zzl, double zzc, prop_type &prop, propv_type &pro
 	double bfp1[7]={1.0,0.93,1.0,0.93,0.93,1.0,1.0};
 	double bfp2[7]={0.0,0.31,0.0,0.19,0.31,0.0,0.0};
 	double bfp3[7]={0.0,2.00,0.0,1.79,2.00,0.0,0.0};
-	static bool ws, w1;
+	bool &ws=propv.av.ws, &w1=propv.av.w1;
 	double rt=7.8, rl=24.0, avarv, q, vs, zt, zl, zc;
 	double sgt, yr, temp1, temp2;
 	int temp_klim=propv.klim-1;
@@ -1598,9 +1652,10 @@ double avar(double zzt, double zzl, double zzc, prop_type &prop, propv_type &pro
 
 			gm=cfm1+cfm2/((cfm3*q*cfm3*q)+1.0);
 			gp=cfp1+cfp2/((cfp3*q*cfp3*q)+1.0);
+			dexw=pow((575.7e12/prop.wn),THIRD);
 
 			case 2:
-			dexa=sqrt(18e6*prop.he[0])+sqrt(18e6*prop.he[1])+pow((575.7e12/prop.wn),THIRD);
+			dexa=sqrt(18e6*prop.he[0])+sqrt(18e6*prop.he[1])+dexw;
 
 			case 1:
 			if (prop.dist<dexa)
@@ -1707,6 +1762,152 @@ double avar(double zzt, double zzl, double zzc, prop_type &prop, propv_type &pro
 }
 
 
+#define ITM_PROFILE_BLOCK 32
+
+struct itm_horizon_type
+{	/* The transmitter horizon of a profile, carried from one
+	   receiver to the next as they move outward along it.  The
+	   horizon of a prefix is its point j at the highest angle
+	   (z[j+2]-za)/(j*xi)-qc*j*xi, and qc depends on the prefix
+	   (through zsys), so each point is kept as a line in qc.
+	   hull[0..size-1] are the points whose lines make up the upper
+	   envelope of those of points 1..added-1, in order; hull needs
+	   room for every point of the profile.  Start with added=0. */
+	int *hull;
+	int size;
+	int added;
+	double xi, za;		/* Spacing and transmitter height of the lines */
+};
+
+struct itm_profile_type
+{	/* Summaries of the profile points z[2], z[3], ... of an elev[]
+	   array, so point_to_point_ITM() and point_to_point() can be
+	   evaluated on every prefix of one profile, as the receiver
+	   moves outward, without rescanning the whole prefix each
+	   time.  sz[j] and sjz[j] are the sums of z[i+2] and i*z[i+2]
+	   over i<j, and hmax[k] is the highest of points
+	   k*ITM_PROFILE_BLOCK up to (k+1)*ITM_PROFILE_BLOCK-1.
+	   horizon, if not NULL, carries the transmitter horizon
+	   between prefixes, which then have to be taken in order. */
+	const double *sz;
+	const double *sjz;
+	const double *hmax;
+	itm_horizon_type *horizon;
+};
+
+void itm_profile_prepare(const double z[], int np, double sz[], double sjz[], double hmax[])
+{
+	/* Summarizes profile points 0..np of z[] into sz[0..np+1],
+	   sjz[0..np+1] and hmax[0..np/ITM_PROFILE_BLOCK] */
+	sz[0]=0.0;
+	sjz[0]=0.0;
+
+	for (int i=0; i<=np; i++)
+	{
+		sz[i+1]=sz[i]+z[i+2];
+		sjz[i+1]=sjz[i]+i*z[i+2];
+
+		if (i%ITM_PROFILE_BLOCK==0 || z[i+2]>hmax[i/ITM_PROFILE_BLOCK])
+			hmax[i/ITM_PROFILE_BLOCK]=z[i+2];
+	}
+}
+
+int itm_horizon_find(itm_horizon_type &horizon, const double pfl[], double za, double qc, double &the)
+{
+	/* Brings "horizon" up to points 1..np-1 of pfl[], starting
+	   afresh if it holds points beyond them or was built for
+	   another transmitter height, and returns the first of them
+	   at the highest angle, that angle in "the".  Returns 0 if
+	   there are no such points.  Lines built at another spacing
+	   are compared at qc scaled to it, which orders them as at
+	   pfl[1] itself. */
+	int np, j, a, b, c, lo, hi, mid, best;
+	double xi, za0, ba, bb, bc, x, s, t;
+	int *hull=horizon.hull;
+
+	np=(int)pfl[0];
+	xi=pfl[1];
+
+	if (horizon.added<1 || horizon.added>np || za!=horizon.za)
+	{
+		horizon.size=0;
+		horizon.added=1;
+		horizon.xi=xi;
+		horizon.za=za;
+	}
+
+	za0=horizon.za;
+
+	/* Lines have decreasing slopes -j*xi, so a new one ends the
+	   envelope, and hides those it passes over where they meet
+	   their neighbours */
+
+	for (c=horizon.added; c<np; c++)
+	{
+		bc=(pfl[c+2]-za0)/(c*horizon.xi);
+
+		while (horizon.size>=2)
+		{
+			a=hull[horizon.size-2];
+			b=hull[horizon.size-1];
+			ba=(pfl[a+2]-za0)/(a*horizon.xi);
+			bb=(pfl[b+2]-za0)/(b*horizon.xi);
+
+			if ((bc-bb)*(b-a)<(bb-ba)*(c-b))
+				break;
+
+			horizon.size--;
+		}
+
+		hull[horizon.size++]=c;
+	}
+
+	horizon.added=mymax(horizon.added,np);
+
+	if (horizon.size==0)
+		return 0;
+
+	/* The envelope's first line at or below qc where it meets the
+	   next one is the highest there */
+
+	x=qc*(xi/horizon.xi)*(xi/horizon.xi);
+	lo=0;
+	hi=horizon.size-1;
+
+	while (lo<hi)
+	{
+		mid=(lo+hi)/2;
+		a=hull[mid];
+		b=hull[mid+1];
+		ba=(pfl[a+2]-za0)/(a*horizon.xi);
+		bb=(pfl[b+2]-za0)/(b*horizon.xi);
+
+		if (x*((b-a)*horizon.xi)>=bb-ba)
+			hi=mid;
+		else
+			lo=mid+1;
+	}
+
+	/* Settle near-ties between neighbours by the angles themselves */
+
+	best=0;
+
+	for (mid=mymax(lo-1,0); mid<=mymin(lo+1,horizon.size-1); mid++)
+	{
+		j=hull[mid];
+		s=j*xi;
+		t=(pfl[j+2]-za)/s-qc*s;
+
+		if (best==0 || t>the)
+		{
+			the=t;
+			best=j;
+		}
+	}
+
+	return best;
+}
+
 void hzns(double pfl[], prop_type &prop)
 {	
 	/* Used only with ITM 1.2.2 */
@@ -1760,7 +1961,206 @@ void hzns(double pfl[], prop_type &prop)
 }
  
 
-void hzns2(double pfl[], prop_type &prop, propa_type &propa)
+int hzns_tx(double pfl[], double za, double qc, const itm_profile_type *sums, double &the)
+{
+	/* The first of points 1..np-1 of pfl[] at the highest angle
+	   from the transmitter, if above "the", which it is then set
+	   to; otherwise 0.  The angle of point j is compared at j*xi.
+	   Without a carried horizon, each block of points whose
+	   highest point could not be above "the" is skipped. */
+	int np, i, j, k, last, j0=0;
+	double xi, s, t, bound;
+
+	np=(int)pfl[0];
+	xi=pfl[1];
+
+	if (sums->horizon!=NULL)
+	{
+		j=itm_horizon_find(*sums->horizon,pfl,za,qc,t);
+
+		if (j>0 && t>the)
+		{
+			the=t;
+			j0=j;
+		}
+
+		return j0;
+	}
+
+	for (i=1; i<np; i=last+1)
+	{
+		k=i/ITM_PROFILE_BLOCK;
+		last=mymin((k+1)*ITM_PROFILE_BLOCK-1,np-1);
+		t=sums->hmax[k]-za;
+		bound=(t>=0.0 ? t/(i*xi) : t/(last*xi))-qc*i*xi;
+
+		if (bound<=the)
+			continue;
+
+		for (j=i; j<=last; j++)
+		{
+			s=j*xi;
+			t=(pfl[j+2]-za)/s-qc*s;
+
+			if (t>the)
+			{
+				the=t;
+				j0=j;
+			}
+		}
+	}
+
+	return j0;
+}
+
+int hzns_rx(double pfl[], double zb, double qc, const itm_profile_type *sums, double &the, bool nearest)
+{
+	/* The point of 1..np-1 of pfl[] at the highest angle from the
+	   receiver, if above "the", which it is then set to; otherwise
+	   0.  Of points at the same angle, the nearest to the receiver
+	   is taken if "nearest" is set, else the farthest.  The angle
+	   of point j is compared at dist-j*xi.  Points are taken back
+	   from the receiver, skipping each block of points whose
+	   highest point could not be above "the". */
+	int np, i, j, k, last, j1=0;
+	double xi, dist, s, t, bound;
+
+	np=(int)pfl[0];
+	xi=pfl[1];
+	dist=pfl[0]*pfl[1];
+
+	for (k=(np-1)/ITM_PROFILE_BLOCK; k>=0; k--)
+	{
+		i=mymax(k*ITM_PROFILE_BLOCK,1);
+		last=mymin((k+1)*ITM_PROFILE_BLOCK-1,np-1);
+		t=sums->hmax[k]-zb;
+		s=dist-last*xi;
+		bound=(t>=0.0 ? t/s : t/(dist-i*xi))-qc*s;
+
+		if (bound<the || (bound==the && (nearest || j1==0)))
+			continue;
+
+		for (j=last; j>=i; j--)
+		{
+			s=dist-j*xi;
+			t=(pfl[j+2]-zb)/s-qc*s;
+
+			if (t>the || (t==the && !nearest && j1>0))
+			{
+				the=t;
+				j1=j;
+			}
+		}
+	}
+
+	return j1;
+}
+
+void hzns(double pfl[], prop_type &prop, const itm_profile_type *sums)
+{
+	/* hzns() for a prefix of the profile summarized by "sums",
+	   if given.  A point is above the line of sight from the
+	   transmitter exactly when it is above that from the
+	   receiver, so the receiver horizon is only looked for once
+	   the transmitter's is found.  The horizon distances are
+	   accumulated the way hzns() does, as z1sq1() truncates them
+	   to whole points. */
+	int np, j, j0, j1;
+	double xi, za, zb, qc, q, s;
+
+	if (sums==NULL)
+	{
+		hzns(pfl,prop);
+		return;
+	}
+
+	np=(int)pfl[0];
+	xi=pfl[1];
+	za=pfl[2]+prop.hg[0];
+	zb=pfl[np+2]+prop.hg[1];
+	qc=0.5*prop.gme;
+	q=qc*prop.dist;
+	prop.the[1]=(zb-za)/prop.dist;
+	prop.the[0]=prop.the[1]-q;
+	prop.the[1]=-prop.the[1]-q;
+	prop.dl[0]=prop.dist;
+	prop.dl[1]=prop.dist;
+
+	j0=hzns_tx(pfl,za,qc,sums,prop.the[0]);
+
+	if (j0==0)
+		return;
+
+	for (j=0, s=0.0; j<j0; j++)
+		s+=xi;
+
+	prop.dl[0]=s;
+	j1=hzns_rx(pfl,zb,qc,sums,prop.the[1],false);
+
+	if (j1>0)
+	{
+		for (j=0, s=prop.dist; j<j1; j++)
+			s-=xi;
+
+		prop.dl[1]=s;
+	}
+}
+
+bool hzns2(double pfl[], prop_type &prop, const itm_profile_type *sums, double za, double zb, double qc)
+{
+	/* The horizons hzns2() finds, from the profile summarized by
+	   "sums".  The receiver horizon is the nearest to the
+	   receiver of the points at its highest angle.  Returns false,
+	   leaving prop alone, if either angle is steep enough to be
+	   clamped, which changes the points hzns2() goes on to find. */
+	int np, j, j0, j1;
+	double xi, the0, the1, s;
+
+	np=(int)pfl[0];
+	xi=pfl[1];
+	the0=prop.the[0];
+	the1=prop.the[1];
+
+	if (the1<-1.568)
+		return false;
+
+	j0=hzns_tx(pfl,za,qc,sums,the0);
+
+	if (j0==0)
+		return true;
+
+	if (the0>1.569)
+		return false;
+
+	j1=hzns_rx(pfl,zb,qc,sums,the1,true);
+
+	if (the1>1.57)
+		return false;
+
+	prop.los=0;
+
+	for (j=0, s=0.0; j<j0; j++)
+		s+=xi;
+
+	prop.dl[0]=s;
+	prop.hht=pfl[j0+2];
+
+	if (j1>0)
+	{
+		for (j=np, s=prop.dist; j>j1; j--)
+			s-=xi;
+
+		prop.dl[1]=mymax(0.0,prop.dist-s);
+		prop.hhr=pfl[j1+2];
+	}
+
+	prop.the[0]=atan((prop.hht-za)/prop.dl[0])-0.5*prop.gme*prop.dl[0];
+	prop.the[1]=atan((prop.hhr-zb)/prop.dl[1])-0.5*prop.gme*prop.dl[1];
+
+	return true;
+}
+
+void hzns2(double pfl[], prop_type &prop, propa_type &propa, const itm_profile_type *sums=NULL)
 {
 	bool wq;
 	int np, rp, i, j;
@@ -1784,7 +2184,7 @@ void hzns2(double pfl[], prop_type &prop, propa_type &propa)
 	prop.hhr=0.0;
 	prop.los=1;
     	
-	if(np>=2)
+	if(np>=2 && !(sums!=NULL && hzns2(pfl,prop,sums,za,zb,qc)))
 	{
 		sa=0.0;
 		sb=prop.dist;
@@ -1888,6 +2288,52 @@ void z1sq1 (double z[], const double &x1, const double &x2, double& z0, double&
 	zn=a+b*(xn-xb);
 }
 
+void z1sq1(const itm_profile_type *sums, double z[], const double &x1, const double &x2, double& z0, double& zn)
+{
+	/* z1sq1() taking the sums of its least squares fit from the
+	   summaries of the profile, if given, rather than a loop */
+	double xn, xa, xb, x, a, b, sum;
+	int n, ja, jb;
+
+	if (sums==NULL)
+	{
+		z1sq1(z,x1,x2,z0,zn);
+		return;
+	}
+
+	xn=z[0];
+	xa=int(FORTRAN_DIM(x1/z[1],0.0));
+	xb=xn-int(FORTRAN_DIM(xn,x2/z[1]));
+
+	if (xb<=xa)
+	{
+		xa=FORTRAN_DIM(xa,1.0);
+		xb=xn-FORTRAN_DIM(xn,xb+1.0);
+	}
+
+	ja=(int)xa;
+	jb=(int)xb;
+	n=jb-ja;
+	xa=xb-xa;
+	x=-0.5*xa;
+	xb+=x;
+	a=0.5*(z[ja+2]+z[jb+2]);
+	b=0.5*(z[ja+2]-z[jb+2])*x;
+
+	if (n>=2)
+	{
+		/* Points ja+1 .. jb-1, weighted by x-ja+i */
+		sum=sums->sz[jb]-sums->sz[ja+1];
+		a+=sum;
+		b+=sums->sjz[jb]-sums->sjz[ja+1]+(x-ja)*sum;
+	}
+
+	a/=xa;
+	b=b*12.0/((xa*xa+2.0)*xa);
+	z0=a-b*xb;
+	zn=a+b*(xn-xb);
+}
+
 void z1sq2(double z[], const double &x1, const double &x2, double& z0, double& zn)
 {
 	/* corrected for use with ITWOM */
@@ -2134,14 +2580,14 @@ double d1thx2(double pfl[], const double &x1, const double &x2, propa_type &prop
 }
 
 
-void qlrpfl(double pfl[], int klimx, int mdvarx, prop_type &prop, propa_type &propa, propv_type &propv)
+void qlrpfl(double pfl[], int klimx, int mdvarx, prop_type &prop, propa_type &propa, propv_type &propv, const itm_profile_type *sums=NULL)
 {
 	int np, j;
 	double xl[2], q, za, zb, temp;
 
 	prop.dist=pfl[0]*pfl[1];
 	np=(int)pfl[0];
-	hzns(pfl,prop);
+	hzns(pfl,prop,sums);
 
 	for (j=0; j<2; j++)
 		xl[j]=mymin(15.0*prop.hg[j],0.1*prop.dl[j]);
@@ -2151,7 +2597,7 @@ void qlrpfl(double pfl[], int klimx, int mdvarx, prop_type &prop, propa_type &pr
 
 	if (prop.dl[0]+prop.dl[1]>1.5*prop.dist)
 	{
-		z1sq1(pfl,xl[0],xl[1],za,zb);
+		z1sq1(sums,pfl,xl[0],xl[1],za,zb);
 		prop.he[0]=prop.hg[0]+FORTRAN_DIM(pfl[2],za);
 		prop.he[1]=prop.hg[1]+FORTRAN_DIM(pfl[np+2],zb);
 
@@ -2182,8 +2628,8 @@ void qlrpfl(double pfl[], int klimx, int mdvarx, prop_type &prop, propa_type &pr
 
 	else
 	{
-		z1sq1(pfl,xl[0],0.9*prop.dl[0],za,q);
-		z1sq1(pfl,prop.dist-0.9*prop.dl[1],xl[1],q,zb);
+		z1sq1(sums,pfl,xl[0],0.9*prop.dl[0],za,q);
+		z1sq1(sums,pfl,prop.dist-0.9*prop.dl[1],xl[1],q,zb);
 		prop.he[0]=prop.hg[0]+FORTRAN_DIM(pfl[2],za);
 		prop.he[1]=prop.hg[1]+FORTRAN_DIM(pfl[np+2],zb);
 	}
@@ -2206,14 +2652,14 @@ void qlrpfl(double pfl[], int klimx, int mdvarx, prop_type &prop, propa_type &pr
 	lrprop(0.0,prop,propa);
 }
 
-void qlrpfl2(double pfl[], int klimx, int mdvarx, prop_type &prop, propa_type &propa, propv_type &propv)
+void qlrpfl2(double pfl[], int klimx, int mdvarx, prop_type &prop, propa_type &propa, propv_type &propv, const itm_profile_type *sums=NULL)
 {
 	int np, j;
 	double xl[2], dlb, q, za, zb, temp, rad, rae1, rae2;
 
 	prop.dist=pfl[0]*pfl[1];
 	np=(int)pfl[0];
-	hzns2(pfl,prop, propa);
+	hzns2(pfl,prop,propa,sums);
 	dlb=prop.dl[0]+prop.dl[1];
 	prop.rch[0]=prop.hg[0]+pfl[2];
 	prop.rch[1]=prop.hg[1]+pfl[np+2];
@@ -2319,12 +2765,79 @@ double deg2rad(double d)
 	return d*3.1415926535897/180.0;
 }
 
+struct itm_session_type
+{	/* Everything point_to_point_ITM() and point_to_point() derive
+	   from the radio and climate parameters alone, which stay the
+	   same for every path of a coverage.  itm_session_prepare()
+	   finds them once; the models then only work out what depends
+	   on the profile itself. */
+	double wn;			/* Wave number, from qlrps() */
+	double zgndreal, zgndimag;	/* Surface transfer impedance, from qlrps() */
+	double zc, zr;			/* qerfi(conf), qerfi(rel) */
+	double fs;			/* Frequency term of the free space loss */
+	propv_type itm_propv;		/* avar() set up through level 3 for the ITM */
+	propv_type itwom_propv;		/* ... and for ITWOM */
+	int itm_kwx, itwom_kwx;		/* Warnings avar() raised doing so */
+};
+
+void itm_session_propv(const itm_session_type &session, int radio_climate, int mdvar, propv_type &propv, int &kwx)
+{
+	/* Runs the parts of avar() that depend on neither the
+	   profile nor the antennas, leaving propv.av ready for
+	   avar() calls at propv.lvar=2 */
+	prop_type prop;
+
+	memset(&prop,0,sizeof(prop));
+	memset(&propv,0,sizeof(propv));
+	prop.wn=session.wn;
+	propv.klim=radio_climate;
+	propv.mdvar=mdvar;
+	propv.lvar=5;
+	avar(0.0,0.0,0.0,prop,propv);
+	kwx=prop.kwx;
+}
+
+void itm_session_prepare(double eps_dielect, double sgm_conductivity, double frq_mhz, int radio_climate, int pol, double conf, double rel, itm_session_type &session)
+{
+	/* Fills in "session" for the given parameters, as
+	   passed to point_to_point_ITM() and point_to_point() */
+	prop_type prop;
+
+	memset(&prop,0,sizeof(prop));
+	qlrps(frq_mhz,0.0,301.0,pol,eps_dielect,sgm_conductivity,prop);
+	session.wn=prop.wn;
+	session.zgndreal=prop.zgndreal;
+	session.zgndimag=prop.zgndimag;
+	session.zc=qerfi(conf);
+	session.zr=qerfi(rel);
+	session.fs=32.45+20.0*log10(frq_mhz);
+	itm_session_propv(session,radio_climate,12,session.itm_propv,session.itm_kwx);
+	itm_session_propv(session,radio_climate,1,session.itwom_propv,session.itwom_kwx);
+}
+
+void qlrps(const itm_session_type &session, double zsys, double en0, prop_type &prop)
+{
+	/* qlrps() taking the frequency and ground constants
+	   from "session" */
+	double gma=157e-9;
+
+	prop.wn=session.wn;
+	prop.ens=en0;
+
+	if (zsys!=0.0)
+		prop.ens*=exp(-zsys/9460.0);
+
+	prop.gme=gma*(1.0-0.04665*exp(prop.ens/179.3));
+	prop.zgndreal=session.zgndreal;
+	prop.zgndimag=session.zgndimag;
+}
+
 //***************************************************************************************
 //* Point-To-Point Mode Calculations 
 //***************************************************************************************
 
 
-void point_to_point_ITM(double elev[], double tht_m, double rht_m, double eps_dielect, double sgm_conductivity, double eno_ns_surfref, double frq_mhz, int radio_climate, int pol, double conf, double rel, double &dbloss, char *strmode, int &errnum)
+void point_to_point_ITM(double elev[], double tht_m, double rht_m, double eps_dielect, double sgm_conductivity, double eno_ns_surfref, double frq_mhz, int radio_climate, int pol, double conf, double rel, double &dbloss, char *strmode, int &errnum, const itm_profile_type *sums=NULL, const itm_session_type *session=NULL)
 
 /******************************************************************************
 
@@ -2344,6 +2857,15 @@ Note that point_to_point has become point_to_point_ITM for use as the old ITM
 	elev[]: [num points - 1], [delta dist(meters)],
 	        [height(meters) point 1], ..., [height(meters) point n]
 
+	sums:   NULL, or the summaries of a longer profile that
+	        elev[] is a prefix of (see itm_profile_type); the
+	        results then differ from the direct ones by rounding.
+
+	session: NULL, or the constants itm_session_prepare() found
+	        for eps_dielect, sgm_conductivity, frq_mhz,
+	        radio_climate, pol, conf and rel, which are then
+	        not looked at again.
+
 	errnum: 0- No Error.
 		1- Warning: Some parameters are nearly out of range.
 		            Results should be used with caution.
@@ -2368,12 +2890,25 @@ Note that point_to_point has become point_to_point_ITM for use as the old ITM
 
 	prop.hg[0]=tht_m;
 	prop.hg[1]=rht_m;
-	propv.klim=radio_climate;
-	prop.kwx=0;
-	propv.lvar=5;
 	prop.mdp=-1;
-	zc=qerfi(conf);
-	zr=qerfi(rel);
+
+	if (session!=NULL)
+	{
+		propv=session->itm_propv;
+		prop.kwx=session->itm_kwx;
+		zc=session->zc;
+		zr=session->zr;
+	}
+
+	else
+	{
+		propv.klim=radio_climate;
+		prop.kwx=0;
+		propv.lvar=5;
+		zc=qerfi(conf);
+		zr=qerfi(rel);
+	}
+
 	np=(long)elev[0];
 	/* dkm=(elev[1]*elev[0])/1000.0; */
 	/* xkm=elev[1]/1000.0; */
@@ -2386,17 +2921,33 @@ Note that point_to_point has become point_to_point_ITM for use as the old ITM
 		ja=(long)(3.0+0.1*elev[0]);  /* added (long) to correct */
 		jb=np-ja+6;
 
-		for (i=ja-1; i<jb; ++i)
-			zsys+=elev[i];
+		if (sums!=NULL)
+			zsys=sums->sz[jb-2]-sums->sz[ja-3];
+		else
+			for (i=ja-1; i<jb; ++i)
+				zsys+=elev[i];
 
 		zsys/=(jb-ja+1);
 		q=eno;
 	}
 
-	propv.mdvar=12;
-	qlrps(frq_mhz,zsys,q,pol,eps_dielect,sgm_conductivity,prop);
-	qlrpfl(elev,propv.klim,propv.mdvar,prop,propa,propv);
-	fs=32.45+20.0*log10(frq_mhz)+20.0*log10(prop.dist/1000.0);
+	if (session!=NULL)
+	{
+		/* avar() has nothing to redo above level 2 */
+		qlrps(*session,zsys,q,prop);
+		qlrpfl(elev,propv.klim,propv.mdvar,prop,propa,propv,sums);
+		propv.lvar=2;
+		fs=session->fs+20.0*log10(prop.dist/1000.0);
+	}
+
+	else
+	{
+		propv.mdvar=12;
+		qlrps(frq_mhz,zsys,q,pol,eps_dielect,sgm_conductivity,prop);
+		qlrpfl(elev,propv.klim,propv.mdvar,prop,propa,propv,sums);
+		fs=32.45+20.0*log10(frq_mhz)+20.0*log10(prop.dist/1000.0);
+	}
+
 	q=prop.dist-propa.dla;
 
 	if (int(q)<0.0)
@@ -2422,7 +2973,7 @@ Note that point_to_point has become point_to_point_ITM for use as the old ITM
 
 
 
-void point_to_point(double elev[], double tht_m, double rht_m, double eps_dielect, double sgm_conductivity, double eno_ns_surfref, double frq_mhz, int radio_climate, int pol, double conf, double rel, double &dbloss, char *strmode, int &errnum)
+void point_to_point(double elev[], double tht_m, double rht_m, double eps_dielect, double sgm_conductivity, double eno_ns_surfref, double frq_mhz, int radio_climate, int pol, double conf, double rel, double &dbloss, char *strmode, int &errnum, const itm_profile_type *sums=NULL, const itm_session_type *session=NULL)
 
 /******************************************************************************
 
@@ -2466,6 +3017,16 @@ void point_to_point(double elev[], double tht_m, double rht_m, double eps_dielec
 				(ranges from 250 for dry, hot day to 450 on hot, humid day]
 				(stabilizes near 301 in cold, clear weather)
 
+	sums:   NULL, or the summaries of a longer profile that
+	        elev[] is a prefix of (see itm_profile_type), which
+	        find zsys and the horizons; the terrain roughness is
+	        still taken from elev[] itself.
+
+	session: NULL, or the constants itm_session_prepare() found
+	        for eps_dielect, sgm_conductivity, frq_mhz,
+	        radio_climate, pol, conf and rel, which are then
+	        not looked at again.
+
 	errnum: 0- No Error.
 		1- Warning: Some parameters are nearly out of range.
 		            Results should be used with caution.
@@ -2491,15 +3052,28 @@ void point_to_point(double elev[], double tht_m, double rht_m, double eps_dielec
 
 	prop.hg[0]=tht_m;
 	prop.hg[1]=rht_m;
-	propv.klim=radio_climate;
-	prop.kwx=0;
-	propv.lvar=5;
 	prop.mdp=-1;
 	prop.ptx=pol;
 	prop.thera=0.0;
 	prop.thenr=0.0;
-	zc=qerfi(conf);
-	zr=qerfi(rel);
+
+	if (session!=NULL)
+	{
+		propv=session->itwom_propv;
+		prop.kwx=session->itwom_kwx;
+		zc=session->zc;
+		zr=session->zr;
+	}
+
+	else
+	{
+		propv.klim=radio_climate;
+		prop.kwx=0;
+		propv.lvar=5;
+		zc=qerfi(conf);
+		zr=qerfi(rel);
+	}
+
 	np=(long)elev[0];
 	/* dkm=(elev[1]*elev[0])/1000.0; */
 	/* xkm=elev[1]/1000.0; */
@@ -2522,18 +3096,34 @@ void point_to_point(double elev[], double tht_m, double rht_m, double eps_dielec
 		ja=(long)(3.0+0.1*elev[0]);  
 		jb=np-ja+6;
 
-		for (i=ja-1; i<jb; ++i)
-			zsys+=elev[i];
+		if (sums!=NULL)
+			zsys=sums->sz[jb-2]-sums->sz[ja-3];
+		else
+			for (i=ja-1; i<jb; ++i)
+				zsys+=elev[i];
 
 		zsys/=(jb-ja+1);
 		q=eno;
 	}
 
-	propv.mdvar=mode_var;
-	qlrps(frq_mhz,zsys,q,pol,eps_dielect,sgm_conductivity,prop);
-	qlrpfl2(elev,propv.klim,propv.mdvar,prop,propa,propv);
-	tpd=sqrt((prop.he[0]-prop.he[1])*(prop.he[0]-prop.he[1])+(prop.dist)*(prop.dist));
-	fs=32.45+20.0*log10(frq_mhz)+20.0*log10(tpd/1000.0);	
+	if (session!=NULL)
+	{
+		/* avar() has nothing to redo above level 2 */
+		qlrps(*session,zsys,q,prop);
+		qlrpfl2(elev,propv.klim,propv.mdvar,prop,propa,propv,sums);
+		propv.lvar=2;
+		tpd=sqrt((prop.he[0]-prop.he[1])*(prop.he[0]-prop.he[1])+(prop.dist)*(prop.dist));
+		fs=session->fs+20.0*log10(tpd/1000.0);
+	}
+
+	else
+	{
+		propv.mdvar=mode_var;
+		qlrps(frq_mhz,zsys,q,pol,eps_dielect,sgm_conductivity,prop);
+		qlrpfl2(elev,propv.klim,propv.mdvar,prop,propa,propv,sums);
+		tpd=sqrt((prop.he[0]-prop.he[1])*(prop.he[0]-prop.he[1])+(prop.dist)*(prop.dist));
+		fs=32.45+20.0*log10(frq_mhz)+20.0*log10(tpd/1000.0);
+	}
 	q=prop.dist-propa.dla;	
 			
 	if (int(q)<0.0)
@@ -2563,6 +3153,105 @@ void point_to_point(double elev[], double tht_m, double rht_m, double eps_dielec
 }
 
 
+struct itm_receiver_type
+{	/* One receiver of point_to_point_ITM_batch() or
+	   point_to_point_batch(), and its results */
+	int np;			/* Profile points up to the receiver, less one (its elev[0]) */
+	double xi;		/* Their spacing in meters (its elev[1]); 0.0 = elev[1] */
+	double rht_m;		/* Receiver height above ground in meters */
+	double dbloss;		/* The results of a point_to_point() call for it */
+	int errnum;
+	char strmode[100];
+};
+
+void itm_batch(bool itwom, double elev[], double tht_m, double eps_dielect, double sgm_conductivity, double eno_ns_surfref, double frq_mhz, int radio_climate, int pol, double conf, double rel, itm_receiver_type rx[], int count, bool summarize, const itm_profile_type *sums, const itm_session_type *session)
+{
+	/* Evaluates every receiver in rx[] on its prefix of elev[].
+	   They share one session, and if "summarize" is set, one set
+	   of summaries of elev[] and the transmitter horizon carried
+	   along it.  Unless given as "sums", the summaries are made
+	   here, up to the farthest receiver.  elev[0] and elev[1] are
+	   restored on return. */
+	itm_session_type prepared;
+	itm_horizon_type horizon;
+	itm_profile_type profile;
+	double np=elev[0], xi=elev[1], *buffer=NULL;
+	int i, n;
+
+	if (session==NULL)
+	{
+		itm_session_prepare(eps_dielect,sgm_conductivity,frq_mhz,radio_climate,pol,conf,rel,prepared);
+		session=&prepared;
+	}
+
+	if (!summarize)
+		sums=NULL;
+
+	else if (sums==NULL && count>0)
+	{
+		for (i=0, n=0; i<count; i++)
+			n=mymax(n,rx[i].np);
+
+		buffer=new double[2*n+4+n/ITM_PROFILE_BLOCK+1];
+		horizon.hull=new int[n+1];
+		horizon.size=0;
+		horizon.added=0;
+		profile.sz=buffer;
+		profile.sjz=buffer+n+2;
+		profile.hmax=buffer+2*n+4;
+		profile.horizon=&horizon;
+		itm_profile_prepare(elev,n,buffer,buffer+n+2,buffer+2*n+4);
+		sums=&profile;
+	}
+
+	for (i=0; i<count; i++)
+	{
+		elev[0]=rx[i].np;
+		elev[1]=(rx[i].xi>0.0 ? rx[i].xi : xi);
+
+		if (itwom)
+			point_to_point(elev,tht_m,rx[i].rht_m,eps_dielect,sgm_conductivity,eno_ns_surfref,frq_mhz,radio_climate,pol,conf,rel,rx[i].dbloss,rx[i].strmode,rx[i].errnum,sums,session);
+		else
+			point_to_point_ITM(elev,tht_m,rx[i].rht_m,eps_dielect,sgm_conductivity,eno_ns_surfref,frq_mhz,radio_climate,pol,conf,rel,rx[i].dbloss,rx[i].strmode,rx[i].errnum,sums,session);
+	}
+
+	if (buffer!=NULL)
+	{
+		delete[] buffer;
+		delete[] horizon.hull;
+	}
+
+	elev[0]=np;
+	elev[1]=xi;
+}
+
+void point_to_point_ITM_batch(double elev[], double tht_m, double eps_dielect, double sgm_conductivity, double eno_ns_surfref, double frq_mhz, int radio_climate, int pol, double conf, double rel, itm_receiver_type rx[], int count, bool summarize=true, const itm_profile_type *sums=NULL, const itm_session_type *session=NULL)
+{
+	/* point_to_point_ITM() for "count" receivers along one
+	   profile, each given by how far along elev[] it is, the
+	   sample spacing and its height.  The radio and climate
+	   constants are found once for all of them (or taken from
+	   "session").  Unless "summarize" is cleared, the profile is
+	   summarized once (or "sums" is used), and the horizons and
+	   the least squares fits of each receiver's prefix are found
+	   from the summaries, with the transmitter horizon carried
+	   from one receiver to the next; receivers are then best
+	   given in order along the profile.  The results differ from
+	   separate point_to_point_ITM() calls by rounding. */
+
+	itm_batch(false,elev,tht_m,eps_dielect,sgm_conductivity,eno_ns_surfref,frq_mhz,radio_climate,pol,conf,rel,rx,count,summarize,sums,session);
+}
+
+void point_to_point_batch(double elev[], double tht_m, double eps_dielect, double sgm_conductivity, double eno_ns_surfref, double frq_mhz, int radio_climate, int pol, double conf, double rel, itm_receiver_type rx[], int count, bool summarize=true, const itm_profile_type *sums=NULL, const itm_session_type *session=NULL)
+{
+	/* point_to_point() (ITWOM) for "count" receivers along one
+	   profile, as point_to_point_ITM_batch().  The terrain
+	   roughness is still found from each receiver's prefix. */
+
+	itm_batch(true,elev,tht_m,eps_dielect,sgm_conductivity,eno_ns_surfref,frq_mhz,radio_climate,pol,conf,rel,rx,count,summarize,sums,session);
+}
+
+
 void point_to_pointMDH_two (double elev[], double tht_m, double rht_m,
           double eps_dielect, double sgm_conductivity, double eno_ns_surfref, 
 	  double enc_ncc_clcref, double clutter_height, double clutter_density, 
@@ -0,0 +1,129 @@
+#ifndef MAP_PALETTE_H
+#define MAP_PALETTE_H
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+/*
+  Pixel lookup tables for one rendered map.  Every signal byte is
+  classified against the colour levels once, and the background of
+  every elevation is shaded once, so the pixel loop does no level
+  search, contour interpolation or gamma correction.  Pixels are
+  kept in the byte order of the image being written (RGB for files,
+  BGR for OpenCV frames) followed by an alpha byte, which is 0 only
+  where a clear background shows through.
+*/
+
+class MapPalette {
+   public:
+    enum Background { TERRAIN, WHITE, CLEAR };
+
+    explicit MapPalette(bool bgr)
+        : bgr_(bgr),
+          background_(TERRAIN),
+          base_(0),
+          min_elevation_(0),
+          one_over_gamma_(0.0),
+          conversion_(0.0) {
+        memset(color_, 0, sizeof(color_));
+        memset(label_, 0, sizeof(label_));
+        memset(plotted_, 0, sizeof(plotted_));
+    }
+
+    void setSignal(int signal, unsigned red, unsigned green, unsigned blue, bool plotted,
+                   bool invert_label) {
+        /* Sets the contour colour of a signal byte, whether it is
+           drawn at all, and whether a text label over it is the
+           inverse of that colour rather than plain red. */
+
+        store(color_[signal], red, green, blue);
+        plotted_[signal] = plotted;
+
+        if (invert_label)
+            store(label_[signal], 255 ^ red, 255 ^ green, 255 ^ blue);
+        else
+            store(label_[signal], 255, 0, 0);
+    }
+
+    void setTerrain(int min_elevation, int max_elevation, double one_over_gamma,
+                    Background background) {
+        /* Tabulates the background pixel of every elevation from sea
+           level or the lowest loaded one, whichever is lower, up to
+           the highest. */
+
+        int top = max_elevation > 0 ? max_elevation : 0;
+
+        min_elevation_ = min_elevation;
+        one_over_gamma_ = one_over_gamma;
+        conversion_ = 255.0 / pow((double)(max_elevation - min_elevation), one_over_gamma);
+        background_ = background;
+        base_ = min_elevation < 0 ? min_elevation : 0;
+
+        terrain_.resize(4 * (size_t)(top - base_ + 1));
+
+        for (int elevation = base_; elevation <= top; elevation++)
+            shade(elevation, &terrain_[4 * (size_t)(elevation - base_)]);
+    }
+
+    const unsigned char *color(unsigned char signal) const { return color_[signal]; }
+
+    const unsigned char *label(unsigned char signal) const { return label_[signal]; }
+
+    bool plotted(unsigned char signal) const { return plotted_[signal]; }
+
+    const unsigned char *background(int elevation, unsigned char *spare) const {
+        /* Pixel shown where no contour is drawn.  Elevations raised
+           past the table by user terrain are shaded into the four
+           bytes at "spare". */
+
+        size_t index = (size_t)(elevation - base_);
+
+        if (elevation >= base_ && 4 * index < terrain_.size()) return &terrain_[4 * index];
+
+        shade(elevation, spare);
+
+        return spare;
+    }
+
+   private:
+    void store(unsigned char *pixel, unsigned red, unsigned green, unsigned blue,
+               unsigned char alpha = 255) const {
+        pixel[0] = (unsigned char)(bgr_ ? blue : red);
+        pixel[1] = (unsigned char)green;
+        pixel[2] = (unsigned char)(bgr_ ? red : blue);
+        pixel[3] = alpha;
+    }
+
+    void shade(int elevation, unsigned char *pixel) const {
+        unsigned terrain;
+
+        if (background_ == CLEAR)
+            store(pixel, 0, 0, 0, 0);
+
+        else if (background_ == WHITE)
+            store(pixel, 255, 255, 255);
+
+        else if (elevation == 0) /* Sea level */
+            store(pixel, 0, 0, 170);
+
+        else {
+            /* Elevation: Greyscale */
+
+            terrain = (unsigned)(0.5 + pow((double)(elevation - min_elevation_), one_over_gamma_) *
+                                           conversion_);
+            store(pixel, terrain, terrain, terrain);
+        }
+    }
+
+    bool bgr_;
+    Background background_;
+    int base_, min_elevation_;
+    double one_over_gamma_, conversion_;
+    unsigned char color_[256][4];
+    unsigned char label_[256][4];
+    unsigned char plotted_[256];
+    std::vector<unsigned char> terrain_;  // 4 bytes per elevation from base_
+};
+
+#endif  // MAP_PALETTE_H
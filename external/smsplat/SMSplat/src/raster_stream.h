@@ -0,0 +1,73 @@
+#ifndef RASTER_STREAM_H
+#define RASTER_STREAM_H
+
+#include <functional>
+#include <opencv2/opencv.hpp>
+
+/*
+  Row-by-row output of a rendered map.  Without a sink, rows are
+  written straight into the caller's full-size frame.  With one,
+  they are rendered into a single block of at most BLOCK_ROWS rows,
+  which is handed to the sink, along with the index of its first
+  row, each time it fills, so a map of any size is produced in
+  bounded memory.
+*/
+
+class RasterStream {
+   public:
+    static constexpr int BLOCK_ROWS = 128;
+
+    typedef std::function<void(const cv::Mat &block, int row)> Sink;
+
+    RasterStream(int width, int height, int type, cv::Mat *frame, const Sink &sink)
+        : width_(width), height_(height), type_(type), block_row_(0), frame_(frame), sink_(sink) {
+        /* The frame is (re)allocated to width x height when rows go
+           into it, and released when they go to the sink instead. */
+
+        if (sink_) {
+            if (frame_ != NULL) frame_->release();
+
+            block_.create(height_ < BLOCK_ROWS ? height_ : BLOCK_ROWS, width_, type_);
+        }
+
+        else if (frame_ != NULL)
+            frame_->create(height_, width_, type_);
+    }
+
+    unsigned char *row(int y) {
+        /* Returns row y for writing.  Rows must be requested in
+           order; starting a new block hands the last one over. */
+
+        if (!sink_) return frame_->ptr<unsigned char>(y);
+
+        if (y - block_row_ >= BLOCK_ROWS) {
+            sink_(block_, block_row_);
+            block_row_ += BLOCK_ROWS;
+        }
+
+        return block_.ptr<unsigned char>(y - block_row_);
+    }
+
+    void finish() {
+        /* Hands the last, possibly partial, block to the sink */
+
+        if (!sink_ || block_row_ >= height_) return;
+
+        int rows = height_ - block_row_;
+
+        if (rows == block_.rows)
+            sink_(block_, block_row_);
+        else
+            sink_(cv::Mat(rows, width_, type_, block_.data), block_row_);
+
+        block_row_ = height_;
+    }
+
+   private:
+    int width_, height_, type_, block_row_;
+    cv::Mat *frame_;
+    Sink sink_;
+    cv::Mat block_;
+};
+
+#endif  // RASTER_STREAM_H
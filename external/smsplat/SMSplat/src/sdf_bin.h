@@ -0,0 +1,38 @@
+#ifndef SDF_BIN_H
+#define SDF_BIN_H
+
+/*
+  Binary SPLAT Data File (.bsdf) layout, shared by SplatProcessor and
+  the sdf2bsdf converter.  A .bsdf holds exactly what LoadSDF_SDF()
+  parses out of a text .sdf: the quadrangle limits, the elevation
+  extremes and the ippd x ippd grid of elevations (meters), stored as
+  native int16 in the same [x][y] order as dem[].data so a mapped
+  tile serves as a DEM page's grid without any parsing or copying.
+*/
+
+#include <stdint.h>
+
+#define SDF_BIN_MAGIC "SPLATDEM"
+#define SDF_BIN_VERSION 1
+#define SDF_BIN_BYTE_ORDER 0x01020304u /* Reads back differently on a foreign-endian host */
+
+struct sdf_bin_header {
+    char magic[8];       /* SDF_BIN_MAGIC, not NUL terminated */
+    uint32_t version;    /* SDF_BIN_VERSION */
+    uint32_t byte_order; /* SDF_BIN_BYTE_ORDER */
+    int32_t ippd;        /* 1200 (3 arc-second) or 3600 (1 arc-second, HD) */
+    int32_t max_west;
+    int32_t min_north;
+    int32_t min_west;
+    int32_t max_north;
+    int32_t min_el;
+    int32_t max_el;
+    int32_t reserved[5]; /* Zero; pads the header to 64 bytes */
+};
+
+/* Elevation samples start right after the header */
+
+#define SDF_BIN_DATA_OFFSET ((long)sizeof(struct sdf_bin_header))
+#define SDF_BIN_FILE_SIZE(ippd) (SDF_BIN_DATA_OFFSET + 2L * (long)(ippd) * (long)(ippd))
+
+#endif  // SDF_BIN_H
@@ -23,9 +23,25 @@
 #include "splat.h"
 #include "itwom3.0.hpp"
 #include <opencv2/opencv.hpp>
+#include <algorithm>
 #include <chrono>
+#include <atomic>
+#include <functional>
+#include <stdarg.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sdf_bin.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #define GAMMA 2.5
 #define BZBUFFER 65536
+#define RADIAL_BATCH 64 /* Radials traced per worker before evaluating */
 
 #ifndef PI
 #define PI 3.141592653589793
@@ -47,8 +63,7 @@
 #define FOUR_THIRDS 1.3333333333333
 
 SplatProcessor::SplatProcessor()
-    : opened_(0),
-      gpsav_(0),
+    : gpsav_(0),
       max_range_(0.0),
       forced_erp_(-1.0),
       fzone_clearance_(0.6),
@@ -58,6 +73,8 @@ SplatProcessor::SplatProcessor()
       max_west_(-1),
       max_elevation_(-32768),
       min_elevation_(32768),
+      got_elevation_pattern_(0),
+      got_azimuth_pattern_(0),
       metric_(0),
       dbm_(0),
       smooth_contours_(0),
@@ -65,7 +82,23 @@ SplatProcessor::SplatProcessor()
       start_angle_(0.0),  // Start angle in degrees
       end_angle_(360.0),  // End angle in degrees
       specified_angle_mode_(0),
-      transparent_mode_(0) {
+      transparent_mode_(0),
+      threads_(0),
+      hd_mode_(HD_MODE),
+      maxpages_(MAXPAGES),
+      arraysize_(0),
+      profile_summaries_(1),
+      prune_margin_(-1),
+      prune_window_(5.0),
+      prune_active_(0),
+      prune_floor_(0.0),
+      prune_span_(0.0),
+      pruned_points_(0),
+      adaptive_spacing_(0.0),
+      ctx_(new PathContext),
+      cancel_(NULL),
+      sweep_quarter_(0) {
+        ReleasePages();
         homeDir_ = std::getenv("HOME") ? std::getenv("HOME") : "";
         mapFilePath_ = homeDir_ + "/.cache/splat/splat_output.ppm";
         lrpFilePathInput_ = "";
@@ -171,9 +204,46 @@ char *SplatProcessor::dec2dms(double decimal) {
 
     if (seconds > 59) seconds = 59;
 
-    string_[0] = 0;
-    snprintf(string_, 250, "%d%c %d\' %d\"", degrees * sign, 176, minutes, seconds);
-    return (string_);
+    ctx_->string[0] = 0;
+    snprintf(ctx_->string, 250, "%d%c %d\' %d\"", degrees * sign, 176, minutes, seconds);
+    return (ctx_->string);
+}
+
+int SplatProcessor::FindPage(double lat, double lon, int &x, int &y) {
+    /* This function returns the index of the DEM page holding
+       the given latitude and longitude, and the pixel within it
+       in x and y, or -1 if no page in memory holds the point.
+       The page is looked up in page_index_ by the quadrangle the
+       point rounds into, so the pool is only scanned when that
+       guess misses, as it may for a point sitting exactly half
+       a pixel from a page edge. */
+
+    int indx, north, west;
+
+    north = (int)floor(lat + 0.5 * dpp_);
+    west = (int)ceil(lon - 0.5 * dpp_) % 360;
+
+    if (west < 0) west += 360;
+
+    if (north >= -90 && north < 90) {
+        indx = page_index_[(north + 90) * 360 + west];
+
+        if (indx >= 0) {
+            x = (int)rint(ppd_ * (lat - dem_[indx].min_north));
+            y = mpi_ - (int)rint(ppd_ * (LonDiff(dem_[indx].max_west, lon)));
+
+            if (x >= 0 && x <= mpi_ && y >= 0 && y <= mpi_) return indx;
+        }
+    }
+
+    for (indx = 0; indx < maxpages_; indx++) {
+        x = (int)rint(ppd_ * (lat - dem_[indx].min_north));
+        y = mpi_ - (int)rint(ppd_ * (LonDiff(dem_[indx].max_west, lon)));
+
+        if (x >= 0 && x <= mpi_ && y >= 0 && y <= mpi_) return indx;
+    }
+
+    return -1;
 }
 
 int SplatProcessor::PutMask(double lat, double lon, int value) {
@@ -186,19 +256,12 @@ int SplatProcessor::PutMask(double lat, double lon, int value) {
     int x, y, indx;
     char found;
 
-    for (indx = 0, found = 0; indx < MAXPAGES && found == 0;) {
-        x = (int)rint(ppd_ * (lat - dem_[indx].min_north));
-        y = mpi_ - (int)rint(ppd_ * (LonDiff(dem_[indx].max_west, lon)));
-
-        if (x >= 0 && x <= mpi_ && y >= 0 && y <= mpi_)
-            found = 1;
-        else
-            indx++;
-    }
+    indx = FindPage(lat, lon, x, y);
+    found = (indx >= 0);
 
     if (found) {
-        dem_[indx].mask[x][y] = value;
-        return ((int)dem_[indx].mask[x][y]);
+        coverage_.at(indx, x, y).mask = value;
+        return ((int)coverage_.at(indx, x, y).mask);
     }
 
     else
@@ -215,19 +278,12 @@ int SplatProcessor::OrMask(double lat, double lon, int value) {
     int x, y, indx;
     char found;
 
-    for (indx = 0, found = 0; indx < MAXPAGES && found == 0;) {
-        x = (int)rint(ppd_ * (lat - dem_[indx].min_north));
-        y = mpi_ - (int)rint(ppd_ * (LonDiff(dem_[indx].max_west, lon)));
-
-        if (x >= 0 && x <= mpi_ && y >= 0 && y <= mpi_)
-            found = 1;
-        else
-            indx++;
-    }
+    indx = FindPage(lat, lon, x, y);
+    found = (indx >= 0);
 
     if (found) {
-        dem_[indx].mask[x][y] |= value;
-        return ((int)dem_[indx].mask[x][y]);
+        coverage_.at(indx, x, y).mask |= value;
+        return ((int)coverage_.at(indx, x, y).mask);
     }
 
     else
@@ -241,6 +297,30 @@ int SplatProcessor::GetMask(double lat, double lon) {
     return (OrMask(lat, lon, 0));
 }
 
+unsigned char *SplatProcessor::MaskCell(double lat, double lon) {
+    /* This function returns a pointer to the mask byte that
+       GetMask(), PutMask() and OrMask() address for the given
+       latitude and longitude, or NULL if it is not in memory. */
+
+    int x, y, indx;
+
+    indx = FindPage(lat, lon, x, y);
+
+    return (indx >= 0 ? &coverage_.at(indx, x, y).mask : NULL);
+}
+
+unsigned char *SplatProcessor::SignalCell(double lat, double lon) {
+    /* This function returns a pointer to the signal level that
+       GetSignal() and PutSignal() address for the given latitude
+       and longitude, or NULL if it is not in memory. */
+
+    int x, y, indx;
+
+    indx = FindPage(lat, lon, x, y);
+
+    return (indx >= 0 ? &coverage_.at(indx, x, y).signal : NULL);
+}
+
 int SplatProcessor::PutSignal(double lat, double lon, unsigned char signal) {
     /* This function writes a signal level (0-255)
        at the specified location for later recall. */
@@ -248,19 +328,12 @@ int SplatProcessor::PutSignal(double lat, double lon, unsigned char signal) {
     int x, y, indx;
     char found;
 
-    for (indx = 0, found = 0; indx < MAXPAGES && found == 0;) {
-        x = (int)rint(ppd_ * (lat - dem_[indx].min_north));
-        y = mpi_ - (int)rint(ppd_ * (LonDiff(dem_[indx].max_west, lon)));
-
-        if (x >= 0 && x <= mpi_ && y >= 0 && y <= mpi_)
-            found = 1;
-        else
-            indx++;
-    }
+    indx = FindPage(lat, lon, x, y);
+    found = (indx >= 0);
 
     if (found) {
-        dem_[indx].signal[x][y] = signal;
-        return (dem_[indx].signal[x][y]);
+        coverage_.at(indx, x, y).signal = signal;
+        return (coverage_.at(indx, x, y).signal);
     }
 
     else
@@ -275,18 +348,11 @@ unsigned char SplatProcessor::GetSignal(double lat, double lon) {
     int x, y, indx;
     char found;
 
-    for (indx = 0, found = 0; indx < MAXPAGES && found == 0;) {
-        x = (int)rint(ppd_ * (lat - dem_[indx].min_north));
-        y = mpi_ - (int)rint(ppd_ * (LonDiff(dem_[indx].max_west, lon)));
-
-        if (x >= 0 && x <= mpi_ && y >= 0 && y <= mpi_)
-            found = 1;
-        else
-            indx++;
-    }
+    indx = FindPage(lat, lon, x, y);
+    found = (indx >= 0);
 
     if (found)
-        return (dem_[indx].signal[x][y]);
+        return (coverage_.at(indx, x, y).signal);
     else
         return 0;
 }
@@ -300,15 +366,8 @@ double SplatProcessor::GetElevation(struct site location) {
     int x, y, indx;
     double elevation;
 
-    for (indx = 0, found = 0; indx < MAXPAGES && found == 0;) {
-        x = (int)rint(ppd_ * (location.lat - dem_[indx].min_north));
-        y = mpi_ - (int)rint(ppd_ * (LonDiff(dem_[indx].max_west, location.lon)));
-
-        if (x >= 0 && x <= mpi_ && y >= 0 && y <= mpi_)
-            found = 1;
-        else
-            indx++;
-    }
+    indx = FindPage(location.lat, location.lon, x, y);
+    found = (indx >= 0);
 
     if (found)
         elevation = 3.28084 * dem_[indx].data[x][y];
@@ -327,19 +386,15 @@ int SplatProcessor::AddElevation(double lat, double lon, double height) {
     char found;
     int x, y, indx;
 
-    for (indx = 0, found = 0; indx < MAXPAGES && found == 0;) {
-        x = (int)rint(ppd_ * (lat - dem_[indx].min_north));
-        y = mpi_ - (int)rint(ppd_ * (LonDiff(dem_[indx].max_west, lon)));
+    indx = FindPage(lat, lon, x, y);
+    found = (indx >= 0);
 
-        if (x >= 0 && x <= mpi_ && y >= 0 && y <= mpi_)
-            found = 1;
-        else
-            indx++;
+    if (found && UnshareTerrain(indx)) {
+        dem_[indx].data[x][y] += (short)rint(height);
+        return 1;
     }
 
-    if (found) dem_[indx].data[x][y] += (short)rint(height);
-
-    return found;
+    return 0;
 }
 
 double SplatProcessor::Distance(struct site site1, struct site site2) {
@@ -424,6 +479,66 @@ double SplatProcessor::ElevationAngle(struct site source, struct site destinatio
     return ((180.0 * (acos(((b * b) + (dx * dx) - (a * a)) / (2.0 * b * dx))) / PI) - 90.0);
 }
 
+/* ReadPath() generates great circle samples PROFILE_BLOCK at a
+   time.  The sine and cosine of each sample's angular distance are
+   found by rotating those of the sample PROFILE_LANES earlier, four
+   lanes at once where AVX2 is available, and every block restarts
+   from exact values so that rounding cannot build up along a path. */
+
+#define PROFILE_BLOCK 64
+#define PROFILE_LANES 4
+
+static void GreatCircleBlock(double sin_lat1, double cos_lat1, double sin_az, double cos_az,
+                             double step, int first, int count, double *sin_lat2, double *dlon_y,
+                             double *dlon_x) {
+    /* For samples first..first+count-1, "step" radians apart along
+       the great circle leaving (lat1, lon1) at azimuth az, this
+       function returns the sine of each sample's latitude, and the
+       two arguments of atan2() giving its longitude east of lon1.
+       The arrays must hold count rounded up to PROFILE_LANES. */
+
+    double cos_b[PROFILE_BLOCK + PROFILE_LANES], sin_b[PROFILE_BLOCK + PROFILE_LANES], rot_c, rot_s;
+    int k;
+
+    for (k = 0; k < PROFILE_LANES; k++) {
+        cos_b[k] = cos(step * (double)(first + k));
+        sin_b[k] = sin(step * (double)(first + k));
+    }
+
+    rot_c = cos(step * PROFILE_LANES);
+    rot_s = sin(step * PROFILE_LANES);
+
+#ifdef __AVX2__
+    __m256d c = _mm256_loadu_pd(cos_b), s = _mm256_loadu_pd(sin_b), next;
+    const __m256d rc = _mm256_set1_pd(rot_c), rs = _mm256_set1_pd(rot_s),
+                  a = _mm256_set1_pd(sin_lat1), b = _mm256_set1_pd(cos_lat1 * cos_az),
+                  e = _mm256_set1_pd(sin_az * cos_lat1);
+
+    for (k = 0; k < count; k += PROFILE_LANES) {
+        __m256d z = _mm256_fmadd_pd(b, s, _mm256_mul_pd(a, c));
+
+        _mm256_storeu_pd(sin_lat2 + k, z);
+        _mm256_storeu_pd(dlon_y + k, _mm256_mul_pd(e, s));
+        _mm256_storeu_pd(dlon_x + k, _mm256_fnmadd_pd(a, z, c));
+
+        next = _mm256_fmsub_pd(c, rc, _mm256_mul_pd(s, rs));
+        s = _mm256_fmadd_pd(s, rc, _mm256_mul_pd(c, rs));
+        c = next;
+    }
+#else
+    for (k = PROFILE_LANES; k < count; k++) {
+        cos_b[k] = cos_b[k - PROFILE_LANES] * rot_c - sin_b[k - PROFILE_LANES] * rot_s;
+        sin_b[k] = sin_b[k - PROFILE_LANES] * rot_c + cos_b[k - PROFILE_LANES] * rot_s;
+    }
+
+    for (k = 0; k < count; k++) {
+        sin_lat2[k] = sin_lat1 * cos_b[k] + cos_lat1 * cos_az * sin_b[k];
+        dlon_y[k] = sin_az * cos_lat1 * sin_b[k];
+        dlon_x[k] = cos_b[k] - sin_lat1 * sin_lat2[k];
+    }
+#endif
+}
+
 void SplatProcessor::ReadPath(struct site source, struct site destination) {
     /* This function generates a sequence of latitude and
        longitude positions between source and destination
@@ -431,10 +546,21 @@ void SplatProcessor::ReadPath(struct site source, struct site destination) {
        elevation and distance information for points
        along that path in the "path" structure. */
 
-    int c;
-    double azimuth, distance, lat1, lon1, beta, den, num, lat2, lon2, total_distance, dx, dy,
-        path_length, miles_per_sample, samples_per_radian = 68755.0;
-    struct site tempsite;
+    ReadPath(source, destination, ctx_->path);
+}
+
+void SplatProcessor::ReadPath(struct site source, struct site destination, struct path &out) {
+    /* This function generates a sequence of latitude and
+       longitude positions between source and destination
+       locations along a great circle path, and stores
+       elevation and distance information for points
+       along that path in the "out" structure, which lets
+       concurrent radials each fill their own scratch path. */
+
+    int c, k, x, y, indx, first, count, samples;
+    double azimuth, lat1, lon1, lat2, lon2, total_distance, dx, dy, path_length, miles_per_sample,
+        sin_lat1, cos_lat1, samples_per_radian = 68755.0;
+    double sin_lat2[PROFILE_BLOCK], dlon_y[PROFILE_BLOCK], dlon_x[PROFILE_BLOCK];
 
     lat1 = source.lat * DEG2RAD;
     lon1 = source.lon * DEG2RAD;
@@ -458,6 +584,8 @@ void SplatProcessor::ReadPath(struct site source, struct site destination) {
         path_length = sqrt((dx * dx) + (dy * dy)); /* Total number of samples */
 
         miles_per_sample = total_distance / path_length; /* Miles per sample */
+
+        out.grow(path_length + 16.0 < arraysize_ ? (int)path_length + 16 : arraysize_);
     }
 
     else {
@@ -468,68 +596,89 @@ void SplatProcessor::ReadPath(struct site source, struct site destination) {
         miles_per_sample = 0.0;
         total_distance = 0.0;
 
+        out.grow(1);
+
         lat1 = lat1 / DEG2RAD;
         lon1 = lon1 / DEG2RAD;
 
-        path_.lat[c] = lat1;
-        path_.lon[c] = lon1;
-        path_.elevation[c] = GetElevation(source);
-        path_.distance[c] = 0.0;
+        out.lat[c] = lat1;
+        out.lon[c] = lon1;
+        out.elevation[c] = GetElevation(source);
+        out.distance[c] = 0.0;
     }
 
-    for (distance = 0.0, c = 0;
-         (total_distance != 0.0 && distance <= total_distance && c < ARRAYSIZE);
-         c++, distance = miles_per_sample * (double)c) {
-        beta = distance / 3959.0;
-        lat2 = asin(sin(lat1) * cos(beta) + cos(azimuth) * sin(beta) * cos(lat1));
-        num = cos(beta) - (sin(lat1) * sin(lat2));
-        den = cos(lat1) * cos(lat2);
+    /* Samples are taken every miles_per_sample along the path,
+       up to and including total_distance. */
 
-        if (azimuth == 0.0 && (beta > HALFPI - lat1))
-            lon2 = lon1 + PI;
+    samples = 0;
 
-        else if (azimuth == HALFPI && (beta > HALFPI + lat1))
-            lon2 = lon1 + PI;
+    if (total_distance != 0.0) {
+        samples = (int)(total_distance / miles_per_sample);
 
-        else if (fabs(num / den) > 1.0)
-            lon2 = lon1;
+        if (samples > arraysize_) samples = arraysize_;
 
-        else {
-            if ((PI - azimuth) >= 0.0)
-                lon2 = lon1 - arccos(num, den);
-            else
-                lon2 = lon1 + arccos(num, den);
-        }
+        while (samples > 0 && miles_per_sample * (double)(samples - 1) > total_distance) samples--;
+
+        while (samples < arraysize_ && miles_per_sample * (double)samples <= total_distance)
+            samples++;
+    }
+
+    sin_lat1 = sin(lat1);
+    cos_lat1 = cos(lat1);
+
+    for (first = 0, indx = -1; first < samples; first += PROFILE_BLOCK) {
+        count = (samples - first < PROFILE_BLOCK ? samples - first : PROFILE_BLOCK);
 
-        while (lon2 < 0.0) lon2 += TWOPI;
+        GreatCircleBlock(sin_lat1, cos_lat1, sin(azimuth), cos(azimuth), miles_per_sample / 3959.0,
+                         first, count, sin_lat2, dlon_y, dlon_x);
 
-        while (lon2 > TWOPI) lon2 -= TWOPI;
+        for (k = 0; k < count; k++) {
+            c = first + k;
 
-        lat2 = lat2 / DEG2RAD;
-        lon2 = lon2 / DEG2RAD;
+            lat2 = asin(sin_lat2[k] > 1.0 ? 1.0 : (sin_lat2[k] < -1.0 ? -1.0 : sin_lat2[k]));
+            lon2 = lon1 - atan2(dlon_y[k], dlon_x[k]);
 
-        path_.lat[c] = lat2;
-        path_.lon[c] = lon2;
-        tempsite.lat = lat2;
-        tempsite.lon = lon2;
-        path_.elevation[c] = GetElevation(tempsite);
-        path_.distance[c] = distance;
+            while (lon2 < 0.0) lon2 += TWOPI;
+
+            while (lon2 > TWOPI) lon2 -= TWOPI;
+
+            lat2 = lat2 / DEG2RAD;
+            lon2 = lon2 / DEG2RAD;
+
+            out.lat[c] = lat2;
+            out.lon[c] = lon2;
+            out.distance[c] = miles_per_sample * (double)c;
+
+            /* Consecutive samples nearly always share a page, so
+               try the previous sample's page before FindPage(). */
+
+            if (indx >= 0) {
+                x = (int)rint(ppd_ * (lat2 - dem_[indx].min_north));
+                y = mpi_ - (int)rint(ppd_ * (LonDiff(dem_[indx].max_west, lon2)));
+            }
+
+            if (indx < 0 || x < 0 || x > mpi_ || y < 0 || y > mpi_) indx = FindPage(lat2, lon2, x, y);
+
+            out.elevation[c] = (indx >= 0 ? 3.28084 * dem_[indx].data[x][y] : -5000.0);
+        }
     }
 
+    if (total_distance != 0.0) c = samples;
+
     /* Make sure exact destination point is recorded at path.length-1 */
 
-    if (c < ARRAYSIZE) {
-        path_.lat[c] = destination.lat;
-        path_.lon[c] = destination.lon;
-        path_.elevation[c] = GetElevation(destination);
-        path_.distance[c] = total_distance;
+    if (c < arraysize_) {
+        out.lat[c] = destination.lat;
+        out.lon[c] = destination.lon;
+        out.elevation[c] = GetElevation(destination);
+        out.distance[c] = total_distance;
         c++;
     }
 
-    if (c < ARRAYSIZE)
-        path_.length = c;
+    if (c < arraysize_)
+        out.length = c;
     else
-        path_.length = ARRAYSIZE - 1;
+        out.length = arraysize_ - 1;
 }
 
 double SplatProcessor::ElevationAngle2(struct site source, struct site destination, double er) {
@@ -543,11 +692,10 @@ double SplatProcessor::ElevationAngle2(struct site source, struct site destinati
     char block = 0;
     double source_alt, destination_alt, cos_xmtr_angle, cos_test_angle, test_alt, elevation,
         distance, source_alt2, first_obstruction_angle = 0.0;
-    struct path temp;
+    std::unique_ptr<struct path> trace(new struct path);
+    struct path &temp = *trace;
 
-    temp = path_;
-
-    ReadPath(source, destination);
+    ReadPath(source, destination, temp);
 
     distance = 5280.0 * Distance(source, destination);
     source_alt = er + source.alt + GetElevation(source);
@@ -566,11 +714,11 @@ double SplatProcessor::ElevationAngle2(struct site source, struct site destinati
        at the source since we're interested in identifying the FIRST
        obstruction along the path between source and destination. */
 
-    for (x = 2, block = 0; x < path_.length && block == 0; x++) {
-        distance = 5280.0 * path_.distance[x];
+    for (x = 2, block = 0; x < temp.length && block == 0; x++) {
+        distance = 5280.0 * temp.distance[x];
 
         test_alt = earthradius_ +
-                   (path_.elevation[x] == 0.0 ? path_.elevation[x] : path_.elevation[x] + clutter_);
+                   (temp.elevation[x] == 0.0 ? temp.elevation[x] : temp.elevation[x] + clutter_);
 
         cos_test_angle = ((source_alt2) + (distance * distance) - (test_alt * test_alt)) /
                          (2.0 * source_alt * distance);
@@ -595,32 +743,22 @@ double SplatProcessor::ElevationAngle2(struct site source, struct site destinati
     else
         elevation = ((acos(cos_xmtr_angle)) / DEG2RAD) - 90.0;
 
-    path_ = temp;
-
     return elevation;
 }
 
-double SplatProcessor::AverageTerrain(struct site source, double azimuthx, double start_distance,
-                                      double end_distance) {
-    /* This function returns the average terrain calculated in
-       the direction of "azimuth" (degrees) between "start_distance"
-       and "end_distance" (miles) from the source location.  If
-       the terrain is all water (non-critical error), -5000.0 is
-       returned.  If not enough SDF data has been loaded into
-       memory to complete the survey (critical error), then
-       -9999.0 is returned. */
+SplatProcessor::site SplatProcessor::Destination(struct site source, double azimuthx, double distance) {
+    /* This function returns the location "distance" miles from
+       the source along the great circle leaving it in the
+       direction of "azimuth" (degrees).  Only the latitude and
+       longitude of the result are filled in. */
 
-    int c, samples, endpoint;
-    double beta, lat1, lon1, lat2, lon2, num, den, azimuth, terrain = 0.0;
-    struct site destination;
+    double beta, lat1, lon1, lat2, lon2, num, den, azimuth;
+    struct site destination = {};
 
     lat1 = source.lat * DEG2RAD;
     lon1 = source.lon * DEG2RAD;
 
-    /* Generate a path of elevations between the source
-       location and the remote location provided. */
-
-    beta = end_distance / 3959.0;
+    beta = distance / 3959.0;
 
     azimuth = DEG2RAD * azimuthx;
 
@@ -648,11 +786,30 @@ double SplatProcessor::AverageTerrain(struct site source, double azimuthx, doubl
 
     while (lon2 > TWOPI) lon2 -= TWOPI;
 
-    lat2 = lat2 / DEG2RAD;
-    lon2 = lon2 / DEG2RAD;
+    destination.lat = lat2 / DEG2RAD;
+    destination.lon = lon2 / DEG2RAD;
+
+    return destination;
+}
+
+double SplatProcessor::AverageTerrain(struct site source, double azimuthx, double start_distance,
+                                      double end_distance) {
+    /* This function returns the average terrain calculated in
+       the direction of "azimuth" (degrees) between "start_distance"
+       and "end_distance" (miles) from the source location.  If
+       the terrain is all water (non-critical error), -5000.0 is
+       returned.  If not enough SDF data has been loaded into
+       memory to complete the survey (critical error), then
+       -9999.0 is returned. */
+
+    int c, samples, endpoint;
+    double terrain = 0.0;
+    struct site destination;
+
+    /* Generate a path of elevations between the source
+       location and the remote location provided. */
 
-    destination.lat = lat2;
-    destination.lon = lon2;
+    destination = Destination(source, azimuthx, end_distance);
 
     /* If SDF data is missing for the endpoint of
        the radial, then the average terrain cannot
@@ -663,19 +820,19 @@ double SplatProcessor::AverageTerrain(struct site source, double azimuthx, doubl
     else {
         ReadPath(source, destination);
 
-        endpoint = path_.length;
+        endpoint = ctx_->path.length;
 
         /* Shrink the length of the radial if the
            outermost portion is not over U.S. land. */
 
-        for (c = endpoint - 1; c >= 0 && path_.elevation[c] == 0.0; c--);
+        for (c = endpoint - 1; c >= 0 && ctx_->path.elevation[c] == 0.0; c--);
 
         endpoint = c + 1;
 
         for (c = 0, samples = 0; c < endpoint; c++) {
-            if (path_.distance[c] >= start_distance) {
+            if (ctx_->path.distance[c] >= start_distance) {
                 terrain +=
-                    (path_.elevation[c] == 0.0 ? path_.elevation[c] : path_.elevation[c] + clutter_);
+                    (ctx_->path.elevation[c] == 0.0 ? ctx_->path.elevation[c] : ctx_->path.elevation[c] + clutter_);
                 samples++;
             }
         }
@@ -1068,15 +1225,18 @@ SplatProcessor::site SplatProcessor::LoadQTH(char *filename) {
 void SplatProcessor::LoadPAT(char *filename) {
     /* This function reads and processes antenna pattern (.az
        and .el) files that correspond in name to previously
-       loaded SPLAT! .lrp files.  */
+       loaded SPLAT! .lrp files.  The pattern built is shared
+       with every later job naming the same, unchanged, files. */
 
     int a, b, w, x, y, z, last_index, next_index, span;
     char string[255], azfile[255], elfile[255], *pointer = NULL;
     float az, xx, elevation, amplitude, rotation, valid1, valid2, delta, azimuth[361],
-        azimuth_pattern[361], el_pattern[10001], elevation_pattern[361][1001], slant_angle[361],
-        tilt, mechanical_tilt = 0.0, tilt_azimuth, tilt_increment, sum;
+        azimuth_pattern[361], el_pattern[10001], slant_angle[361], tilt, mechanical_tilt = 0.0,
+        tilt_azimuth, tilt_increment, sum;
     FILE *fd = NULL;
     unsigned char read_count[10001];
+    std::string key;
+    std::vector<float> pattern;
 
     for (x = 0; filename[x] != '.' && filename[x] != 0 && x < 250; x++) {
         azfile[x] = filename[x];
@@ -1097,6 +1257,23 @@ void SplatProcessor::LoadPAT(char *filename) {
 
     got_azimuth_pattern_ = 0;
     got_elevation_pattern_ = 0;
+    LR_.pattern.reset();
+
+    /* Without either file the antenna radiates equally everywhere */
+
+    key = AntennaPattern::fileKey(azfile) + "|" + AntennaPattern::fileKey(elfile);
+
+    if (key == "|") return;
+
+    LR_.pattern = AntennaPattern::find(key);
+
+    if (LR_.pattern) {
+        got_azimuth_pattern_ = LR_.pattern->azimuthPattern() ? 255 : 0;
+        got_elevation_pattern_ = LR_.pattern->elevationPattern() ? 255 : 0;
+        return;
+    }
+
+    pattern.assign((size_t)AntennaPattern::AZIMUTHS * AntennaPattern::ELEVATIONS, 1.0f);
 
     /* Load .az antenna pattern file */
 
@@ -1343,8 +1520,8 @@ void SplatProcessor::LoadPAT(char *filename) {
             y = (int)rintf(100.0 * tilt);
 
             /* Copy shifted el_pattern[10001] field
-               values into elevation_pattern[361][1001]
-               at the corresponding azimuth, downsampling
+               values into pattern[361][1001] at the
+               corresponding azimuth, downsampling
                (averaging) along the way in chunks of 10. */
 
             for (x = y, z = 0; z <= 1000; x += 10, z++) {
@@ -1356,28 +1533,201 @@ void SplatProcessor::LoadPAT(char *filename) {
                     if (b > 10000) sum += el_pattern[10000];
                 }
 
-                elevation_pattern[w][z] = sum / 10.0;
+                pattern[w * AntennaPattern::ELEVATIONS + z] = sum / 10.0;
             }
         }
 
         got_elevation_pattern_ = 255;
     }
 
-    for (x = 0; x <= 360; x++) {
-        for (y = 0; y <= 1000; y++) {
-            if (got_elevation_pattern_)
-                elevation = elevation_pattern[x][y];
-            else
-                elevation = 1.0;
+    if (got_azimuth_pattern_) {
+        for (x = 0; x <= 360; x++)
+            for (y = 0; y <= 1000; y++)
+                pattern[x * AntennaPattern::ELEVATIONS + y] *= azimuth_pattern[x];
+    }
 
-            if (got_azimuth_pattern_)
-                az = azimuth_pattern[x];
-            else
-                az = 1.0;
+    LR_.pattern = AntennaPattern::insert(
+        key, std::make_shared<AntennaPattern>(std::move(pattern), got_azimuth_pattern_ != 0,
+                                              got_elevation_pattern_ != 0));
+}
+
+void SplatProcessor::UpdateRegionLimits(int indx) {
+    /* This function widens the elevation extremes and the
+       quadrangle limits of the whole region in memory to
+       include the page just loaded into dem[indx], and
+       records the page in page_index_ for FindPage(). */
+
+    if (dem_[indx].min_north >= -90 && dem_[indx].min_north < 90 && dem_[indx].max_west >= 0 &&
+        dem_[indx].max_west < 360)
+        page_index_[(dem_[indx].min_north + 90) * 360 + dem_[indx].max_west] = indx;
+
+    if (dem_[indx].min_el < min_elevation_) min_elevation_ = dem_[indx].min_el;
+
+    if (dem_[indx].max_el > max_elevation_) max_elevation_ = dem_[indx].max_el;
+
+    if (max_north_ == -90)
+        max_north_ = dem_[indx].max_north;
+
+    else if (dem_[indx].max_north > max_north_)
+        max_north_ = dem_[indx].max_north;
+
+    if (min_north_ == 90)
+        min_north_ = dem_[indx].min_north;
 
-            LR_.antenna_pattern[x][y] = az * elevation;
+    else if (dem_[indx].min_north < min_north_)
+        min_north_ = dem_[indx].min_north;
+
+    if (max_west_ == -1)
+        max_west_ = dem_[indx].max_west;
+
+    else {
+        if (abs(dem_[indx].max_west - max_west_) < 180) {
+            if (dem_[indx].max_west > max_west_) max_west_ = dem_[indx].max_west;
+        }
+
+        else {
+            if (dem_[indx].max_west < max_west_) max_west_ = dem_[indx].max_west;
+        }
+    }
+
+    if (min_west_ == 360)
+        min_west_ = dem_[indx].min_west;
+
+    else {
+        if (abs(dem_[indx].min_west - min_west_) < 180) {
+            if (dem_[indx].min_west < min_west_) min_west_ = dem_[indx].min_west;
+        }
+
+        else {
+            if (dem_[indx].min_west > min_west_) min_west_ = dem_[indx].min_west;
+        }
+    }
+}
+
+bool SplatProcessor::FindSDF(char *name, TerrainCache::Source &source) {
+    /* This function identifies the file LoadSDF() would read for
+       the tile in "name", searching the same places in the same
+       order as LoadSDF_BIN(), LoadSDF_SDF() and LoadSDF_BZ(). */
+
+    static const char *suffix[3] = {".bsdf", ".sdf", ".sdf.bz2"};
+    char sdf_file[255], path_plus_name[512];
+    struct stat st;
+    int x, format;
+
+    for (x = 0; name[x] != '.' && name[x] != 0 && x < 246; x++) sdf_file[x] = name[x];
+
+    for (format = 0; format < 3; format++) {
+        sdf_file[x] = 0;
+        strncat(sdf_file, suffix[format], 9);
+
+        strncpy(path_plus_name, sdf_file, 255);
+
+        if (stat(path_plus_name, &st) != 0 || !S_ISREG(st.st_mode)) {
+            strncpy(path_plus_name, sdf_path_, 255);
+            strncat(path_plus_name, sdf_file, 254);
+
+            if (stat(path_plus_name, &st) != 0 || !S_ISREG(st.st_mode)) continue;
         }
+
+        source.device = st.st_dev;
+        source.inode = st.st_ino;
+        source.modified = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+
+        return true;
+    }
+
+    return false;
+}
+
+int SplatProcessor::LoadSDF_Cache(char *name, const TerrainCache::Source &source) {
+    /* This function attaches a tile that this or another processor
+       has already read to the first available dem[] structure.  The
+       elevation data is shared with the process-wide TerrainCache;
+       only the mask[][] and signal[][] arrays are private.  Returns
+       0 if the tile is already loaded or no page is free, and -1 if
+       the tile is not cached. */
+
+    int indx, minlat, minlon, maxlat, maxlon;
+    char found, free_page = 0;
+    std::shared_ptr<const TerrainCache::Tile> tile;
+
+    sscanf(name, "%d_%d_%d_%d", &minlat, &maxlat, &minlon, &maxlon);
+
+    /* Is it already in memory? */
+
+    for (indx = 0, found = 0; indx < maxpages_ && found == 0; indx++) {
+        if (minlat == dem_[indx].min_north && minlon == dem_[indx].min_west &&
+            maxlat == dem_[indx].max_north && maxlon == dem_[indx].max_west)
+            found = 1;
+    }
+
+    /* Is room available to load it? */
+
+    if (found == 0) {
+        for (indx = 0, free_page = 0; indx < maxpages_ && free_page == 0; indx++)
+            if (dem_[indx].max_north == -90) free_page = 1;
     }
+
+    indx--;
+
+    if (free_page == 0 || found || indx < 0 || indx >= maxpages_) return 0;
+
+    tile = TerrainCache::instance().find(source, minlat, maxlat, minlon, maxlon, ippd_);
+
+    if (tile == nullptr) return -1;
+
+    if (!AllocatePage(indx, false)) return 0;
+
+    fprintf(stdout, "Sharing cached \"%s\" as page %d...", name, indx + 1);
+    fflush(stdout);
+
+    dem_[indx].max_west = tile->max_west;
+    dem_[indx].min_north = tile->min_north;
+    dem_[indx].min_west = tile->min_west;
+    dem_[indx].max_north = tile->max_north;
+    dem_[indx].max_el = tile->max_el;
+    dem_[indx].min_el = tile->min_el;
+    dem_[indx].data.cells = tile->data;
+    dem_[indx].data.ippd = ippd_;
+
+    UpdateRegionLimits(indx);
+
+    fprintf(stdout, " Done!\n");
+    fflush(stdout);
+
+    return 1;
+}
+
+void SplatProcessor::CacheTile(char *name, const TerrainCache::Source &source) {
+    /* This function hands the page just read from the SDF file
+       "source" for the tile in "name" to the process-wide
+       TerrainCache, so that later jobs reading the same file can
+       share it instead of reading it again. */
+
+    int indx, minlat, minlon, maxlat, maxlon;
+    std::shared_ptr<TerrainCache::Tile> tile;
+
+    sscanf(name, "%d_%d_%d_%d", &minlat, &maxlat, &minlon, &maxlon);
+
+    for (indx = 0; indx < maxpages_; indx++)
+        if (minlat == dem_[indx].min_north && minlon == dem_[indx].min_west &&
+            maxlat == dem_[indx].max_north && maxlon == dem_[indx].max_west)
+            break;
+
+    if (indx == maxpages_ || !dem_[indx].data.cells) return;
+
+    tile = std::make_shared<TerrainCache::Tile>();
+    tile->min_north = dem_[indx].min_north;
+    tile->max_north = dem_[indx].max_north;
+    tile->min_west = dem_[indx].min_west;
+    tile->max_west = dem_[indx].max_west;
+    tile->min_el = dem_[indx].min_el;
+    tile->max_el = dem_[indx].max_el;
+    tile->ippd = ippd_;
+    tile->source = source;
+    tile->data = dem_[indx].data.cells;
+
+    TerrainCache::instance().insert(tile);
 }
 
 int SplatProcessor::LoadSDF_SDF(char *name) {
@@ -1406,7 +1756,7 @@ int SplatProcessor::LoadSDF_SDF(char *name) {
 
     /* Is it already in memory? */
 
-    for (indx = 0, found = 0; indx < MAXPAGES && found == 0; indx++) {
+    for (indx = 0, found = 0; indx < maxpages_ && found == 0; indx++) {
         if (minlat == dem_[indx].min_north && minlon == dem_[indx].min_west &&
             maxlat == dem_[indx].max_north && maxlon == dem_[indx].max_west)
             found = 1;
@@ -1415,13 +1765,13 @@ int SplatProcessor::LoadSDF_SDF(char *name) {
     /* Is room available to load it? */
 
     if (found == 0) {
-        for (indx = 0, free_page = 0; indx < MAXPAGES && free_page == 0; indx++)
+        for (indx = 0, free_page = 0; indx < maxpages_ && free_page == 0; indx++)
             if (dem_[indx].max_north == -90) free_page = 1;
     }
 
     indx--;
 
-    if (free_page && found == 0 && indx >= 0 && indx < MAXPAGES) {
+    if (free_page && found == 0 && indx >= 0 && indx < maxpages_) {
         /* Search for SDF file in current working directory first */
 
         strncpy(path_plus_name, sdf_file, 255);
@@ -1439,6 +1789,11 @@ int SplatProcessor::LoadSDF_SDF(char *name) {
         }
 
         if (fd != NULL) {
+            if (!AllocatePage(indx)) {
+                fclose(fd);
+                return 0;
+            }
+
             fprintf(stdout, "Loading \"%s\" into page %d...", path_plus_name, indx + 1);
             fflush(stdout);
 
@@ -1460,8 +1815,6 @@ int SplatProcessor::LoadSDF_SDF(char *name) {
                     data = atoi(line);
 
                     dem_[indx].data[x][y] = data;
-                    dem_[indx].signal[x][y] = 0;
-                    dem_[indx].mask[x][y] = 0;
 
                     if (data > dem_[indx].max_el) dem_[indx].max_el = data;
 
@@ -1470,113 +1823,192 @@ int SplatProcessor::LoadSDF_SDF(char *name) {
 
             fclose(fd);
 
-            if (dem_[indx].min_el < min_elevation_) min_elevation_ = dem_[indx].min_el;
+            UpdateRegionLimits(indx);
 
-            if (dem_[indx].max_el > max_elevation_) max_elevation_ = dem_[indx].max_el;
+            fprintf(stdout, " Done!\n");
+            fflush(stdout);
 
-            if (max_north_ == -90)
-                max_north_ = dem_[indx].max_north;
+            return 1;
+        }
 
-            else if (dem_[indx].max_north > max_north_)
-                max_north_ = dem_[indx].max_north;
+        else
+            return -1;
+    }
 
-            if (min_north_ == 90)
-                min_north_ = dem_[indx].min_north;
+    else
+        return 0;
+}
 
-            else if (dem_[indx].min_north < min_north_)
-                min_north_ = dem_[indx].min_north;
+int SplatProcessor::LoadSDF_BIN(char *name) {
+    /* This function maps binary SPLAT Data Files (.bsdf, see
+       sdf_bin.h) and makes the mapping itself the elevation grid
+       of the first available dem[] structure, so nothing is read
+       or copied up front.  The mapping is private: a page given
+       user-defined terrain gets its own copy of what it changes,
+       and the file is left as it is.  It stays mapped for as long
+       as the page or the TerrainCache holds the grid.  Unlike the
+       text formats, nothing is parsed: quadrangle limits and
+       elevation extremes come from the header.  Files whose header
+       does not match the requested tile or resolution are ignored. */
+
+    int x, indx, minlat, minlon, maxlat, maxlon, fd = -1;
+    char found, free_page = 0, sdf_file[255], path_plus_name[512];
+    const struct sdf_bin_header *header;
+    struct stat info;
+    void *map;
+
+    for (x = 0; name[x] != '.' && name[x] != 0 && x < 249; x++) sdf_file[x] = name[x];
 
-            if (max_west_ == -1)
-                max_west_ = dem_[indx].max_west;
+    sdf_file[x] = 0;
 
-            else {
-                if (abs(dem_[indx].max_west - max_west_) < 180) {
-                    if (dem_[indx].max_west > max_west_) max_west_ = dem_[indx].max_west;
-                }
+    /* Parse filename for minimum latitude and longitude values */
 
-                else {
-                    if (dem_[indx].max_west < max_west_) max_west_ = dem_[indx].max_west;
-                }
-            }
+    sscanf(sdf_file, "%d_%d_%d_%d", &minlat, &maxlat, &minlon, &maxlon);
 
-            if (min_west_ == 360)
-                min_west_ = dem_[indx].min_west;
+    strncat(sdf_file, ".bsdf", 6);
 
-            else {
-                if (fabs(dem_[indx].min_west - min_west_) < 180.0) {
-                    if (dem_[indx].min_west < min_west_) min_west_ = dem_[indx].min_west;
-                }
+    /* Is it already in memory? */
 
-                else {
-                    if (dem_[indx].min_west > min_west_) min_west_ = dem_[indx].min_west;
-                }
-            }
+    for (indx = 0, found = 0; indx < maxpages_ && found == 0; indx++) {
+        if (minlat == dem_[indx].min_north && minlon == dem_[indx].min_west &&
+            maxlat == dem_[indx].max_north && maxlon == dem_[indx].max_west)
+            found = 1;
+    }
 
-            fprintf(stdout, " Done!\n");
-            fflush(stdout);
+    /* Is room available to load it? */
 
-            return 1;
-        }
+    if (found == 0) {
+        for (indx = 0, free_page = 0; indx < maxpages_ && free_page == 0; indx++)
+            if (dem_[indx].max_north == -90) free_page = 1;
+    }
 
-        else
-            return -1;
+    indx--;
+
+    if (free_page == 0 || found || indx < 0 || indx >= maxpages_) return 0;
+
+    /* Search for the file in the current working directory first,
+       then in the path given by $HOME/.splat_path or -d */
+
+    strncpy(path_plus_name, sdf_file, 255);
+
+    fd = open(path_plus_name, O_RDONLY);
+
+    if (fd < 0) {
+        strncpy(path_plus_name, sdf_path_, 255);
+        strncat(path_plus_name, sdf_file, 254);
+
+        fd = open(path_plus_name, O_RDONLY);
     }
 
-    else
+    if (fd < 0) return -1;
+
+    if (fstat(fd, &info) != 0 || info.st_size != SDF_BIN_FILE_SIZE(ippd_)) {
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) return -1;
+
+    header = (const struct sdf_bin_header *)map;
+
+    if (memcmp(header->magic, SDF_BIN_MAGIC, 8) != 0 || header->version != SDF_BIN_VERSION ||
+        header->byte_order != SDF_BIN_BYTE_ORDER || header->ippd != ippd_ ||
+        header->min_north != minlat || header->max_north != maxlat ||
+        header->min_west != minlon || header->max_west != maxlon) {
+        fprintf(stderr, "\n*** Ignoring \"%s\": header does not match this tile\n", path_plus_name);
+        munmap(map, info.st_size);
+        return -1;
+    }
+
+    if (!AllocatePage(indx, false)) {
+        munmap(map, info.st_size);
         return 0;
+    }
+
+    fprintf(stdout, "Mapping \"%s\" as page %d...", path_plus_name, indx + 1);
+    fflush(stdout);
+
+    madvise(map, info.st_size, MADV_WILLNEED);
+
+    dem_[indx].max_west = header->max_west;
+    dem_[indx].min_north = header->min_north;
+    dem_[indx].min_west = header->min_west;
+    dem_[indx].max_north = header->max_north;
+
+    if (header->max_el > dem_[indx].max_el) dem_[indx].max_el = header->max_el;
+
+    if (header->min_el < dem_[indx].min_el) dem_[indx].min_el = header->min_el;
+
+    size_t length = info.st_size;
+
+    dem_[indx].data.cells = std::shared_ptr<short[]>(
+        (short *)((char *)map + SDF_BIN_DATA_OFFSET), [map, length](short *) { munmap(map, length); });
+
+    UpdateRegionLimits(indx);
+
+    fprintf(stdout, " Done!\n");
+    fflush(stdout);
+
+    return 1;
 }
 
-char *SplatProcessor::BZfgets(BZFILE *bzfd, unsigned length) {
+char *SplatProcessor::BZfgets(BZReader &bz, unsigned length) {
     /* This function returns at most one less than 'length' number
-       of characters from a bz2 compressed file whose file descriptor
-       is pointed to by *bzfd.  In operation, a buffer is filled with
+       of characters from a bz2 compressed file whose read state
+       is held by bz.  In operation, a buffer is filled with
        uncompressed data (size = BZBUFFER), which is then parsed
        and doled out as NULL terminated character strings every time
        this function is invoked.  A NULL string indicates an EOF
        or error condition. */
 
-    static int x, y, nBuf;
-    static char buffer[BZBUFFER + 1], output[BZBUFFER + 1];
     char done = 0;
 
-    if (opened_ != 1 && bzerror_ == BZ_OK) {
+    if (bz.buffer.empty()) {
+        bz.buffer.assign(BZBUFFER + 1, 0);
+        bz.output.assign(BZBUFFER + 1, 0);
+    }
+
+    if (bz.opened != 1 && bzerror_ == BZ_OK) {
         /* First time through.  Initialize everything! */
 
-        x = 0;
-        y = 0;
-        nBuf = 0;
-        opened_ = 1;
-        output[0] = 0;
+        bz.x = 0;
+        bz.y = 0;
+        bz.nbuf = 0;
+        bz.opened = 1;
+        bz.output[0] = 0;
     }
 
     do {
-        if (x == nBuf && bzerror_ != BZ_STREAM_END && bzerror_ == BZ_OK && opened_) {
-            /* Uncompress data into a static buffer */
+        if (bz.x == bz.nbuf && bzerror_ != BZ_STREAM_END && bzerror_ == BZ_OK && bz.opened) {
+            /* Uncompress data into the reader's buffer */
 
-            nBuf = BZ2_bzRead(&bzerror_, bzfd, buffer, BZBUFFER);
-            buffer[nBuf] = 0;
-            x = 0;
+            bz.nbuf = BZ2_bzRead(&bzerror_, bz.bzfd, &bz.buffer[0], BZBUFFER);
+            bz.buffer[bz.nbuf] = 0;
+            bz.x = 0;
         }
 
         /* Build a string from buffer contents */
 
-        output[y] = buffer[x];
+        bz.output[bz.y] = bz.buffer[bz.x];
 
-        if (output[y] == '\n' || output[y] == 0 || y == (int)length - 1) {
-            output[y + 1] = 0;
+        if (bz.output[bz.y] == '\n' || bz.output[bz.y] == 0 || bz.y == (int)length - 1) {
+            bz.output[bz.y + 1] = 0;
             done = 1;
-            y = 0;
+            bz.y = 0;
         }
 
         else
-            y++;
-        x++;
+            bz.y++;
+        bz.x++;
 
     } while (done == 0);
 
-    if (output[0] == 0) opened_ = 0;
+    if (bz.output[0] == 0) bz.opened = 0;
 
-    return (output);
+    return (&bz.output[0]);
 }
 
 int SplatProcessor::LoadSDF_BZ(char *name) {
@@ -1588,7 +2020,7 @@ int SplatProcessor::LoadSDF_BZ(char *name) {
     int x, y, data, indx, minlat, minlon, maxlat, maxlon;
     char found, free_page = 0, sdf_file[255], path_plus_name[512], *string;
     FILE *fd;
-    BZFILE *bzfd;
+    BZReader bz;
 
     for (x = 0; name[x] != '.' && name[x] != 0 && x < 247; x++) sdf_file[x] = name[x];
 
@@ -1610,7 +2042,7 @@ int SplatProcessor::LoadSDF_BZ(char *name) {
 
     /* Is it already in memory? */
 
-    for (indx = 0, found = 0; indx < MAXPAGES && found == 0; indx++) {
+    for (indx = 0, found = 0; indx < maxpages_ && found == 0; indx++) {
         if (minlat == dem_[indx].min_north && minlon == dem_[indx].min_west &&
             maxlat == dem_[indx].max_north && maxlon == dem_[indx].max_west)
             found = 1;
@@ -1619,19 +2051,19 @@ int SplatProcessor::LoadSDF_BZ(char *name) {
     /* Is room available to load it? */
 
     if (found == 0) {
-        for (indx = 0, free_page = 0; indx < MAXPAGES && free_page == 0; indx++)
+        for (indx = 0, free_page = 0; indx < maxpages_ && free_page == 0; indx++)
             if (dem_[indx].max_north == -90) free_page = 1;
     }
 
     indx--;
 
-    if (free_page && found == 0 && indx >= 0 && indx < MAXPAGES) {
+    if (free_page && found == 0 && indx >= 0 && indx < maxpages_) {
         /* Search for SDF file in current working directory first */
 
         strncpy(path_plus_name, sdf_file, 255);
 
         fd = fopen(path_plus_name, "rb");
-        bzfd = BZ2_bzReadOpen(&bzerror_, fd, 0, 0, NULL, 0);
+        bz.bzfd = BZ2_bzReadOpen(&bzerror_, fd, 0, 0, NULL, 0);
 
         if (fd == NULL || bzerror_ != BZ_OK) {
             /* Next, try loading SDF file from path specified
@@ -1641,26 +2073,30 @@ int SplatProcessor::LoadSDF_BZ(char *name) {
             strncat(path_plus_name, sdf_file, 254);
 
             fd = fopen(path_plus_name, "rb");
-            bzfd = BZ2_bzReadOpen(&bzerror_, fd, 0, 0, NULL, 0);
+            bz.bzfd = BZ2_bzReadOpen(&bzerror_, fd, 0, 0, NULL, 0);
         }
 
         if (fd != NULL && bzerror_ == BZ_OK) {
+            if (!AllocatePage(indx)) {
+                BZ2_bzReadClose(&bzerror_, bz.bzfd);
+                fclose(fd);
+                return 0;
+            }
+
             fprintf(stdout, "Loading \"%s\" into page %d...", path_plus_name, indx + 1);
             fflush(stdout);
 
-            sscanf(BZfgets(bzfd, 255), "%d", &dem_[indx].max_west);
-            sscanf(BZfgets(bzfd, 255), "%d", &dem_[indx].min_north);
-            sscanf(BZfgets(bzfd, 255), "%d", &dem_[indx].min_west);
-            sscanf(BZfgets(bzfd, 255), "%d", &dem_[indx].max_north);
+            sscanf(BZfgets(bz, 255), "%d", &dem_[indx].max_west);
+            sscanf(BZfgets(bz, 255), "%d", &dem_[indx].min_north);
+            sscanf(BZfgets(bz, 255), "%d", &dem_[indx].min_west);
+            sscanf(BZfgets(bz, 255), "%d", &dem_[indx].max_north);
 
             for (x = 0; x < ippd_; x++)
                 for (y = 0; y < ippd_; y++) {
-                    string = BZfgets(bzfd, 20);
+                    string = BZfgets(bz, 20);
                     data = atoi(string);
 
                     dem_[indx].data[x][y] = data;
-                    dem_[indx].signal[x][y] = 0;
-                    dem_[indx].mask[x][y] = 0;
 
                     if (data > dem_[indx].max_el) dem_[indx].max_el = data;
 
@@ -1669,49 +2105,9 @@ int SplatProcessor::LoadSDF_BZ(char *name) {
 
             fclose(fd);
 
-            BZ2_bzReadClose(&bzerror_, bzfd);
-
-            if (dem_[indx].min_el < min_elevation_) min_elevation_ = dem_[indx].min_el;
-
-            if (dem_[indx].max_el > max_elevation_) max_elevation_ = dem_[indx].max_el;
-
-            if (max_north_ == -90)
-                max_north_ = dem_[indx].max_north;
-
-            else if (dem_[indx].max_north > max_north_)
-                max_north_ = dem_[indx].max_north;
-
-            if (min_north_ == 90)
-                min_north_ = dem_[indx].min_north;
+            BZ2_bzReadClose(&bzerror_, bz.bzfd);
 
-            else if (dem_[indx].min_north < min_north_)
-                min_north_ = dem_[indx].min_north;
-
-            if (max_west_ == -1)
-                max_west_ = dem_[indx].max_west;
-
-            else {
-                if (abs(dem_[indx].max_west - max_west_) < 180) {
-                    if (dem_[indx].max_west > max_west_) max_west_ = dem_[indx].max_west;
-                }
-
-                else {
-                    if (dem_[indx].max_west < max_west_) max_west_ = dem_[indx].max_west;
-                }
-            }
-
-            if (min_west_ == 360)
-                min_west_ = dem_[indx].min_west;
-
-            else {
-                if (abs(dem_[indx].min_west - min_west_) < 180) {
-                    if (dem_[indx].min_west < min_west_) min_west_ = dem_[indx].min_west;
-                }
-
-                else {
-                    if (dem_[indx].min_west > min_west_) min_west_ = dem_[indx].min_west;
-                }
-            }
+            UpdateRegionLimits(indx);
 
             fprintf(stdout, " Done!\n");
             fflush(stdout);
@@ -1729,25 +2125,46 @@ int SplatProcessor::LoadSDF_BZ(char *name) {
 
 char SplatProcessor::LoadSDF(char *name) {
     /* This function loads the requested SDF file from the filesystem.
-       It first tries to invoke the LoadSDF_SDF() function to load an
+       It first tries to invoke the LoadSDF_BIN() function to map a
+       binary .bsdf tile, then the LoadSDF_SDF() function to load an
        uncompressed SDF file (since uncompressed files load slightly
-       faster).  If that attempt fails, then it tries to load a
+       faster).  If those attempts fail, then it tries to load a
        compressed SDF file by invoking the LoadSDF_BZ() function.
        If that fails, then we can assume that no elevation data
        exists for the region requested, and that the region
-       requested must be entirely over water. */
+       requested must be entirely over water.  Tiles held by the
+       process-wide TerrainCache are shared rather than read. */
     int x, y, indx, minlat, minlon, maxlat, maxlon;
-    char found, free_page = 0;
+    char found, free_page = 0, on_disk, shared;
     int return_value = -1;
+    TerrainCache::Source source;
+
+    /* Share the tile if another job has already read the same file. */
+
+    on_disk = FindSDF(name, source);
+
+    if (on_disk) return_value = LoadSDF_Cache(name, source);
 
-    /* Try to load an uncompressed SDF first. */
+    shared = (return_value == 1);
 
-    return_value = LoadSDF_SDF(name);
+    /* Otherwise try a binary SDF, which needs no parsing at all. */
+
+    if (return_value == 0 || return_value == -1) return_value = LoadSDF_BIN(name);
+
+    /* Then an uncompressed SDF. */
+
+    if (return_value == 0 || return_value == -1) return_value = LoadSDF_SDF(name);
 
     /* If that fails, try loading a compressed SDF. */
 
     if (return_value == 0 || return_value == -1) return_value = LoadSDF_BZ(name);
 
+    /* Whichever file was read, share it with later jobs.  Sea-level
+       pages are not cached, so that a tile which shows up on disk
+       later is still found. */
+
+    if (return_value == 1 && on_disk && !shared) CacheTile(name, source);
+
     /* If neither format can be found, then assume the area is water. */
 
     if (return_value == 0 || return_value == -1) {
@@ -1757,7 +2174,7 @@ char SplatProcessor::LoadSDF(char *name) {
 
         /* Is it already in memory? */
 
-        for (indx = 0, found = 0; indx < MAXPAGES && found == 0; indx++) {
+        for (indx = 0, found = 0; indx < maxpages_ && found == 0; indx++) {
             if (minlat == dem_[indx].min_north && minlon == dem_[indx].min_west &&
                 maxlat == dem_[indx].max_north && maxlon == dem_[indx].max_west)
                 found = 1;
@@ -1766,13 +2183,13 @@ char SplatProcessor::LoadSDF(char *name) {
         /* Is room available to load it? */
 
         if (found == 0) {
-            for (indx = 0, free_page = 0; indx < MAXPAGES && free_page == 0; indx++)
+            for (indx = 0, free_page = 0; indx < maxpages_ && free_page == 0; indx++)
                 if (dem_[indx].max_north == -90) free_page = 1;
         }
 
         indx--;
 
-        if (free_page && found == 0 && indx >= 0 && indx < MAXPAGES) {
+        if (free_page && found == 0 && indx >= 0 && indx < maxpages_ && AllocatePage(indx)) {
             fprintf(stdout, "Region  \"%s\" assumed as sea-level into page %d...", name, indx + 1);
             fflush(stdout);
 
@@ -1786,53 +2203,11 @@ char SplatProcessor::LoadSDF(char *name) {
             for (x = 0; x < ippd_; x++)
                 for (y = 0; y < ippd_; y++) {
                     dem_[indx].data[x][y] = 0;
-                    dem_[indx].signal[x][y] = 0;
-                    dem_[indx].mask[x][y] = 0;
 
                     if (dem_[indx].min_el > 0) dem_[indx].min_el = 0;
                 }
 
-            if (dem_[indx].min_el < min_elevation_) min_elevation_ = dem_[indx].min_el;
-
-            if (dem_[indx].max_el > max_elevation_) max_elevation_ = dem_[indx].max_el;
-
-            if (max_north_ == -90)
-                max_north_ = dem_[indx].max_north;
-
-            else if (dem_[indx].max_north > max_north_)
-                max_north_ = dem_[indx].max_north;
-
-            if (min_north_ == 90)
-                min_north_ = dem_[indx].min_north;
-
-            else if (dem_[indx].min_north < min_north_)
-                min_north_ = dem_[indx].min_north;
-
-            if (max_west_ == -1)
-                max_west_ = dem_[indx].max_west;
-
-            else {
-                if (abs(dem_[indx].max_west - max_west_) < 180) {
-                    if (dem_[indx].max_west > max_west_) max_west_ = dem_[indx].max_west;
-                }
-
-                else {
-                    if (dem_[indx].max_west < max_west_) max_west_ = dem_[indx].max_west;
-                }
-            }
-
-            if (min_west_ == 360)
-                min_west_ = dem_[indx].min_west;
-
-            else {
-                if (abs(dem_[indx].min_west - min_west_) < 180) {
-                    if (dem_[indx].min_west < min_west_) min_west_ = dem_[indx].min_west;
-                }
-
-                else {
-                    if (dem_[indx].min_west > min_west_) min_west_ = dem_[indx].min_west;
-                }
-            }
+            UpdateRegionLimits(indx);
 
             fprintf(stdout, " Done!\n");
             fflush(stdout);
@@ -2078,7 +2453,7 @@ void SplatProcessor::LoadBoundaries(char *filename) {
 
                 ReadPath(source, destination);
 
-                for (x = 0; x < path_.length; x++) OrMask(path_.lat[x], path_.lon[x], 4);
+                for (x = 0; x < ctx_->path.length; x++) OrMask(ctx_->path.lat[x], ctx_->path.lon[x], 4);
 
                 lat0 = lat1;
                 lon0 = lon1;
@@ -2133,13 +2508,7 @@ bool SplatProcessor::ReadCustomLRParm(struct site txsite, bool forced_read) {
             LR_.conf = 0.50;          // Reliability for predictions
             LR_.rel = 0.50;           // Percentage of situations
             LR_.erp = 126;           // ERP in watts
-            
-            // Initialize antenna pattern to 1.0 (0 dB)
-            for (int i = 0; i < 360; i++) {
-                for (int j = 0; j < 1001; j++) {
-                    LR_.antenna_pattern[i][j] = 1.0;
-                }
-            }
+            LR_.pattern.reset();      // No antenna pattern (0 dB everywhere)
 
             if (forced_freq_ >= 20.0 && forced_freq_ <= 20000.0)
                 LR_.frq_mhz = forced_freq_;
@@ -2225,12 +2594,8 @@ bool SplatProcessor::ReadCustomLRParm(struct site txsite, bool forced_read) {
 
         sscanf(string, "%lf", &LR_.erp);
 
-        // Initialize antenna pattern with default values (1.0 = 0 dB)
-        for (int i = 0; i < 360; i++) {
-            for (int j = 0; j < 1001; j++) {
-                LR_.antenna_pattern[i][j] = 1.0;
-            }
-        }
+        // No antenna pattern (0 dB everywhere) unless one is read below
+        LR_.pattern.reset();
         
         // Try to read antenna pattern file if specified
         fgets(string, 149, fd);
@@ -2243,20 +2608,30 @@ bool SplatProcessor::ReadCustomLRParm(struct site txsite, bool forced_read) {
         for (x = 0; string[x] != '\0' && string[x] != '\n' && string[x] != '\r'; x++);
         string[x] = 0;
         
-        // If a filename is specified for the antenna pattern, try to read it
-        if (strlen(string) > 0 && strcmp(string, "none") != 0) {
+        // If a filename is specified for the antenna pattern, try to read it,
+        // unless a job before this one already has
+        std::string key = "gain:" + AntennaPattern::fileKey(string);
+        bool named = strcmp(string, "none") != 0 && key != "gain:";
+
+        if (named) LR_.pattern = AntennaPattern::find(key);
+
+        if (named && !LR_.pattern) {
             FILE* pattern_file = fopen(string, "r");
             if (pattern_file != NULL) {
-                // Read antenna pattern file
+                // Read antenna pattern file, 1.0 (0 dB) where it gives no gain
+                std::vector<float> pattern(
+                    (size_t)AntennaPattern::AZIMUTHS * AntennaPattern::ELEVATIONS, 1.0f);
                 int az, el;
                 float gain;
                 while (fscanf(pattern_file, "%d,%d,%f", &az, &el, &gain) == 3) {
                     if (az >= 0 && az < 360 && el >= 0 && el <= 1000) {
-                        LR_.antenna_pattern[az][el] = gain;
+                        pattern[az * AntennaPattern::ELEVATIONS + el] = gain;
                     }
                 }
                 
                 fclose(pattern_file);
+                LR_.pattern = AntennaPattern::insert(
+                    key, std::make_shared<AntennaPattern>(std::move(pattern), false, false));
             }
         }
 
@@ -2489,7 +2864,8 @@ char SplatProcessor::ReadLRParm(struct site txsite, char forced_read) {
     return (return_value);
 }
 
-void SplatProcessor::PlotPath(struct site source, struct site destination, char mask_value) {
+void SplatProcessor::PlotPath(PathContext &ctx, struct site source, struct site destination,
+                              char mask_value) {
     /* This function analyzes the path between the source and
        destination locations.  It determines which points along
        the path have line-of-sight visibility to the source.
@@ -2504,16 +2880,16 @@ void SplatProcessor::PlotPath(struct site source, struct site destination, char
     register double cos_xmtr_angle, cos_test_angle, test_alt;
     double distance, rx_alt, tx_alt;
 
-    ReadPath(source, destination);
+    ReadPath(source, destination, ctx.path);
 
-    for (y = 0; y < path_.length; y++) {
+    for (y = 0; y < ctx.path.length; y++) {
         /* Test this point only if it hasn't been already
            tested and found to be free of obstructions. */
 
-        if ((GetMask(path_.lat[y], path_.lon[y]) & mask_value) == 0) {
-            distance = 5280.0 * path_.distance[y];
-            tx_alt = earthradius_ + source.alt + path_.elevation[0];
-            rx_alt = earthradius_ + destination.alt + path_.elevation[y];
+        if ((GetMask(ctx.path.lat[y], ctx.path.lon[y]) & mask_value) == 0) {
+            distance = 5280.0 * ctx.path.distance[y];
+            tx_alt = earthradius_ + source.alt + ctx.path.elevation[0];
+            rx_alt = earthradius_ + destination.alt + ctx.path.elevation[y];
 
             /* Calculate the cosine of the elevation of the
                transmitter as seen at the temp rx point. */
@@ -2522,9 +2898,9 @@ void SplatProcessor::PlotPath(struct site source, struct site destination, char
                              (2.0 * rx_alt * distance);
 
             for (x = y, block = 0; x >= 0 && block == 0; x--) {
-                distance = 5280.0 * (path_.distance[y] - path_.distance[x]);
-                test_alt = earthradius_ + (path_.elevation[x] == 0.0 ? path_.elevation[x]
-                                                                   : path_.elevation[x] + clutter_);
+                distance = 5280.0 * (ctx.path.distance[y] - ctx.path.distance[x]);
+                test_alt = earthradius_ + (ctx.path.elevation[x] == 0.0 ? ctx.path.elevation[x]
+                                                                   : ctx.path.elevation[x] + clutter_);
 
                 cos_test_angle =
                     ((rx_alt * rx_alt) + (distance * distance) - (test_alt * test_alt)) /
@@ -2540,38 +2916,256 @@ void SplatProcessor::PlotPath(struct site source, struct site destination, char
                 if (cos_xmtr_angle >= cos_test_angle) block = 1;
             }
 
-            if (block == 0) OrMask(path_.lat[y], path_.lon[y], mask_value);
+            if (block == 0) OrMask(ctx.path.lat[y], ctx.path.lon[y], mask_value);
         }
     }
 }
 
-void SplatProcessor::PlotLRPath(struct site source, struct site destination,
-                                unsigned char mask_value, FILE *fd) {
+int SplatProcessor::PlotLRPath(PathContext &ctx, struct site source, struct site destination,
+                               unsigned char mask_value, FILE *fd) {
     /* This function plots the RF path loss between source and
        destination points based on the ITWOM propagation model,
-       taking into account antenna pattern data, if available. */
+       taking into account antenna pattern data, if available.
+       The points are evaluated by PlotLRPoints().
+       Returns the number of points left unevaluated by pruning. */
 
-    int x, y, ifs, ofs, errnum;
-    char block = 0, strmode[100];
-    double loss, azimuth, pattern = 0.0, xmtr_alt, dest_alt, xmtr_alt2, dest_alt2, cos_rcvr_angle,
-                          cos_test_angle = 0.0, test_alt, elevation = 0.0, distance = 0.0,
-                          four_thirds_earth, rxp, dBm, field_strength = 0.0;
-    struct site temp;
+    int y, skipped;
+    std::string ano;
+    std::vector<int> points;
 
-    ReadPath(source, destination);
+    ReadPath(source, destination, ctx.path);
+    CopyLRElevations(ctx);
 
-    four_thirds_earth = FOUR_THIRDS * EARTHRADIUS;
+    for (y = 2; (y < (ctx.path.length - 1) && ctx.path.distance[y] <= max_range_); y++) {
+        /* Process this point only if it
+           has not already been processed. */
+
+        unsigned char *cell = MaskCell(ctx.path.lat[y], ctx.path.lon[y]);
+
+        /* Off the terrain in memory, a result can only be listed */
+
+        if (cell == NULL && fd == NULL) continue;
+
+        if (cell == NULL || (*cell & 248) != (mask_value << 3)) {
+            points.push_back(y);
 
+            /* Mark this point as having been analyzed */
+
+            if (cell != NULL) *cell = (*cell & 7) + (mask_value << 3);
+        }
+    }
+
+    skipped = PlotLRPoints(ctx, source, destination, points, fd != NULL ? &ano : NULL);
+
+    if (fd != NULL) fputs(ano.c_str(), fd);
+
+    return skipped;
+}
+
+void SplatProcessor::CopyLRElevations(PathContext &ctx) {
     /* Copy elevations plus clutter along path into the elev[] array. */
 
-    for (x = 1; x < path_.length - 1; x++)
-        elev_[x + 2] = (path_.elevation[x] == 0.0 ? path_.elevation[x] * METERS_PER_FOOT
-                                                : (clutter_ + path_.elevation[x]) * METERS_PER_FOOT);
+    int x;
+    const struct path &p = ctx.path;
+    double *elev;
+
+    if ((int)ctx.elev.size() < p.length + 10) ctx.elev.resize(p.length + 10);
+
+    elev = ctx.elev.data();
+
+    for (x = 1; x < p.length - 1; x++)
+        elev[x + 2] = (p.elevation[x] == 0.0 ? p.elevation[x] * METERS_PER_FOOT
+                                             : (clutter_ + p.elevation[x]) * METERS_PER_FOOT);
 
     /* Copy ending points without clutter */
 
-    elev_[2] = path_.elevation[0] * METERS_PER_FOOT;
-    elev_[path_.length + 1] = path_.elevation[path_.length - 1] * METERS_PER_FOOT;
+    elev[2] = p.elevation[0] * METERS_PER_FOOT;
+    elev[p.length + 1] = p.elevation[p.length - 1] * METERS_PER_FOOT;
+
+    /* The obstruction horizon of the new path is built as
+       PlotLRPoint() reaches each receiver point. */
+
+    ctx.horizon.clear();
+    ctx.horizon_cos.clear();
+    ctx.horizon_end = 2;
+
+    /* Summarize the profile once, so that the ITM can evaluate
+       each receiver point along it without rescanning the points
+       in front of it. */
+
+    if (profile_summaries_ && p.length > 0) {
+        ctx.elev_sum.resize(p.length + 1);
+        ctx.elev_moment.resize(p.length + 1);
+        ctx.elev_max.resize(p.length / ITM_PROFILE_BLOCK + 1);
+        ctx.elev_hull.resize(p.length);
+
+        itm_profile_prepare(elev, p.length - 1, ctx.elev_sum.data(), ctx.elev_moment.data(),
+                            ctx.elev_max.data());
+    }
+}
+
+static void AppendANO(std::string *ano, const char *format, ...) {
+    /* printf-style append used to buffer alphanumeric (.ano)
+       output lines until they can be written in radial order. */
+
+    char line[128];
+    va_list args;
+
+    if (ano == NULL) return;
+
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    ano->append(line);
+}
+
+SplatProcessor::LRKernel SplatProcessor::SelectLRKernel(bool listed) const {
+    /* The model, the units and whether the first obstruction is
+       needed are fixed for a whole sweep, so each combination is
+       compiled as its own kernel rather than tested per point. */
+
+    static const LRKernel kernels[2][2][3] = {
+        {{&SplatProcessor::PlotLRKernel<false, false, LR_LOSS>,
+          &SplatProcessor::PlotLRKernel<false, false, LR_FIELD>,
+          &SplatProcessor::PlotLRKernel<false, false, LR_DBM>},
+         {&SplatProcessor::PlotLRKernel<false, true, LR_LOSS>,
+          &SplatProcessor::PlotLRKernel<false, true, LR_FIELD>,
+          &SplatProcessor::PlotLRKernel<false, true, LR_DBM>}},
+        {{&SplatProcessor::PlotLRKernel<true, false, LR_LOSS>,
+          &SplatProcessor::PlotLRKernel<true, false, LR_FIELD>,
+          &SplatProcessor::PlotLRKernel<true, false, LR_DBM>},
+         {&SplatProcessor::PlotLRKernel<true, true, LR_LOSS>,
+          &SplatProcessor::PlotLRKernel<true, true, LR_FIELD>,
+          &SplatProcessor::PlotLRKernel<true, true, LR_DBM>}}};
+
+    int units = LR_.erp == 0.0 ? LR_LOSS : (dbm_ ? LR_DBM : LR_FIELD);
+
+    return kernels[olditm_ ? 1 : 0][(got_elevation_pattern_ || listed) ? 1 : 0][units];
+}
+
+int SplatProcessor::PlotLRPoints(PathContext &ctx, struct site source,
+                                 struct site destination, const std::vector<int> &points,
+                                 std::string *ano) {
+    /* This function evaluates the path loss to each of the given
+       points of ctx.path, in order, and passes the results to
+       PlotLRPoint().  ctx.elev[] must already hold the output of
+       CopyLRElevations().
+
+       When pruning, once the radial has stayed below prune_floor_
+       for prune_span_ miles the remaining points are dropped.  The
+       span lets the signal recover where terrain re-emerges from
+       a shadow before the radial is given up on.  Returns the
+       number of points dropped. */
+
+    return (this->*SelectLRKernel(ano != NULL))(ctx, source, destination, points, ano);
+}
+
+template <bool OldITM, bool Obstruction, int Units>
+int SplatProcessor::PlotLRKernel(PathContext &ctx, struct site source,
+                                 struct site destination, const std::vector<int> &points,
+                                 std::string *ano) {
+    const struct path &p = ctx.path;
+    itm_horizon_type horizon = {ctx.elev_hull.data(), 0, 0, 0.0, 0.0};
+    itm_profile_type profile = {ctx.elev_sum.data(), ctx.elev_moment.data(), ctx.elev_max.data(),
+                                &horizon};
+    itm_receiver_type rx[ITM_PROFILE_BLOCK];
+    double *elev = ctx.elev.data(), strength;
+    double faint = -1.0; /* Distance at which the radial last fell below prune_floor_ */
+    double offset = 0.0; /* Strength of a 0 dB path loss */
+    size_t i, j, batch;
+
+    if (points.empty()) return 0;
+
+    /* Received power and field strength are the transmitter's
+       level less the path loss, so the logarithms are taken once
+       here rather than at every point. */
+
+    if (Units == LR_DBM)
+        offset = 10.0 * log10(LR_.erp * 1000.0) + 2.14; /* dBm of the EIRP (ERP + 2.14 dB) */
+
+    else if (Units == LR_FIELD)
+        offset = 139.4 + (20.0 * log10(LR_.frq_mhz)) + (10.0 * log10(LR_.erp / 1000.0));
+
+    /* Determine attenuation for each point along
+       the path using ITWOM's point_to_point mode
+       starting at y=2 (number_of_points = 1), the
+       shortest distance terrain can play a role in
+       path loss.  The points are handed to the model
+       in batches sharing the radial's summaries and
+       the sweep's session, one at a time when pruning
+       may stop the radial at any point. */
+
+    batch = prune_active_ ? 1 : ITM_PROFILE_BLOCK;
+
+    for (i = 0; i < points.size(); i++) {
+        if (i % batch == 0) {
+            size_t count = std::min(batch, points.size() - i);
+
+            for (j = 0; j < count; j++) {
+                rx[j].np = points[i + j] - 1; /* (number of points - 1) */
+
+                /* Distance between elevation samples */
+
+                rx[j].xi = METERS_PER_MILE *
+                           (p.distance[points[i + j]] - p.distance[points[i + j] - 1]);
+                rx[j].rht_m = destination.alt * METERS_PER_FOOT;
+            }
+
+            if (OldITM)
+                point_to_point_ITM_batch(elev, source.alt * METERS_PER_FOOT, LR_.eps_dielect,
+                                         LR_.sgm_conductivity, LR_.eno_ns_surfref, LR_.frq_mhz,
+                                         LR_.radio_climate, LR_.pol, LR_.conf, LR_.rel, rx,
+                                         (int)count, profile_summaries_, &profile,
+                                         itm_session_.get());
+            else
+                point_to_point_batch(elev, source.alt * METERS_PER_FOOT, LR_.eps_dielect,
+                                     LR_.sgm_conductivity, LR_.eno_ns_surfref, LR_.frq_mhz,
+                                     LR_.radio_climate, LR_.pol, LR_.conf, LR_.rel, rx, (int)count,
+                                     profile_summaries_, &profile, itm_session_.get());
+        }
+
+        strength = PlotLRPoint<Obstruction, Units>(ctx, source, destination, points[i],
+                                                   rx[i % batch].dbloss, offset, ano);
+
+        if (!prune_active_) continue;
+
+        if (strength >= prune_floor_)
+            faint = -1.0;
+
+        else {
+            if (faint < 0.0) faint = p.distance[points[i]];
+
+            if (p.distance[points[i]] - faint >= prune_span_)
+                return (int)(points.size() - i - 1);
+        }
+    }
+
+    return 0;
+}
+
+template <bool Obstruction, int Units>
+double SplatProcessor::PlotLRPoint(PathContext &ctx, struct site source,
+                                   struct site destination, int y, double loss, double offset,
+                                   std::string *ano) {
+    /* This function merges the path loss to point y of ctx.path,
+       as found by the propagation model, into the signal[][] array.
+       "offset" is the strength, in the map's units, of a 0 dB loss.
+       Alphanumeric output, if requested, is appended to *ano.
+       Returns the strength plotted, in the map's units (dBm, dBuV/m,
+       or minus the path loss), so that larger is always stronger. */
+
+    int x, ifs, ofs;
+    char block = 0;
+    double azimuth = 0.0, xmtr_alt, dest_alt, xmtr_alt2, dest_alt2, cos_rcvr_angle,
+                          cos_test_angle = 0.0, test_alt, elevation = 0.0, distance = 0.0,
+                          four_thirds_earth, strength;
+    struct site temp;
+    const struct path &p = ctx.path;
+    const AntennaPattern *antenna = LR_.pattern.get();
+    unsigned char *cell = SignalCell(p.lat[y], p.lon[y]);
+
+    four_thirds_earth = FOUR_THIRDS * EARTHRADIUS;
 
     /* Since the only energy the propagation model considers
        reaching the destination is based on what is scattered
@@ -2583,215 +3177,487 @@ void SplatProcessor::PlotLRPath(struct site source, struct site destination,
        is required for properly integrating the antenna's elevation
        pattern into the calculation for overall path loss. */
 
-    for (y = 2; (y < (path_.length - 1) && path_.distance[y] <= max_range_); y++) {
-        /* Process this point only if it
-           has not already been processed. */
-
-        if ((GetMask(path_.lat[y], path_.lon[y]) & 248) != (mask_value << 3)) {
-            distance = 5280.0 * path_.distance[y];
-            xmtr_alt = four_thirds_earth + source.alt + path_.elevation[0];
-            dest_alt = four_thirds_earth + destination.alt + path_.elevation[y];
-            dest_alt2 = dest_alt * dest_alt;
-            xmtr_alt2 = xmtr_alt * xmtr_alt;
+    if (Obstruction) {
+        /* Determine the elevation angle to the first obstruction
+           along the path IF elevation pattern data is available
+           or an output (.ano) file has been designated.
 
-            /* Calculate the cosine of the elevation of
-               the receiver as seen by the transmitter. */
+           The first obstruction is the first point whose elevation
+           angle reaches the receiver's, so it also appears higher
+           than every point in front of it.  Such points form the
+           horizon of the path, which is extended out to y here, so
+           each point is tested only once per path rather than once
+           per receiver beyond it. */
 
-            cos_rcvr_angle =
-                ((xmtr_alt2) + (distance * distance) - (dest_alt2)) / (2.0 * xmtr_alt * distance);
+        distance = 5280.0 * p.distance[y];
+        xmtr_alt = four_thirds_earth + source.alt + p.elevation[0];
+        dest_alt = four_thirds_earth + destination.alt + p.elevation[y];
+        dest_alt2 = dest_alt * dest_alt;
+        xmtr_alt2 = xmtr_alt * xmtr_alt;
 
-            if (cos_rcvr_angle > 1.0) cos_rcvr_angle = 1.0;
+        /* Calculate the cosine of the elevation of
+           the receiver as seen by the transmitter. */
 
-            if (cos_rcvr_angle < -1.0) cos_rcvr_angle = -1.0;
+        cos_rcvr_angle =
+            ((xmtr_alt2) + (distance * distance) - (dest_alt2)) / (2.0 * xmtr_alt * distance);
 
-            if (got_elevation_pattern_ || fd != NULL) {
-                /* Determine the elevation angle to the first obstruction
-                   along the path IF elevation pattern data is available
-                   or an output (.ano) file has been designated. */
+        if (cos_rcvr_angle > 1.0) cos_rcvr_angle = 1.0;
 
-                for (x = 2, block = 0; (x < y && block == 0); x++) {
-                    distance = 5280.0 * path_.distance[x];
+        if (cos_rcvr_angle < -1.0) cos_rcvr_angle = -1.0;
 
-                    test_alt = four_thirds_earth + (path_.elevation[x] == 0.0
-                                                        ? path_.elevation[x]
-                                                        : path_.elevation[x] + clutter_);
+        for (; ctx.horizon_end < y; ctx.horizon_end++) {
+            x = ctx.horizon_end;
+            distance = 5280.0 * p.distance[x];
 
-                    /* Calculate the cosine of the elevation
-                       angle of the terrain (test point)
-                       as seen by the transmitter. */
+            test_alt = four_thirds_earth +
+                       (p.elevation[x] == 0.0 ? p.elevation[x] : p.elevation[x] + clutter_);
 
-                    cos_test_angle = ((xmtr_alt2) + (distance * distance) - (test_alt * test_alt)) /
-                                     (2.0 * xmtr_alt * distance);
+            /* Calculate the cosine of the elevation
+               angle of the terrain (test point)
+               as seen by the transmitter. */
 
-                    if (cos_test_angle > 1.0) cos_test_angle = 1.0;
+            cos_test_angle = ((xmtr_alt2) + (distance * distance) - (test_alt * test_alt)) /
+                             (2.0 * xmtr_alt * distance);
 
-                    if (cos_test_angle < -1.0) cos_test_angle = -1.0;
+            if (cos_test_angle > 1.0) cos_test_angle = 1.0;
 
-                    /* Compare these two angles to determine if
-                       an obstruction exists.  Since we're comparing
-                       the cosines of these angles rather than
-                       the angles themselves, the sense of the
-                       following "if" statement is reversed from
-                       what it would be if the angles themselves
-                       were compared. */
+            if (cos_test_angle < -1.0) cos_test_angle = -1.0;
 
-                    if (cos_rcvr_angle >= cos_test_angle) block = 1;
-                }
+            /* A smaller cosine is a higher angle */
 
-                if (block)
-                    elevation = ((acos(cos_test_angle)) / DEG2RAD) - 90.0;
-                else
-                    elevation = ((acos(cos_rcvr_angle)) / DEG2RAD) - 90.0;
+            if (ctx.horizon_cos.empty() || cos_test_angle < ctx.horizon_cos.back()) {
+                ctx.horizon.push_back(x);
+                ctx.horizon_cos.push_back(cos_test_angle);
             }
+        }
 
-            /* Determine attenuation for each point along
-               the path using ITWOM's point_to_point mode
-               starting at y=2 (number_of_points = 1), the
-               shortest distance terrain can play a role in
-               path loss. */
-
-            elev_[0] = y - 1; /* (number of points - 1) */
+        /* Horizon cosines decrease outward, so the first obstruction
+           (cos_rcvr_angle >= cos_test_angle) among the points in
+           front of y is found by bisection. */
 
-            /* Distance between elevation samples */
+        auto end = ctx.horizon_cos.begin() +
+                   (std::lower_bound(ctx.horizon.begin(), ctx.horizon.end(), y) -
+                    ctx.horizon.begin());
+        auto first = std::partition_point(ctx.horizon_cos.begin(), end,
+                                          [&](double c) { return c > cos_rcvr_angle; });
 
-            elev_[1] = METERS_PER_MILE * (path_.distance[y] - path_.distance[y - 1]);
+        block = (first != end);
 
-            if (olditm_)
-                point_to_point_ITM(
-                    elev_, source.alt * METERS_PER_FOOT, destination.alt * METERS_PER_FOOT,
-                    LR_.eps_dielect, LR_.sgm_conductivity, LR_.eno_ns_surfref, LR_.frq_mhz,
-                    LR_.radio_climate, LR_.pol, LR_.conf, LR_.rel, loss, strmode, errnum);
-            else
-                point_to_point(elev_, source.alt * METERS_PER_FOOT,
-                               destination.alt * METERS_PER_FOOT, LR_.eps_dielect,
-                               LR_.sgm_conductivity, LR_.eno_ns_surfref, LR_.frq_mhz, LR_.radio_climate,
-                               LR_.pol, LR_.conf, LR_.rel, loss, strmode, errnum);
+        if (block)
+            elevation = ((acos(*first)) / DEG2RAD) - 90.0;
+        else
+            elevation = ((acos(cos_rcvr_angle)) / DEG2RAD) - 90.0;
+    }
 
-            temp.lat = path_.lat[y];
-            temp.lon = path_.lon[y];
+    if (ano != NULL || antenna != NULL) {
+        temp.lat = p.lat[y];
+        temp.lon = p.lon[y];
 
-            azimuth = (Azimuth(source, temp));
+        azimuth = (Azimuth(source, temp));
 
-            if (fd != NULL)
-                fprintf(fd, "%.7f, %.7f, %.3f, %.3f, ", path_.lat[y], path_.lon[y], azimuth,
-                        elevation);
+        AppendANO(ano, "%.7f, %.7f, %.3f, %.3f, ", p.lat[y], p.lon[y], azimuth, elevation);
+    }
 
-            /* If ERP==0, write path loss to alphanumeric
-               output file.  Otherwise, write field strength
-               or received power level (below), as appropriate. */
+    /* If ERP==0, write path loss to alphanumeric
+       output file.  Otherwise, write field strength
+       or received power level (below), as appropriate. */
 
-            if (fd != NULL && LR_.erp == 0.0) fprintf(fd, "%.2f", loss);
+    if (Units == LR_LOSS) AppendANO(ano, "%.2f", loss);
 
-            /* Integrate the antenna's radiation
-               pattern into the overall path loss. */
+    /* Integrate the antenna's radiation
+       pattern into the overall path loss. */
 
-            x = (int)rint(10.0 * (10.0 - elevation));
+    if (antenna != NULL) loss -= antenna->gain(azimuth, elevation);
 
-            if (x >= 0 && x <= 1000) {
-                azimuth = rint(azimuth);
+    strength = offset - loss;
 
-                pattern = (double)LR_.antenna_pattern[(int)azimuth][x];
+    if (Units == LR_LOSS) {
+        if (loss > 255)
+            ifs = 255;
+        else
+            ifs = (int)rint(loss);
 
-                if (pattern != 0.0) {
-                    pattern = 20.0 * log10(pattern);
-                    loss -= pattern;
-                }
-            }
+        ofs = (cell != NULL ? *cell : 0);
 
-            if (LR_.erp != 0.0) {
-                if (dbm_) {
-                    /* dBm is based on EIRP (ERP + 2.14) */
+        if (ofs < ifs && ofs != 0) ifs = ofs;
 
-                    rxp = LR_.erp / (pow(10.0, (loss - 2.14) / 10.0));
+        if (cell != NULL) *cell = (unsigned char)ifs;
+    }
 
-                    dBm = 10.0 * (log10(rxp * 1000.0));
+    else {
+        AppendANO(ano, "%.3f", strength);
 
-                    if (fd != NULL) fprintf(fd, "%.3f", dBm);
+        /* Scale roughly between 0 and 255 */
 
-                    /* Scale roughly between 0 and 255 */
+        ifs = (Units == LR_DBM ? 200 : 100) + (int)rint(strength);
 
-                    ifs = 200 + (int)rint(dBm);
+        if (ifs < 0) ifs = 0;
 
-                    if (ifs < 0) ifs = 0;
+        if (ifs > 255) ifs = 255;
 
-                    if (ifs > 255) ifs = 255;
+        ofs = (cell != NULL ? *cell : 0);
 
-                    ofs = GetSignal(path_.lat[y], path_.lon[y]);
+        if (ofs > ifs) ifs = ofs;
 
-                    if (ofs > ifs) ifs = ofs;
+        if (cell != NULL) *cell = (unsigned char)ifs;
+    }
 
-                    PutSignal(path_.lat[y], path_.lon[y], (unsigned char)ifs);
-                }
+    if (ano != NULL) {
+        if (block) AppendANO(ano, " *");
 
-                else {
-                    field_strength = (139.4 + (20.0 * log10(LR_.frq_mhz)) - loss) +
-                                     (10.0 * log10(LR_.erp / 1000.0));
+        AppendANO(ano, "\n");
+    }
 
-                    ifs = 100 + (int)rint(field_strength);
+    return strength;
+}
 
-                    if (ifs < 0) ifs = 0;
+class WorkerPool {
+    /* Worker threads that stay up between ParallelFor() calls.  A
+       sweep runs several passes per batch of radials and a map is
+       drawn a block of rows at a time, so starting threads for each
+       call would cost more than many of the calls take.  The idle
+       workers sleep on a condition variable. */
 
-                    if (ifs > 255) ifs = 255;
+   public:
+    explicit WorkerPool(int threads) : size_(threads) {
+        for (int w = 1; w < threads; w++) pool_.emplace_back(&WorkerPool::Work, this, w);
+    }
 
-                    ofs = GetSignal(path_.lat[y], path_.lon[y]);
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
 
-                    if (ofs > ifs) ifs = ofs;
+        wake_.notify_all();
 
-                    PutSignal(path_.lat[y], path_.lon[y], (unsigned char)ifs);
+        for (auto &t : pool_) t.join();
+    }
 
-                    if (fd != NULL) fprintf(fd, "%.3f", field_strength);
-                }
-            }
+    int size() const { return size_; }
 
-            else {
-                if (loss > 255)
-                    ifs = 255;
-                else
-                    ifs = (int)rint(loss);
+    static thread_local bool running_;  // True while this thread runs a body
 
-                ofs = GetSignal(path_.lat[y], path_.lon[y]);
+    void Run(int count, int threads, const std::function<void(int, int)> &body) {
+        /* Hands out the indices to workers [0, threads); the
+           others sleep through the call */
 
-                if (ofs < ifs && ofs != 0) ifs = ofs;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            body_ = &body;
+            count_ = count;
+            active_ = threads;
+            next_ = 0;
+            busy_ = (int)pool_.size();
+            round_++;
+        }
 
-                PutSignal(path_.lat[y], path_.lon[y], (unsigned char)ifs);
-            }
+        wake_.notify_all();
 
-            if (fd != NULL) {
-                if (block) fprintf(fd, " *");
+        /* The caller's share may throw (SplatCancelled); the
+           workers still have to finish before body goes away */
 
-                fprintf(fd, "\n");
-            }
+        std::exception_ptr error;
 
-            /* Mark this point as having been analyzed */
+        running_ = true;
 
-            PutMask(path_.lat[y], path_.lon[y],
-                    (GetMask(path_.lat[y], path_.lon[y]) & 7) + (mask_value << 3));
+        try {
+            Share(0);
+        } catch (...) {
+            error = std::current_exception();
+            next_ = count;
         }
+
+        running_ = false;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return busy_ == 0; });
+
+        if (error) std::rethrow_exception(error);
     }
-}
 
-void SplatProcessor::PlotLOSMap(struct site source, double altitude) {
-    /* This function performs a 360 degree sweep around the
-       transmitter site (source location), and plots the
-       line-of-sight coverage of the transmitter on the SPLAT!
-       generated topographic map based on a receiver located
-       at the specified altitude (in feet AGL).  Results
-       are stored in memory, and written out in the form
-       of a topographic map when the WritePPM() function
-       is later invoked. */
+   private:
+    void Share(int id) {
+        if (id < active_)
+            for (int i = next_++; i < count_; i = next_++) (*body_)(i, id);
+    }
 
-    int y, z, count;
-    struct site edge;
-    unsigned char symbol[4], x;
-    double lat, lon, minwest, maxnorth, th;
-    static unsigned char mask_value = 1;
+    void Work(int id) {
+        unsigned long seen = 0;
 
-    symbol[0] = '.';
-    symbol[1] = 'o';
-    symbol[2] = 'O';
-    symbol[3] = 'o';
+        running_ = true;
 
-    count = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stop_ || round_ != seen; });
+
+                if (stop_) return;
+
+                seen = round_;
+            }
+
+            Share(id);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            if (--busy_ == 0) done_.notify_one();
+        }
+    }
+
+    int size_;
+    std::vector<std::thread> pool_;
+    std::mutex mutex_;
+    std::condition_variable wake_, done_;
+    const std::function<void(int, int)> *body_ = NULL;
+    std::atomic<int> next_{0};
+    int count_ = 0, active_ = 0, busy_ = 0;
+    unsigned long round_ = 0;
+    bool stop_ = false;
+};
+
+thread_local bool WorkerPool::running_ = false;
+
+void SplatProcessor::ParallelFor(int count, int threads,
+                                 const std::function<void(int, int)> &body) {
+    /* Runs body(index, worker) for every index in [0, count) on
+       up to "threads" workers, the calling thread being worker 0.
+       Indices are handed out dynamically, so uneven radials do
+       not leave workers idle.  The pool is started on first use
+       and kept for later calls; a body that itself calls
+       ParallelFor() runs its indices serially. */
+
+    if (threads > count) threads = count;
+
+    if (threads <= 1 || WorkerPool::running_) {
+        for (int i = 0; i < count; i++) body(i, 0);
+
+        return;
+    }
+
+    if (!workers_ || workers_->size() < threads) workers_ = std::make_shared<WorkerPool>(threads);
+
+    workers_->Run(count, threads, body);
+}
+
+int SplatProcessor::ThreadCount() {
+    /* Returns the number of sweep workers to use.  A value
+       of zero (the default) means one per hardware thread. */
+
+    unsigned int n = threads_;
+
+    if (n == 0) n = std::thread::hardware_concurrency();
+
+    return n > 0 ? (int)n : 1;
+}
+
+void SplatProcessor::CheckCancelled() const {
+    if (Cancelled()) throw SplatCancelled();
+}
+
+void SplatProcessor::ReportProgress(SMSplatPhase phase, double fraction) {
+    if (progress_ && !Cancelled()) progress_(phase, fraction < 1.0 ? fraction : 1.0);
+}
+
+void SplatProcessor::RenderRows(RasterStream &stream, int rows,
+                                const std::function<void(int, unsigned char *)> &draw) {
+    /* Calls draw(y, row) for rows [0, rows) of the stream on the
+       sweep workers.  Rows are fetched in order, one block at a
+       time, so a sink still receives its blocks in order while the
+       rows within each block are drawn in parallel. */
+
+    std::vector<unsigned char *> block(RasterStream::BLOCK_ROWS);
+    int threads = ThreadCount(), first, count, y;
+
+    for (first = 0; first < rows; first += RasterStream::BLOCK_ROWS) {
+        count = std::min(RasterStream::BLOCK_ROWS, rows - first);
+
+        for (y = 0; y < count; y++) block[y] = stream.row(first + y);
+
+        ParallelFor(count, threads, [&](int i, int) { draw(first + i, block[i]); });
+
+        ReportProgress(SMSPLAT_RENDER, (double)(first + count) / rows);
+    }
+}
+
+void SplatProcessor::PlotLRRadials(PathContext &ctx, struct site source,
+                                   const std::vector<struct site> &edges,
+                                   unsigned char mask_value, FILE *fd, int z) {
+    /* This function runs PlotLRPath() for every edge point in
+       "edges" on a pool of worker threads.  The serial sweep only
+       evaluates the first radial (in edge order) to reach any given
+       pixel, so each batch of radials goes through three passes to
+       reproduce it exactly: the workers first trace the radials to
+       find the mask cells they cross, those cells are then claimed
+       in edge order on this thread, and finally the workers evaluate
+       the points each radial owns.  Since no two radials own the same
+       cell, the signal[][] merge is race free and bit-identical
+       to the serial run.  A progress symbol is printed every
+       z radials, as the serial loops did.  Pruning decisions are
+       made per radial, so they too match the serial run.  Once the
+       job is cancelled, no more radials are traced or evaluated. */
+
+    int n = (int)edges.size(), threads = ThreadCount(), r, y, x = 0;
+    std::vector<std::unique_ptr<PathContext>> contexts(threads);
+    std::vector<int> skipped(n, 0);
+    std::atomic<int> done(0);
+    unsigned char symbol[4] = {'.', 'o', 'O', 'o'};
+    int printed = 0;
+
+    if (threads > n) threads = n > 0 ? n : 1;
+
+    /* The radio and climate parameters hold for the whole sweep */
+
+    itm_session_ = std::make_shared<itm_session_type>();
+    itm_session_prepare(LR_.eps_dielect, LR_.sgm_conductivity, LR_.frq_mhz, LR_.radio_climate,
+                        LR_.pol, LR_.conf, LR_.rel, *itm_session_);
+
+    if (threads == 1) {
+        /* Nothing to share out; skip the tracing pass */
+
+        for (r = 0; r < n && !Cancelled(); r++) {
+            pruned_points_ += PlotLRPath(ctx, source, edges[r], mask_value, fd);
+
+            if (z > 0 && (r + 1) % z == 0) {
+                fprintf(stdout, "%c", symbol[x]);
+                fflush(stdout);
+                x = (x == 3 ? 0 : x + 1);
+                ReportProgress(SMSPLAT_SWEEP, (sweep_quarter_ + (double)(r + 1) / n) / 4.0);
+            }
+        }
+
+        ReportProgress(SMSPLAT_SWEEP, ++sweep_quarter_ / 4.0);
+        return;
+    }
+
+    /* The calling thread works in ctx, the others in their own */
+
+    for (r = 1; r < threads; r++) contexts[r].reset(new PathContext);
+
+    /* The radials are processed in batches, so only a batch worth
+       of paths and cells is ever held, however long the sweep. */
+
+    int batch = std::min(n, threads * RADIAL_BATCH), first, count;
+    std::vector<struct path> paths(batch);
+    std::vector<std::vector<unsigned char *>> cells(batch);
+    std::vector<std::vector<int>> owned(batch);
+    std::vector<std::string> anos(fd != NULL ? batch : 0);
+
+    for (first = 0; first < n && !Cancelled(); first += count) {
+        count = std::min(batch, n - first);
+
+        /* Pass 1: trace each radial and record the cells it crosses.
+           The path is kept for pass 3, so it is only read once. */
+
+        ParallelFor(count, threads, [&](int i, int) {
+            struct path &p = paths[i];
+
+            cells[i].clear();
+
+            if (Cancelled()) return;
+
+            ReadPath(source, edges[first + i], p);
+
+            for (int k = 2; (k < (p.length - 1) && p.distance[k] <= max_range_); k++)
+                cells[i].push_back(MaskCell(p.lat[k], p.lon[k]));
+        });
+
+        /* Pass 2: claim cells in edge order, exactly as the
+           serial sweep marks them as having been analyzed.
+           Batches are claimed in order, so this holds across
+           the whole sweep. */
+
+        for (r = 0; r < count; r++) {
+            owned[r].clear();
+
+            for (y = 0; y < (int)cells[r].size(); y++) {
+                unsigned char *cell = cells[r][y];
+
+                if (cell == NULL) {
+                    if (fd != NULL) owned[r].push_back(y + 2);
+                }
+
+                else if ((*cell & 248) != (mask_value << 3)) {
+                    *cell = (*cell & 7) + (mask_value << 3);
+                    owned[r].push_back(y + 2);
+                }
+            }
+        }
+
+        /* Pass 3: evaluate the owned points of each radial */
+
+        ParallelFor(count, threads, [&](int i, int w) {
+            PathContext &wctx = (w == 0 ? ctx : *contexts[w]);
+            int e = first + i;
+
+            if (!owned[i].empty() && !Cancelled()) {
+                std::swap(wctx.path, paths[i]);
+                CopyLRElevations(wctx);
+
+                skipped[e] = PlotLRPoints(wctx, source, edges[e], owned[i],
+                                          fd != NULL ? &anos[i] : NULL);
+
+                std::swap(wctx.path, paths[i]);
+            }
+
+            done++;
+
+            /* Only the calling thread writes progress symbols */
+
+            if (w == 0 && z > 0 && printed < done / z) {
+                for (; printed < done / z; printed++) {
+                    fprintf(stdout, "%c", symbol[x]);
+                    fflush(stdout);
+                    x = (x == 3 ? 0 : x + 1);
+                }
+
+                ReportProgress(SMSPLAT_SWEEP, (sweep_quarter_ + (double)printed * z / n) / 4.0);
+            }
+        });
+
+        if (fd != NULL)
+            for (r = 0; r < count; r++) {
+                fputs(anos[r].c_str(), fd);
+                anos[r].clear();
+            }
+    }
+
+    if (z > 0) {
+        for (; printed < n / z; printed++) {
+            fprintf(stdout, "%c", symbol[x]);
+            x = (x == 3 ? 0 : x + 1);
+        }
+
+        fflush(stdout);
+    }
+
+    for (r = 0; r < n; r++) pruned_points_ += skipped[r];
+
+    ReportProgress(SMSPLAT_SWEEP, ++sweep_quarter_ / 4.0);
+}
+
+void SplatProcessor::PlotLOSMap(PathContext &ctx, struct site source, double altitude) {
+    /* This function performs a 360 degree sweep around the
+       transmitter site (source location), and plots the
+       line-of-sight coverage of the transmitter on the SPLAT!
+       generated topographic map based on a receiver located
+       at the specified altitude (in feet AGL).  Results
+       are stored in memory, and written out in the form
+       of a topographic map when the WritePPM() function
+       is later invoked. */
+
+    int y, z, count;
+    struct site edge;
+    unsigned char symbol[4], x;
+    double lat, lon, minwest, maxnorth, th;
+    unsigned char &mask_value = ctx.los_mask_value;
+
+    symbol[0] = '.';
+    symbol[1] = 'o';
+    symbol[2] = 'O';
+    symbol[3] = 'o';
+
+    count = 0;
 
     fprintf(
         stdout, "\nComputing line-of-sight coverage of \"%s\" with an RX antenna\nat %.2f %s AGL",
@@ -2822,7 +3688,7 @@ void SplatProcessor::PlotLOSMap(struct site source, double altitude) {
         edge.lon = lon;
         edge.alt = altitude;
 
-        PlotPath(source, edge, mask_value);
+        PlotPath(ctx, source, edge, mask_value);
         count++;
 
         if (count == z) {
@@ -2849,7 +3715,7 @@ void SplatProcessor::PlotLOSMap(struct site source, double altitude) {
         edge.lon = min_west_;
         edge.alt = altitude;
 
-        PlotPath(source, edge, mask_value);
+        PlotPath(ctx, source, edge, mask_value);
         count++;
 
         if (count == z) {
@@ -2878,7 +3744,7 @@ void SplatProcessor::PlotLOSMap(struct site source, double altitude) {
         edge.lon = lon;
         edge.alt = altitude;
 
-        PlotPath(source, edge, mask_value);
+        PlotPath(ctx, source, edge, mask_value);
         count++;
 
         if (count == z) {
@@ -2905,7 +3771,7 @@ void SplatProcessor::PlotLOSMap(struct site source, double altitude) {
         edge.lon = max_west_;
         edge.alt = altitude;
 
-        PlotPath(source, edge, mask_value);
+        PlotPath(ctx, source, edge, mask_value);
         count++;
 
         if (count == z) {
@@ -2952,9 +3818,369 @@ double SplatProcessor::AdjustAngleForNegativeXAxis(double angle) {
     return adjustedAngle;
 }
 
-void SplatProcessor::PlotLRMapSpecifiedAngles(struct site source, double altitude,
-                                              char *plo_filename, double start_angle_,
-                                              double end_angle_) {
+void SplatProcessor::PreparePruning(struct site source, FILE *fd) {
+    /* Works out prune_floor_, the weakest result that can still
+       be drawn on the map, less prune_margin_, from the same
+       contour levels and threshold the map writers will use.
+       Results are compared as strengths (see PlotLRPoint()), so
+       path losses are negated.  Alphanumeric output lists every
+       point, so pruning is left off when an .ano file is open. */
+
+    int z;
+    double floor;
+
+    prune_active_ = 0;
+
+    if (prune_margin_ < 0 || fd != NULL) return;
+
+    if (LR_.erp == 0.0) {
+        LoadLossColors();
+
+        if (region_.levels < 1) return;
+
+        for (z = 1, floor = region_.level[0]; z < region_.levels; z++)
+            if (region_.level[z] > floor) floor = region_.level[z];
+
+        if (contour_threshold_ != 0 && abs(contour_threshold_) < floor)
+            floor = abs(contour_threshold_);
+
+        floor = -(floor + prune_margin_);
+    }
+
+    else {
+        if (dbm_)
+            LoadDBMColors();
+        else
+            LoadSignalColors(source);
+
+        if (region_.levels < 1) return;
+
+        for (z = 1, floor = region_.level[0]; z < region_.levels; z++)
+            if (region_.level[z] < floor) floor = region_.level[z];
+
+        if (contour_threshold_ != 0 && contour_threshold_ > floor) floor = contour_threshold_;
+
+        floor -= prune_margin_;
+    }
+
+    prune_floor_ = floor;
+    prune_span_ = metric_ ? prune_window_ / KM_PER_MILE : prune_window_;
+    prune_active_ = 1;
+}
+
+void SplatProcessor::PlotLRAdaptive(PathContext &ctx, struct site source, double altitude,
+                                    FILE *fd, double start, double end) {
+    /* This function sweeps the source's coverage between azimuths
+       "start" and "end" (degrees) with radials spaced for the
+       coverage radius, rather than with one radial per edge pixel
+       of the terrain in memory.  Neighbouring radials are at most
+       adaptive_spacing_ pixels apart where they reach max_range_;
+       nearer the source, where they crowd together, the mask bits
+       already confine each to the pixels no earlier radial has
+       evaluated.  Pixels within the radius that no radial crossed
+       are then interpolated by FillLRGaps().  The radials are
+       plotted in four quarters to keep the usual progress output. */
+
+    int n, count, first, last, q, k;
+    double span = end - start, width, step;
+    std::vector<struct site> edges;
+    struct site edge;
+
+    /* The narrower (east-west) extent of a pixel, in miles */
+
+    width = dpp_ * 3959.0 * DEG2RAD * cos(source.lat * DEG2RAD);
+
+    n = (int)ceil(span * DEG2RAD * max_range_ / (width * adaptive_spacing_));
+
+    if (n < 4) n = 4;
+
+    step = span / n;
+    count = (span >= 360.0 ? n : n + 1);
+
+    for (q = 0; q < 4; q++) {
+        first = count * q / 4;
+        last = count * (q + 1) / 4;
+
+        if (q > 0) {
+            fprintf(stdout, "\n%d%c to %3d%c ", 25 * q, 37, 25 * (q + 1), 37);
+            fflush(stdout);
+        }
+
+        for (k = first; k < last; k++) {
+            /* Run slightly past max_range_ so the last ring is reached */
+
+            edge = Destination(source, start + step * k, max_range_ + width);
+            edge.alt = altitude;
+
+            edges.push_back(edge);
+        }
+
+        PlotLRRadials(ctx, source, edges, ctx.lr_mask_value, fd, (last - first + 63) / 64);
+        edges.clear();
+    }
+
+    FillLRGaps(source, ctx.lr_mask_value, start, end);
+}
+
+void SplatProcessor::FillLRGaps(struct site source, unsigned char mask_value, double start,
+                                double end) {
+    /* This function gives each pixel within max_range_ of the
+       source, and between azimuths "start" and "end", that the
+       current sweep did not evaluate the average signal of its
+       evaluated neighbours.  Neighbours without a signal only
+       count if all of them lack one, in which case the pixel is
+       left without one too.  Filled pixels count as evaluated, so
+       passes are repeated until no more gaps can be filled.  Each
+       pass only reads the results of the ones before it, and the
+       fill is merged into signal[][] as PlotLRPoint() merges its
+       results.  Rows are scanned, and gaps filled, on the sweep's
+       worker threads. */
+
+    int x, x0, x1, y0, y1, rows, threads = ThreadCount(), value;
+    double lat0, lon0, scale;
+    std::vector<struct site> gaps, left;
+    std::vector<int> values;
+    unsigned char *cell, *signal, tag = mask_value << 3;
+    bool sector = (end - start < 360.0), filled;
+
+    /* Pixels lie on multiples of dpp_; walk those around the source */
+
+    lat0 = rint(source.lat / dpp_) * dpp_;
+    lon0 = rint(source.lon / dpp_) * dpp_;
+
+    scale = cos(source.lat * DEG2RAD);
+
+    if (scale < 0.01) scale = 0.01;
+
+    rows = (int)ceil(max_range_ / (3959.0 * DEG2RAD * dpp_)) + 1;
+
+    /* Only scan the box around the swept wedge: the source, the
+       ends of its arc and any compass points the arc passes. */
+
+    x0 = x1 = y0 = y1 = 0;
+
+    for (double azimuth : {start, end, 0.0, 90.0, 180.0, 270.0, 360.0}) {
+        if (azimuth < start || azimuth > end) continue;
+
+        double north = rows * cos(azimuth * DEG2RAD), west = -rows * sin(azimuth * DEG2RAD);
+
+        x0 = std::min(x0, (int)floor(north) - 1);
+        x1 = std::max(x1, (int)ceil(north) + 1);
+        y0 = std::min(y0, (int)floor(west / scale) - 1);
+        y1 = std::max(y1, (int)ceil(west / scale) + 1);
+    }
+
+    x0 = std::max(x0, -rows);
+    x1 = std::min(x1, rows);
+
+    std::vector<std::vector<struct site>> found(x1 - x0 + 1);
+
+    ParallelFor(x1 - x0 + 1, threads, [&](int i, int) {
+        int x = x0 + i, y, half;
+        double row_scale = cos((lat0 + dpp_ * x) * DEG2RAD);
+        struct site pixel;
+        unsigned char *cell;
+
+        if (row_scale < 0.01) row_scale = 0.01;
+
+        /* The columns of this row that may lie within max_range_ */
+
+        half = (int)ceil(sqrt((double)(rows * rows - x * x)) / row_scale) + 1;
+
+        for (y = std::max(y0, -half); y <= std::min(y1, half); y++) {
+            pixel.lat = lat0 + dpp_ * x;
+            pixel.lon = lon0 + dpp_ * y;
+
+            if (pixel.lon < 0.0) pixel.lon += 360.0;
+
+            if (pixel.lon >= 360.0) pixel.lon -= 360.0;
+
+            cell = MaskCell(pixel.lat, pixel.lon);
+
+            if (cell == NULL || (*cell & 248) == tag || Distance(source, pixel) > max_range_)
+                continue;
+
+            if (sector) {
+                double azimuth = Azimuth(source, pixel);
+
+                if (azimuth < start || azimuth > end) continue;
+            }
+
+            found[i].push_back(pixel);
+        }
+    });
+
+    for (auto &row : found) gaps.insert(gaps.end(), row.begin(), row.end());
+
+    while (!gaps.empty()) {
+        /* Average each gap's evaluated neighbours; -1 = none yet */
+
+        values.assign(gaps.size(), -1);
+
+        ParallelFor((int)gaps.size(), threads, [&](int i, int) {
+            int x, y, sum = 0, n = 0, evaluated = 0;
+            struct site next;
+            unsigned char *cell, *signal;
+
+            for (x = -1; x <= 1; x++)
+                for (y = -1; y <= 1; y++) {
+                    next.lat = gaps[i].lat + dpp_ * x;
+                    next.lon = gaps[i].lon + dpp_ * y;
+
+                    if (next.lon < 0.0) next.lon += 360.0;
+
+                    if (next.lon >= 360.0) next.lon -= 360.0;
+
+                    cell = MaskCell(next.lat, next.lon);
+
+                    if (cell == NULL || (*cell & 248) != tag) continue;
+
+                    signal = SignalCell(next.lat, next.lon);
+                    evaluated++;
+
+                    if (*signal != 0) {
+                        sum += *signal;
+                        n++;
+                    }
+                }
+
+            if (n > 0)
+                values[i] = (sum + n / 2) / n;
+            else if (evaluated > 0)
+                values[i] = 0;
+        });
+
+        for (x = 0, filled = false; x < (int)gaps.size(); x++) {
+            value = values[x];
+
+            if (value < 0) {
+                left.push_back(gaps[x]);
+                continue;
+            }
+
+            cell = MaskCell(gaps[x].lat, gaps[x].lon);
+            signal = SignalCell(gaps[x].lat, gaps[x].lon);
+            filled = true;
+
+            /* A value of 0 only marks the gap as evaluated */
+
+            if (value > 0 && LR_.erp == 0.0) {
+                if (*signal == 0 || *signal > value) *signal = (unsigned char)value;
+            }
+
+            else if (*signal < value)
+                *signal = (unsigned char)value;
+
+            *cell = (*cell & 7) + tag;
+        }
+
+        if (!filled) break;
+
+        gaps.swap(left);
+        left.clear();
+    }
+}
+
+void SplatProcessor::EndLRMap(PathContext &ctx, FILE *fd, unsigned long pruned) {
+    /* Closes the alphanumeric output of a PlotLRMap() or
+       PlotLRMapSpecifiedAngles() sweep, reports on it, and
+       moves on to the next mask value and sweep. */
+
+    if (fd != NULL) fclose(fd);
+
+    fprintf(stdout, "\nDone!\n");
+
+    if (prune_active_)
+        fprintf(stdout, "Pruning skipped %lu path loss evaluations\n", pruned_points_ - pruned);
+
+    fflush(stdout);
+
+    if (ctx.lr_mask_value < 30) ctx.lr_mask_value++;
+
+    sweep_quarter_ = 0;
+}
+
+void SplatProcessor::SectorEdges(struct site source, std::vector<struct site> &edges,
+                                 double start, double end) {
+    /* This function drops those of "edges", consecutive points
+       along one side of the map, whose azimuth from the source
+       lies outside [start, end].  Seen from a source within the
+       map, the azimuth turns steadily one way along a side, but
+       for a single jump through north, so the points in the
+       sector are found by bisection rather than by working out
+       the azimuth of every one. */
+
+    int n = (int)edges.size(), wrap, first, last, piece;
+    double a0, turn, half;
+    bool rising;
+    std::vector<struct site> kept;
+
+    auto azimuth = [&](int i) { return Azimuth(source, edges[i]); };
+
+    /* Returns the first index in [lo, hi) for which pred() fails */
+
+    auto bisect = [](int lo, int hi, const std::function<bool(int)> &pred) {
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+
+            if (pred(mid))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        return lo;
+    };
+
+    if (n >= 3) {
+        a0 = azimuth(0);
+        turn = fmod(azimuth(n - 1) - a0 + 540.0, 360.0) - 180.0;
+        half = fmod(azimuth(n / 2) - a0 + 540.0, 360.0) - 180.0;
+        rising = (turn >= 0.0);
+
+        /* Points before the jump through north, if there is one,
+           lie on the same side of it as the first point. */
+
+        if (rising ? (half >= 0.0 && half <= turn) : (half <= 0.0 && half >= turn)) {
+            wrap = bisect(0, n, [&](int i) {
+                return rising ? azimuth(i) >= a0 : azimuth(i) <= a0;
+            });
+
+            for (piece = 0; piece < 2; piece++) {
+                int lo = (piece == 0 ? 0 : wrap), hi = (piece == 0 ? wrap : n);
+
+                if (rising) {
+                    first = bisect(lo, hi, [&](int i) { return azimuth(i) < start; });
+                    last = bisect(first, hi, [&](int i) { return azimuth(i) <= end; });
+                }
+
+                else {
+                    first = bisect(lo, hi, [&](int i) { return azimuth(i) > end; });
+                    last = bisect(first, hi, [&](int i) { return azimuth(i) >= start; });
+                }
+
+                kept.insert(kept.end(), edges.begin() + first, edges.begin() + last);
+            }
+
+            edges.swap(kept);
+            return;
+        }
+    }
+
+    /* Too short, or not seen from within: check every point */
+
+    for (first = 0; first < n; first++) {
+        double a = azimuth(first);
+
+        if (a >= start && a <= end) kept.push_back(edges[first]);
+    }
+
+    edges.swap(kept);
+}
+
+void SplatProcessor::PlotLRMapSpecifiedAngles(PathContext &ctx, struct site source,
+                                              double altitude, char *plo_filename,
+                                              double start_angle_, double end_angle_) {
     /* This function performs a 360 degree sweep around the
        transmitter site (source location), and plots the
        Irregular Terrain Model attenuation on the SPLAT!
@@ -2963,31 +4189,18 @@ void SplatProcessor::PlotLRMapSpecifiedAngles(struct site source, double altitud
        are stored in memory, and written out in the form
        of a topographic map when the WritePPMLR() or
        WritePPMSS() functions are later invoked. */
-    // Adjust angles for the new reference (negative x-axis)
-    // start_angle = AdjustAngleForNegativeXAxis(start_angle);
-    // end_angle = AdjustAngleForNegativeXAxis(end_angle);
-    
-    /* Continue with the existing logic using the adjusted angles */
-    printf("Adjusted Start Angle: %.2f, Adjusted End Angle: %.2f\n", start_angle_, end_angle_);
 
-    int y, z, count;
+    int y, z;
     struct site edge;
     double lat, lon, minwest, maxnorth, th;
-    double azimuth;
-    unsigned char x, symbol[4];
-    static unsigned char mask_value = 1;
+    std::vector<struct site> edges;
+    unsigned char &mask_value = ctx.lr_mask_value;
+    unsigned long pruned;
     FILE *fd = NULL;
 
     minwest = dpp_ + (double)min_west_;
     maxnorth = (double)max_north_ - dpp_;
 
-    symbol[0] = '.';
-    symbol[1] = 'o';
-    symbol[2] = 'O';
-    symbol[3] = 'o';
-
-    count = 0;
-
     if (olditm_)
         fprintf(stdout, "\nComputing ITM ");
     else
@@ -3011,6 +4224,8 @@ void SplatProcessor::PlotLRMapSpecifiedAngles(struct site source, double altitud
         fprintf(stdout, "\nand %.2f %s of ground clutter",
                 metric_ ? clutter_ * METERS_PER_FOOT : clutter_, metric_ ? "meters" : "feet");
 
+    fprintf(stdout, "\nbetween azimuths of %.2f and %.2f degrees", start_angle_, end_angle_);
+
     fprintf(stdout, "...\n\n 0%c to  25%c ", 37, 37);
     fflush(stdout);
 
@@ -3023,13 +4238,22 @@ void SplatProcessor::PlotLRMapSpecifiedAngles(struct site source, double altitud
                 min_west_, max_north_, min_north_);
     }
 
+    PreparePruning(source, fd);
+    pruned = pruned_points_;
+
+    if (adaptive_spacing_ > 0.0) {
+        PlotLRAdaptive(ctx, source, altitude, fd, start_angle_, end_angle_);
+        EndLRMap(ctx, fd, pruned);
+        return;
+    }
+
     /* th=pixels/degree divided by 64 loops per
        progress indicator symbol (.oOo) printed. */
 
     th = ppd_ / 64.0;
 
     z = (int)(th * ReduceAngle(max_west_ - min_west_));
-    for (lon = minwest, x = 0, y = 0; (LonDiff(lon, (double)max_west_) <= 0.0);
+    for (lon = minwest, y = 0; (LonDiff(lon, (double)max_west_) <= 0.0);
          y++, lon = minwest + (dpp_ * (double)y)) {
         if (lon >= 360.0) lon -= 360.0;
 
@@ -3037,68 +4261,35 @@ void SplatProcessor::PlotLRMapSpecifiedAngles(struct site source, double altitud
         edge.lon = lon;
         edge.alt = altitude;
 
-        // Inside the loop
-        azimuth = (Azimuth(source, edge));
-
-        // Skip points outside the specified angle range
-        if (azimuth < start_angle_ || azimuth > end_angle_) {
-            continue;
-        }
-        PlotLRPath(source, edge, mask_value, fd);
-        count++;
-
-        if (count == z) {
-            fprintf(stdout, "%c", symbol[x]);
-            fflush(stdout);
-            count = 0;
-
-            if (x == 3)
-                x = 0;
-            else
-                x++;
-        }
+        edges.push_back(edge);
     }
 
-    count = 0;
+    SectorEdges(source, edges, start_angle_, end_angle_);
+    PlotLRRadials(ctx, source, edges, mask_value, fd, z);
+    edges.clear();
+
     fprintf(stdout, "\n25%c to  50%c ", 37, 37);
     fflush(stdout);
 
     z = (int)(th * (double)(max_north_ - min_north_));
-    for (lat = maxnorth, x = 0, y = 0; lat >= (double)min_north_;
+    for (lat = maxnorth, y = 0; lat >= (double)min_north_;
          y++, lat = maxnorth - (dpp_ * (double)y)) {
         edge.lat = lat;
         edge.lon = min_west_;
         edge.alt = altitude;
 
-        // Inside the loop
-        azimuth = (Azimuth(source, edge));
-
-        // Skip points outside the specified angle range
-        if (azimuth < start_angle_ || azimuth > end_angle_) {
-            continue;
-        }
-
-        PlotLRPath(source, edge, mask_value, fd);
-        count++;
-
-        if (count == z) {
-            fprintf(stdout, "%c", symbol[x]);
-            fflush(stdout);
-            count = 0;
-
-            if (x == 3)
-                x = 0;
-            else
-                x++;
-        }
+        edges.push_back(edge);
     }
 
-    count = 0;
+    SectorEdges(source, edges, start_angle_, end_angle_);
+    PlotLRRadials(ctx, source, edges, mask_value, fd, z);
+    edges.clear();
+
     fprintf(stdout, "\n50%c to  75%c ", 37, 37);
     fflush(stdout);
 
     z = (int)(th * ReduceAngle(max_west_ - min_west_));
-    for (lon = minwest, x = 0, y = 0; (LonDiff(lon, (double)max_west_) <= 0.0);
+    for (lon = minwest, y = 0; (LonDiff(lon, (double)max_west_) <= 0.0);
          y++, lon = minwest + (dpp_ * (double)y)) {
         if (lon >= 360.0) lon -= 360.0;
 
@@ -3106,72 +4297,35 @@ void SplatProcessor::PlotLRMapSpecifiedAngles(struct site source, double altitud
         edge.lon = lon;
         edge.alt = altitude;
 
-        // Inside the loop
-        azimuth = (Azimuth(source, edge));
-
-        // Skip points outside the specified angle range
-        if (azimuth < start_angle_ || azimuth > end_angle_) {
-            continue;
-        }
-
-        PlotLRPath(source, edge, mask_value, fd);
-        count++;
-
-        if (count == z) {
-            fprintf(stdout, "%c", symbol[x]);
-            fflush(stdout);
-            count = 0;
-
-            if (x == 3)
-                x = 0;
-            else
-                x++;
-        }
+        edges.push_back(edge);
     }
 
-    count = 0;
+    SectorEdges(source, edges, start_angle_, end_angle_);
+    PlotLRRadials(ctx, source, edges, mask_value, fd, z);
+    edges.clear();
+
     fprintf(stdout, "\n75%c to 100%c ", 37, 37);
     fflush(stdout);
 
     z = (int)(th * (double)(max_north_ - min_north_));
-    for (lat = (double)min_north_, x = 0, y = 0; lat < (double)max_north_;
+    for (lat = (double)min_north_, y = 0; lat < (double)max_north_;
          y++, lat = (double)min_north_ + (dpp_ * (double)y)) {
         edge.lat = lat;
         edge.lon = max_west_;
         edge.alt = altitude;
 
-        // Inside the loop
-        azimuth = (Azimuth(source, edge));
-
-        // Skip points outside the specified angle range
-        if (azimuth < start_angle_ || azimuth > end_angle_) {
-            continue;
-        }
-
-        PlotLRPath(source, edge, mask_value, fd);
-        count++;
-
-        if (count == z) {
-            fprintf(stdout, "%c", symbol[x]);
-            fflush(stdout);
-            count = 0;
-
-            if (x == 3)
-                x = 0;
-            else
-                x++;
-        }
+        edges.push_back(edge);
     }
 
-    if (fd != NULL) fclose(fd);
-
-    fprintf(stdout, "\nDone!\n");
-    fflush(stdout);
+    SectorEdges(source, edges, start_angle_, end_angle_);
+    PlotLRRadials(ctx, source, edges, mask_value, fd, z);
+    edges.clear();
 
-    if (mask_value < 30) mask_value++;
+    EndLRMap(ctx, fd, pruned);
 }
 
-void SplatProcessor::PlotLRMap(struct site source, double altitude, char *plo_filename) {
+void SplatProcessor::PlotLRMap(PathContext &ctx, struct site source, double altitude,
+                               char *plo_filename) {
     /* This function performs a 360 degree sweep around the
        transmitter site (source location), and plots the
        Irregular Terrain Model attenuation on the SPLAT!
@@ -3180,23 +4334,17 @@ void SplatProcessor::PlotLRMap(struct site source, double altitude, char *plo_fi
        are stored in memory, and written out in the form
        of a topographic map when the WritePPMLR() or
        WritePPMSS() functions are later invoked. */
-    int y, z, count;
+    int y, z;
     struct site edge;
     double lat, lon, minwest, maxnorth, th;
-    unsigned char x, symbol[4];
-    static unsigned char mask_value = 1;
+    std::vector<struct site> edges;
+    unsigned char &mask_value = ctx.lr_mask_value;
+    unsigned long pruned;
     FILE *fd = NULL;
 
     minwest = dpp_ + (double)min_west_;
     maxnorth = (double)max_north_ - dpp_;
 
-    symbol[0] = '.';
-    symbol[1] = 'o';
-    symbol[2] = 'O';
-    symbol[3] = 'o';
-
-    count = 0;
-
     if (olditm_)
         fprintf(stdout, "\nComputing ITM ");
     else
@@ -3232,6 +4380,15 @@ void SplatProcessor::PlotLRMap(struct site source, double altitude, char *plo_fi
                 min_west_, max_north_, min_north_);
     }
 
+    PreparePruning(source, fd);
+    pruned = pruned_points_;
+
+    if (adaptive_spacing_ > 0.0) {
+        PlotLRAdaptive(ctx, source, altitude, fd, 0.0, 360.0);
+        EndLRMap(ctx, fd, pruned);
+        return;
+    }
+
     /* th=pixels/degree divided by 64 loops per
        progress indicator symbol (.oOo) printed. */
 
@@ -3239,7 +4396,7 @@ void SplatProcessor::PlotLRMap(struct site source, double altitude, char *plo_fi
 
     z = (int)(th * ReduceAngle(max_west_ - min_west_));
 
-    for (lon = minwest, x = 0, y = 0; (LonDiff(lon, (double)max_west_) <= 0.0);
+    for (lon = minwest, y = 0; (LonDiff(lon, (double)max_west_) <= 0.0);
          y++, lon = minwest + (dpp_ * (double)y)) {
         if (lon >= 360.0) lon -= 360.0;
 
@@ -3247,55 +4404,35 @@ void SplatProcessor::PlotLRMap(struct site source, double altitude, char *plo_fi
         edge.lon = lon;
         edge.alt = altitude;
 
-        PlotLRPath(source, edge, mask_value, fd);
-        count++;
-
-        if (count == z) {
-            fprintf(stdout, "%c", symbol[x]);
-            fflush(stdout);
-            count = 0;
-
-            if (x == 3)
-                x = 0;
-            else
-                x++;
-        }
+        edges.push_back(edge);
     }
 
-    count = 0;
+    PlotLRRadials(ctx, source, edges, mask_value, fd, z);
+    edges.clear();
+
     fprintf(stdout, "\n25%c to  50%c ", 37, 37);
     fflush(stdout);
 
     z = (int)(th * (double)(max_north_ - min_north_));
 
-    for (lat = maxnorth, x = 0, y = 0; lat >= (double)min_north_;
+    for (lat = maxnorth, y = 0; lat >= (double)min_north_;
          y++, lat = maxnorth - (dpp_ * (double)y)) {
         edge.lat = lat;
         edge.lon = min_west_;
         edge.alt = altitude;
 
-        PlotLRPath(source, edge, mask_value, fd);
-        count++;
-
-        if (count == z) {
-            fprintf(stdout, "%c", symbol[x]);
-            fflush(stdout);
-            count = 0;
-
-            if (x == 3)
-                x = 0;
-            else
-                x++;
-        }
+        edges.push_back(edge);
     }
 
-    count = 0;
+    PlotLRRadials(ctx, source, edges, mask_value, fd, z);
+    edges.clear();
+
     fprintf(stdout, "\n50%c to  75%c ", 37, 37);
     fflush(stdout);
 
     z = (int)(th * ReduceAngle(max_west_ - min_west_));
 
-    for (lon = minwest, x = 0, y = 0; (LonDiff(lon, (double)max_west_) <= 0.0);
+    for (lon = minwest, y = 0; (LonDiff(lon, (double)max_west_) <= 0.0);
          y++, lon = minwest + (dpp_ * (double)y)) {
         if (lon >= 360.0) lon -= 360.0;
 
@@ -3303,54 +4440,30 @@ void SplatProcessor::PlotLRMap(struct site source, double altitude, char *plo_fi
         edge.lon = lon;
         edge.alt = altitude;
 
-        PlotLRPath(source, edge, mask_value, fd);
-        count++;
-
-        if (count == z) {
-            fprintf(stdout, "%c", symbol[x]);
-            fflush(stdout);
-            count = 0;
-
-            if (x == 3)
-                x = 0;
-            else
-                x++;
-        }
+        edges.push_back(edge);
     }
 
-    count = 0;
+    PlotLRRadials(ctx, source, edges, mask_value, fd, z);
+    edges.clear();
+
     fprintf(stdout, "\n75%c to 100%c ", 37, 37);
     fflush(stdout);
 
     z = (int)(th * (double)(max_north_ - min_north_));
 
-    for (lat = (double)min_north_, x = 0, y = 0; lat < (double)max_north_;
+    for (lat = (double)min_north_, y = 0; lat < (double)max_north_;
          y++, lat = (double)min_north_ + (dpp_ * (double)y)) {
         edge.lat = lat;
         edge.lon = max_west_;
         edge.alt = altitude;
 
-        PlotLRPath(source, edge, mask_value, fd);
-        count++;
-
-        if (count == z) {
-            fprintf(stdout, "%c", symbol[x]);
-            fflush(stdout);
-            count = 0;
-
-            if (x == 3)
-                x = 0;
-            else
-                x++;
-        }
+        edges.push_back(edge);
     }
 
-    if (fd != NULL) fclose(fd);
-
-    fprintf(stdout, "\nDone!\n");
-    fflush(stdout);
+    PlotLRRadials(ctx, source, edges, mask_value, fd, z);
+    edges.clear();
 
-    if (mask_value < 30) mask_value++;
+    EndLRMap(ctx, fd, pruned);
 
 }
 
@@ -3670,6 +4783,15 @@ void SplatProcessor::LoadDBMColors() {
 
 }
 
+static inline void PutPixel(unsigned char *&pixel, unsigned red, unsigned green, unsigned blue) {
+    /* Stores an RGB pixel and steps past it */
+
+    pixel[0] = (unsigned char)red;
+    pixel[1] = (unsigned char)green;
+    pixel[2] = (unsigned char)blue;
+    pixel += 3;
+}
+
 void SplatProcessor::WritePPM(char *filename, unsigned char geo, unsigned char kml,
                               unsigned char ngs, struct site *xmtr, unsigned char txsites) {
     /* This function generates a topographic map in Portable Pix Map
@@ -3680,10 +4802,9 @@ void SplatProcessor::WritePPM(char *filename, unsigned char geo, unsigned char k
        up and east points right in the image generated. */
 
     char mapfile[255], geofile[255], kmlfile[255];
-    unsigned char found, mask;
-    unsigned width, height, terrain;
-    int indx, x, y, x0 = 0, y0 = 0;
-    double lat, lon, conversion, one_over_gamma, north, south, east, west, minwest;
+    unsigned width, height;
+    int x, y;
+    double conversion, one_over_gamma, north, south, east, west, minwest;
     FILE *fd;
 
     one_over_gamma = 1.0 / GAMMA;
@@ -3810,122 +4931,127 @@ void SplatProcessor::WritePPM(char *filename, unsigned char geo, unsigned char k
     fprintf(stdout, "\nWriting \"%s\" (%ux%u pixmap image)... ", mapfile, width, height);
     fflush(stdout);
 
-    for (y = 0, lat = north; y < (int)height; y++, lat = north - (dpp_ * (double)y)) {
+    /* Rows are drawn on the sweep workers and written out a block
+       at a time. */
+
+    RasterStream stream(width, height, CV_8UC3, NULL, [fd](const cv::Mat &block, int) {
+        fwrite(block.data, 3, (size_t)block.rows * block.cols, fd);
+    });
+
+    RenderRows(stream, height, [&](int y, unsigned char *pixel) {
+        unsigned char found, mask;
+        unsigned terrain;
+        int x, indx, x0 = 0, y0 = 0;
+        double lat = north - (dpp_ * (double)y), lon;
+
         for (x = 0, lon = max_west_; x < (int)width;
              x++, lon = (double)max_west_ - (dpp_ * (double)x)) {
             if (lon < 0.0) lon += 360.0;
 
-            for (indx = 0, found = 0; indx < MAXPAGES && found == 0;) {
-                x0 = (int)rint(ppd_ * (lat - (double)dem_[indx].min_north));
-                y0 = mpi_ - (int)rint(ppd_ * (LonDiff((double)dem_[indx].max_west, lon)));
-
-                if (x0 >= 0 && x0 <= mpi_ && y0 >= 0 && y0 <= mpi_)
-                    found = 1;
-                else
-                    indx++;
-            }
+            indx = FindPage(lat, lon, x0, y0);
+            found = (indx >= 0);
 
             if (found) {
-                mask = dem_[indx].mask[x0][y0];
+                mask = coverage_.at(indx, x0, y0).mask;
 
                 if (mask & 2) /* Text Labels: Red */
-                    fprintf(fd, "%c%c%c", 255, 0, 0);
+                    PutPixel(pixel, 255, 0, 0);
 
                 else if (mask & 4)
                     /* County Boundaries: Light Cyan */
-                    fprintf(fd, "%c%c%c", 128, 128, 255);
+                    PutPixel(pixel, 128, 128, 255);
 
                 else
                     switch (mask & 57) {
                         case 1:
                             /* TX1: Green */
-                            fprintf(fd, "%c%c%c", 0, 255, 0);
+                            PutPixel(pixel, 0, 255, 0);
                             break;
 
                         case 8:
                             /* TX2: Cyan */
-                            fprintf(fd, "%c%c%c", 0, 255, 255);
+                            PutPixel(pixel, 0, 255, 255);
                             break;
 
                         case 9:
                             /* TX1 + TX2: Yellow */
-                            fprintf(fd, "%c%c%c", 255, 255, 0);
+                            PutPixel(pixel, 255, 255, 0);
                             break;
 
                         case 16:
                             /* TX3: Medium Violet */
-                            fprintf(fd, "%c%c%c", 147, 112, 219);
+                            PutPixel(pixel, 147, 112, 219);
                             break;
 
                         case 17:
                             /* TX1 + TX3: Pink */
-                            fprintf(fd, "%c%c%c", 255, 192, 203);
+                            PutPixel(pixel, 255, 192, 203);
                             break;
 
                         case 24:
                             /* TX2 + TX3: Orange */
-                            fprintf(fd, "%c%c%c", 255, 165, 0);
+                            PutPixel(pixel, 255, 165, 0);
                             break;
 
                         case 25:
                             /* TX1 + TX2 + TX3: Dark Green */
-                            fprintf(fd, "%c%c%c", 0, 100, 0);
+                            PutPixel(pixel, 0, 100, 0);
                             break;
 
                         case 32:
                             /* TX4: Sienna 1 */
-                            fprintf(fd, "%c%c%c", 255, 130, 71);
+                            PutPixel(pixel, 255, 130, 71);
                             break;
 
                         case 33:
                             /* TX1 + TX4: Green Yellow */
-                            fprintf(fd, "%c%c%c", 173, 255, 47);
+                            PutPixel(pixel, 173, 255, 47);
                             break;
 
                         case 40:
                             /* TX2 + TX4: Dark Sea Green 1 */
-                            fprintf(fd, "%c%c%c", 193, 255, 193);
+                            PutPixel(pixel, 193, 255, 193);
                             break;
 
                         case 41:
                             /* TX1 + TX2 + TX4: Blanched Almond */
-                            fprintf(fd, "%c%c%c", 255, 235, 205);
+                            PutPixel(pixel, 255, 235, 205);
                             break;
 
                         case 48:
                             /* TX3 + TX4: Dark Turquoise */
-                            fprintf(fd, "%c%c%c", 0, 206, 209);
+                            PutPixel(pixel, 0, 206, 209);
                             break;
 
                         case 49:
                             /* TX1 + TX3 + TX4: Medium Spring Green */
-                            fprintf(fd, "%c%c%c", 0, 250, 154);
+                            PutPixel(pixel, 0, 250, 154);
                             break;
 
                         case 56:
                             /* TX2 + TX3 + TX4: Tan */
-                            fprintf(fd, "%c%c%c", 210, 180, 140);
+                            PutPixel(pixel, 210, 180, 140);
                             break;
 
                         case 57:
                             /* TX1 + TX2 + TX3 + TX4: Gold2 */
-                            fprintf(fd, "%c%c%c", 238, 201, 0);
+                            PutPixel(pixel, 238, 201, 0);
                             break;
 
                         default:
                             if (ngs) /* No terrain */
-                                fprintf(fd, "%c%c%c", 255, 255, 255);
+                                PutPixel(pixel, 255, 255, 255);
                             else {
                                 /* Sea-level: Medium Blue */
                                 if (dem_[indx].data[x0][y0] == 0)
-                                    fprintf(fd, "%c%c%c", 0, 0, 170);
+                                    PutPixel(pixel, 0, 0, 170);
                                 else {
                                     /* Elevation: Greyscale */
                                     terrain = (unsigned)(0.5 + pow((double)(dem_[indx].data[x0][y0] -
                                                                             min_elevation_),
                                                                    one_over_gamma) *
                                                                    conversion);
-                                    fprintf(fd, "%c%c%c", terrain, terrain, terrain);
+                                    PutPixel(pixel, terrain, terrain, terrain);
                                 }
                             }
                     }
@@ -3935,10 +5061,12 @@ void SplatProcessor::WritePPM(char *filename, unsigned char geo, unsigned char k
                 /* We should never get here, but if */
                 /* we do, display the region as black */
 
-                fprintf(fd, "%c%c%c", 0, 0, 0);
+                PutPixel(pixel, 0, 0, 0);
             }
         }
-    }
+    });
+
+    stream.finish();
 
     fclose(fd);
     fprintf(stdout, "Done!\n");
@@ -3954,10 +5082,9 @@ void SplatProcessor::WritePPMLR(char *filename, unsigned char geo, unsigned char
        points up and east points right in the image generated. */
 
     char mapfile[255], geofile[255], kmlfile[255], ckfile[255];
-    unsigned width, height, red, green, blue, terrain = 0;
-    unsigned char found, mask, cityorcounty;
-    int indx, x, y, z, colorwidth, x0, y0, loss, level, hundreds, tens, units, match;
-    double lat, lon, conversion, one_over_gamma, north, south, east, west, minwest;
+    unsigned width, height, red, green, blue;
+    int indx, x, y, colorwidth, x0, y0, level, hundreds, tens, units;
+    double conversion, one_over_gamma, north, south, east, west, minwest;
     FILE *fd;
 
     one_over_gamma = 1.0 / GAMMA;
@@ -4134,23 +5261,29 @@ void SplatProcessor::WritePPMLR(char *filename, unsigned char geo, unsigned char
 
     fflush(stdout);
 
-    for (y = 0, lat = north; y < (int)height; y++, lat = north - (dpp_ * (double)y)) {
+    /* Rows, legend included, are drawn into blocks that are written
+       out as they fill; the map rows are drawn on the sweep workers. */
+
+    RasterStream stream(width, (kml || geo) ? height : height + 30, CV_8UC3, NULL,
+                        [fd](const cv::Mat &block, int) {
+                            fwrite(block.data, 3, (size_t)block.rows * block.cols, fd);
+                        });
+
+    RenderRows(stream, height, [&](int y, unsigned char *pixel) {
+        unsigned red, green, blue, terrain = 0;
+        unsigned char found, mask, cityorcounty;
+        int x, z, x0, y0, indx, loss, match;
+        double lat = north - (dpp_ * (double)y), lon;
+
         for (x = 0, lon = max_west_; x < (int)width; x++, lon = max_west_ - (dpp_ * (double)x)) {
             if (lon < 0.0) lon += 360.0;
 
-            for (indx = 0, found = 0; indx < MAXPAGES && found == 0;) {
-                x0 = (int)rint(ppd_ * (lat - (double)dem_[indx].min_north));
-                y0 = mpi_ - (int)rint(ppd_ * (LonDiff((double)dem_[indx].max_west, lon)));
-
-                if (x0 >= 0 && x0 <= mpi_ && y0 >= 0 && y0 <= mpi_)
-                    found = 1;
-                else
-                    indx++;
-            }
+            indx = FindPage(lat, lon, x0, y0);
+            found = (indx >= 0);
 
             if (found) {
-                mask = dem_[indx].mask[x0][y0];
-                loss = (dem_[indx].signal[x0][y0]);
+                mask = coverage_.at(indx, x0, y0).mask;
+                loss = (coverage_.at(indx, x0, y0).signal);
                 cityorcounty = 0;
 
                 match = 255;
@@ -4191,9 +5324,9 @@ void SplatProcessor::WritePPMLR(char *filename, unsigned char geo, unsigned char
                     /* Text Labels: Red or otherwise */
 
                     if (red >= 180 && green <= 75 && blue <= 75 && loss != 0)
-                        fprintf(fd, "%c%c%c", 255 ^ red, 255 ^ green, 255 ^ blue);
+                        PutPixel(pixel, 255 ^ red, 255 ^ green, 255 ^ blue);
                     else
-                        fprintf(fd, "%c%c%c", 255, 0, 0);
+                        PutPixel(pixel, 255, 0, 0);
 
                     cityorcounty = 1;
                 }
@@ -4201,7 +5334,7 @@ void SplatProcessor::WritePPMLR(char *filename, unsigned char geo, unsigned char
                 else if (mask & 4) {
                     /* County Boundaries: Black */
 
-                    fprintf(fd, "%c%c%c", 0, 0, 0);
+                    PutPixel(pixel, 0, 0, 0);
 
                     cityorcounty = 1;
                 }
@@ -4209,19 +5342,19 @@ void SplatProcessor::WritePPMLR(char *filename, unsigned char geo, unsigned char
                 if (cityorcounty == 0) {
                     if (loss == 0 || (contour_threshold_ != 0 && loss > abs(contour_threshold_))) {
                         if (ngs) /* No terrain */
-                            fprintf(fd, "%c%c%c", 255, 255, 255);
+                            PutPixel(pixel, 255, 255, 255);
                         else {
                             /* Display land or sea elevation */
 
                             if (dem_[indx].data[x0][y0] == 0)
-                                fprintf(fd, "%c%c%c", 0, 0, 170);
+                                PutPixel(pixel, 0, 0, 170);
                             else {
                                 terrain =
                                     (unsigned)(0.5 +
                                                pow((double)(dem_[indx].data[x0][y0] - min_elevation_),
                                                    one_over_gamma) *
                                                    conversion);
-                                fprintf(fd, "%c%c%c", terrain, terrain, terrain);
+                                PutPixel(pixel, terrain, terrain, terrain);
                             }
                         }
                     }
@@ -4230,12 +5363,12 @@ void SplatProcessor::WritePPMLR(char *filename, unsigned char geo, unsigned char
                         /* Plot path loss in color */
 
                         if (red != 0 || green != 0 || blue != 0)
-                            fprintf(fd, "%c%c%c", red, green, blue);
+                            PutPixel(pixel, red, green, blue);
 
                         else /* terrain / sea-level */
                         {
                             if (dem_[indx].data[x0][y0] == 0)
-                                fprintf(fd, "%c%c%c", 0, 0, 170);
+                                PutPixel(pixel, 0, 0, 170);
                             else {
                                 /* Elevation: Greyscale */
                                 terrain =
@@ -4243,7 +5376,7 @@ void SplatProcessor::WritePPMLR(char *filename, unsigned char geo, unsigned char
                                                pow((double)(dem_[indx].data[x0][y0] - min_elevation_),
                                                    one_over_gamma) *
                                                    conversion);
-                                fprintf(fd, "%c%c%c", terrain, terrain, terrain);
+                                PutPixel(pixel, terrain, terrain, terrain);
                             }
                         }
                     }
@@ -4254,10 +5387,10 @@ void SplatProcessor::WritePPMLR(char *filename, unsigned char geo, unsigned char
                 /* We should never get here, but if */
                 /* we do, display the region as black */
 
-                fprintf(fd, "%c%c%c", 0, 0, 0);
+                PutPixel(pixel, 0, 0, 0);
             }
         }
-    }
+    });
 
     if (kml == 0 && geo == 0) {
         /* Display legend along bottom of image
@@ -4267,6 +5400,8 @@ void SplatProcessor::WritePPMLR(char *filename, unsigned char geo, unsigned char
         colorwidth = (int)rint((float)width / (float)region_.levels);
 
         for (y0 = 0; y0 < 30; y0++) {
+            unsigned char *pixel = stream.row(height + y0);
+
             for (x0 = 0; x0 < (int)width; x0++) {
                 indx = x0 / colorwidth;
                 x = x0 % colorwidth;
@@ -4306,18 +5441,20 @@ void SplatProcessor::WritePPMLR(char *filename, unsigned char geo, unsigned char
                 }
 
                 if (indx > region_.levels)
-                    fprintf(fd, "%c%c%c", 0, 0, 0);
+                    PutPixel(pixel, 0, 0, 0);
                 else {
                     red = region_.color[indx][0];
                     green = region_.color[indx][1];
                     blue = region_.color[indx][2];
 
-                    fprintf(fd, "%c%c%c", red, green, blue);
+                    PutPixel(pixel, red, green, blue);
                 }
             }
         }
     }
 
+    stream.finish();
+
     fclose(fd);
 
     if (kml) {
@@ -4433,6 +5570,58 @@ void SplatProcessor::write_image_info_to_txt(const std::string &filename, double
     std::cout << "Image information written to " << filename << std::endl;
 }
 
+void SplatProcessor::ClassifySignals(MapPalette &palette, int offset, unsigned char dbm) {
+    /* Works out, once per map, what each of the 256 signal bytes
+       looks like, so the map writers need not search the contour
+       levels or interpolate between them for every pixel. */
+
+    unsigned red, green, blue;
+    int byte, signal, z, match;
+
+    for (byte = 0; byte < 256; byte++) {
+        signal = byte - offset;
+        match = 255;
+
+        red = 0;
+        green = 0;
+        blue = 0;
+
+        if (signal >= region_.level[0])
+            match = 0;
+        else {
+            for (z = 1; (z < region_.levels && match == 255); z++) {
+                if (signal < region_.level[z - 1] && signal >= region_.level[z]) match = z;
+            }
+        }
+
+        if (match < region_.levels) {
+            if (smooth_contours_ && match > 0) {
+                red = (unsigned)interpolate(region_.color[match][0], region_.color[match - 1][0],
+                                            region_.level[match], region_.level[match - 1], signal);
+                green = (unsigned)interpolate(region_.color[match][1], region_.color[match - 1][1],
+                                              region_.level[match], region_.level[match - 1],
+                                              signal);
+                blue = (unsigned)interpolate(region_.color[match][2], region_.color[match - 1][2],
+                                             region_.level[match], region_.level[match - 1], signal);
+            }
+
+            else {
+                red = region_.color[match][0];
+                green = region_.color[match][1];
+                blue = region_.color[match][2];
+            }
+        }
+
+        /* Signals below the contour threshold, and those matching no
+           level, leave the background showing. */
+
+        palette.setSignal(byte, red, green, blue,
+                          !(contour_threshold_ != 0 && signal < contour_threshold_) &&
+                              (red != 0 || green != 0 || blue != 0),
+                          red >= 180 && green <= 75 && blue <= 75 && (!dbm || signal != 0));
+    }
+}
+
 void SplatProcessor::WritePPMSS(char *filename, unsigned char geo, unsigned char kml,
                                 unsigned char ngs, struct site *xmtr, unsigned char txsites) {
     /* This function generates a topographic map in Portable Pix Map
@@ -4442,14 +5631,12 @@ void SplatProcessor::WritePPMSS(char *filename, unsigned char geo, unsigned char
        points up and east points right in the image generated. */
 
     char mapfile[255], geofile[255], kmlfile[255], ckfile[255];
-    unsigned width, height, terrain, red, green, blue;
-    unsigned char found, mask, cityorcounty;
-    int indx, x, y, z = 1, x0, y0, signal, level, hundreds, tens, units, match, colorwidth;
-    double conversion, one_over_gamma, lat, lon, north, south, east, west, minwest;
+    unsigned width, height, red, green, blue;
+    int indx, x, y, x0, y0, level, hundreds, tens, units, colorwidth;
+    double one_over_gamma, north, south, east, west, minwest;
     FILE *fd;
 
     one_over_gamma = 1.0 / GAMMA;
-    conversion = 255.0 / pow((double)(max_elevation_ - min_elevation_), one_over_gamma);
 
     width = (unsigned)(ippd_ * ReduceAngle(max_west_ - min_west_));
     height = (unsigned)(ippd_ * ReduceAngle(max_north_ - min_north_));
@@ -4636,133 +5823,59 @@ void SplatProcessor::WritePPMSS(char *filename, unsigned char geo, unsigned char
 
     fflush(stdout);
 
-    for (y = 0, lat = north; y < (int)height; y++, lat = north - (dpp_ * (double)y)) {
-        for (x = 0, lon = max_west_; x < (int)width; x++, lon = max_west_ - (dpp_ * (double)x)) {
-            if (lon < 0.0) lon += 360.0;
-
-            for (indx = 0, found = 0; indx < MAXPAGES && found == 0;) {
-                x0 = (int)rint(ppd_ * (lat - (double)dem_[indx].min_north));
-                y0 = mpi_ - (int)rint(ppd_ * (LonDiff((double)dem_[indx].max_west, lon)));
-
-                if (x0 >= 0 && x0 <= mpi_ && y0 >= 0 && y0 <= mpi_)
-                    found = 1;
-                else
-                    indx++;
-            }
-
-            if (found) {
-                mask = dem_[indx].mask[x0][y0];
-                signal = (dem_[indx].signal[x0][y0]) - 100;
-                cityorcounty = 0;
-
-                match = 255;
+    /* Rows, legend included, are drawn into blocks that are written
+       out as they fill; the map rows are drawn on the sweep workers. */
 
-                red = 0;
-                green = 0;
-                blue = 0;
+    RasterStream stream(width, (kml || geo) ? height : height + 30, CV_8UC3, NULL,
+                        [fd](const cv::Mat &block, int) {
+                            fwrite(block.data, 3, (size_t)block.rows * block.cols, fd);
+                        });
+    const unsigned char black[3] = {0, 0, 0};
 
-                if (signal >= region_.level[0])
-                    match = 0;
-                else {
-                    for (z = 1; (z < region_.levels && match == 255); z++) {
-                        if (signal < region_.level[z - 1] && signal >= region_.level[z]) match = z;
-                    }
-                }
+    MapPalette palette(false);
 
-                if (match < region_.levels) {
-                    if (smooth_contours_ && match > 0) {
-                        red = (unsigned)interpolate(region_.color[match][0],
-                                                    region_.color[match - 1][0], region_.level[match],
-                                                    region_.level[match - 1], signal);
-                        green = (unsigned)interpolate(
-                            region_.color[match][1], region_.color[match - 1][1], region_.level[match],
-                            region_.level[match - 1], signal);
-                        blue = (unsigned)interpolate(
-                            region_.color[match][2], region_.color[match - 1][2], region_.level[match],
-                            region_.level[match - 1], signal);
-                    }
+    ClassifySignals(palette, 100, 0);
+    palette.setTerrain(min_elevation_, max_elevation_, one_over_gamma,
+                       ngs ? MapPalette::WHITE : MapPalette::TERRAIN);
 
-                    else {
-                        red = region_.color[match][0];
-                        green = region_.color[match][1];
-                        blue = region_.color[match][2];
-                    }
-                }
+    RenderRows(stream, height, [&](int y, unsigned char *pixel) {
+        const unsigned char *color;
+        unsigned char found, spare[4];
+        int x, indx, x0, y0;
+        double lat = north - (dpp_ * (double)y), lon;
 
-                if (mask & 2) {
-                    /* Text Labels: Red or otherwise */
-
-                    if (red >= 180 && green <= 75 && blue <= 75)
-                        fprintf(fd, "%c%c%c", 255 ^ red, 255 ^ green, 255 ^ blue);
-                    else
-                        fprintf(fd, "%c%c%c", 255, 0, 0);
-
-                    cityorcounty = 1;
-                }
-
-                else if (mask & 4) {
-                    /* County Boundaries: Black */
-
-                    fprintf(fd, "%c%c%c", 0, 0, 0);
-
-                    cityorcounty = 1;
-                }
-
-                if (cityorcounty == 0) {
-                    if (contour_threshold_ != 0 && signal < contour_threshold_) {
-                        if (ngs)
-                            fprintf(fd, "%c%c%c", 255, 255, 255);
-                        else {
-                            /* Display land or sea elevation */
-
-                            if (dem_[indx].data[x0][y0] == 0)
-                                fprintf(fd, "%c%c%c", 0, 0, 170);
-                            else {
-                                terrain =
-                                    (unsigned)(0.5 +
-                                               pow((double)(dem_[indx].data[x0][y0] - min_elevation_),
-                                                   one_over_gamma) *
-                                                   conversion);
-                                fprintf(fd, "%c%c%c", terrain, terrain, terrain);
-                            }
-                        }
-                    }
+        for (x = 0, lon = max_west_; x < (int)width; x++, lon = max_west_ - (dpp_ * (double)x)) {
+            if (lon < 0.0) lon += 360.0;
 
-                    else {
-                        /* Plot field strength regions in color */
+            indx = FindPage(lat, lon, x0, y0);
+            found = (indx >= 0);
 
-                        if (red != 0 || green != 0 || blue != 0)
-                            fprintf(fd, "%c%c%c", red, green, blue);
+            if (found) {
+                const CoverageRaster::Cell &cell = coverage_.at(indx, x0, y0);
 
-                        else /* terrain / sea-level */
-                        {
-                            if (ngs)
-                                fprintf(fd, "%c%c%c", 255, 255, 255);
-                            else {
-                                if (dem_[indx].data[x0][y0] == 0)
-                                    fprintf(fd, "%c%c%c", 0, 0, 170);
-                                else {
-                                    /* Elevation: Greyscale */
-                                    terrain = (unsigned)(0.5 + pow((double)(dem_[indx].data[x0][y0] -
-                                                                            min_elevation_),
-                                                                   one_over_gamma) *
-                                                                   conversion);
-                                    fprintf(fd, "%c%c%c", terrain, terrain, terrain);
-                                }
-                            }
-                        }
-                    }
-                }
+                if (cell.mask & 2) /* Text Labels: Red or otherwise */
+                    color = palette.label(cell.signal);
+
+                else if (cell.mask & 4) /* County Boundaries: Black */
+                    color = black;
+
+                else if (palette.plotted(cell.signal)) /* Field strength regions in color */
+                    color = palette.color(cell.signal);
+
+                else /* Terrain, sea-level or no terrain */
+                    color = palette.background(dem_[indx].data[x0][y0], spare);
+
+                PutPixel(pixel, color[0], color[1], color[2]);
             }
 
             else {
                 /* We should never get here, but if */
                 /* we do, display the region as black */
 
-                fprintf(fd, "%c%c%c", 0, 0, 0);
+                PutPixel(pixel, 0, 0, 0);
             }
         }
-    }
+    });
 
     if (kml == 0 && geo == 0) {
         /* Display legend along bottom of image
@@ -4772,6 +5885,8 @@ void SplatProcessor::WritePPMSS(char *filename, unsigned char geo, unsigned char
         colorwidth = (int)rint((float)width / (float)region_.levels);
 
         for (y0 = 0; y0 < 30; y0++) {
+            unsigned char *pixel = stream.row(height + y0);
+
             for (x0 = 0; x0 < (int)width; x0++) {
                 indx = x0 / colorwidth;
                 x = x0 % colorwidth;
@@ -4823,18 +5938,20 @@ void SplatProcessor::WritePPMSS(char *filename, unsigned char geo, unsigned char
                 }
 
                 if (indx > region_.levels)
-                    fprintf(fd, "%c%c%c", 0, 0, 0);
+                    PutPixel(pixel, 0, 0, 0);
                 else {
                     red = region_.color[indx][0];
                     green = region_.color[indx][1];
                     blue = region_.color[indx][2];
 
-                    fprintf(fd, "%c%c%c", red, green, blue);
+                    PutPixel(pixel, red, green, blue);
                 }
             }
         }
     }
 
+    stream.finish();
+
     fclose(fd);
 
     if (kml) {
@@ -4930,13 +6047,11 @@ void SplatProcessor::WritePPMDBM(char *filename,
        90 degrees from its representation in dem[][] so that north
        points up and east points right in the image generated. */
     char mapfile[255]; 
-    unsigned width, height, terrain, red, green, blue;
-    unsigned char found, mask, cityorcounty;
-    int indx, x, y, z = 1, x0, y0, dBm, level, hundreds, tens, units, match, colorwidth;
-    double conversion, one_over_gamma, lat, lon, north, south, east, west, minwest;
+    unsigned width, height;
+    int x, y;
+    double one_over_gamma, north, south, east, west, minwest;
 
     one_over_gamma = 1.0 / GAMMA;
-    conversion = 255.0 / pow((double)(max_elevation_ - min_elevation_), one_over_gamma);
 
 
     width = (unsigned)(ippd_ * ReduceAngle(max_west_ - min_west_));
@@ -4989,162 +6104,60 @@ void SplatProcessor::WritePPMDBM(char *filename,
     east = (minwest < 180.0 ? -minwest : 360.0 - min_west_);
     west = (double)(max_west_ < 180 ? -max_west_ : 360 - max_west_);
 
-    // std::ostringstream oss;
-    cv::Mat image(height, width, CV_8UC3, cv::Scalar(0, 0, 0));
-
-    for (y = 0, lat = north; y < (int)height; y++, lat = north - (dpp_ * (double)y)) {
-        for (x = 0, lon = max_west_; x < (int)width; x++, lon = max_west_ - (dpp_ * (double)x)) {
-            if (lon < 0.0) lon += 360.0;
-
-            for (indx = 0, found = 0; indx < MAXPAGES && found == 0;) {
-                x0 = (int)rint(ppd_ * (lat - (double)dem_[indx].min_north));
-                y0 = mpi_ - (int)rint(ppd_ * (LonDiff((double)dem_[indx].max_west, lon)));
+    /* Rows are drawn on the sweep workers, straight into image_,
+       or block by block to the raster sink if one has been set.
+       A transparent map is drawn as BGRA, its background clear. */
 
-                if (x0 >= 0 && x0 <= mpi_ && y0 >= 0 && y0 <= mpi_)
-                    found = 1;
-                else
-                    indx++;
-            }
+    const int channels = transparent_mode_ ? 4 : 3;
+    RasterStream stream(width, height, transparent_mode_ ? CV_8UC4 : CV_8UC3, &image_,
+                        raster_sink_);
+    MapPalette palette(true);
+    const unsigned char black[4] = {0, 0, 0, 255};
 
-            if (found) {
-                mask = dem_[indx].mask[x0][y0];
-                dBm = (dem_[indx].signal[x0][y0]) - 200;
-                cityorcounty = 0;
+    ClassifySignals(palette, 200, 1);
+    palette.setTerrain(min_elevation_, max_elevation_, one_over_gamma,
+                       transparent_mode_ ? MapPalette::CLEAR
+                       : ngs             ? MapPalette::WHITE
+                                         : MapPalette::TERRAIN);
 
-                match = 255;
+    RenderRows(stream, height, [&](int y, unsigned char *pixel) {
+        const unsigned char *color;
+        unsigned char found, spare[4];
+        int x, indx, x0, y0;
+        double lat = north - (dpp_ * (double)y), lon;
 
-                red = 0;
-                green = 0;
-                blue = 0;
+        for (x = 0, lon = max_west_; x < (int)width; x++, lon = max_west_ - (dpp_ * (double)x)) {
+            if (lon < 0.0) lon += 360.0;
 
-                if (dBm >= region_.level[0])
-                    match = 0;
-                else {
-                    for (z = 1; (z < region_.levels && match == 255); z++) {
-                        if (dBm < region_.level[z - 1] && dBm >= region_.level[z]) match = z;
-                    }
-                }
+            indx = FindPage(lat, lon, x0, y0);
+            found = (indx >= 0);
 
-                if (match < region_.levels) {
-                    if (smooth_contours_ && match > 0) {
-                        red = (unsigned)interpolate(region_.color[match][0],
-                                                    region_.color[match - 1][0], region_.level[match],
-                                                    region_.level[match - 1], dBm);
-                        green = (unsigned)interpolate(
-                            region_.color[match][1], region_.color[match - 1][1], region_.level[match],
-                            region_.level[match - 1], dBm);
-                        blue = (unsigned)interpolate(
-                            region_.color[match][2], region_.color[match - 1][2], region_.level[match],
-                            region_.level[match - 1], dBm);
-                    }
+            if (found) {
+                const CoverageRaster::Cell &cell = coverage_.at(indx, x0, y0);
 
-                    else {
-                        red = region_.color[match][0];
-                        green = region_.color[match][1];
-                        blue = region_.color[match][2];
-                    }
-                }
+                if (cell.mask & 2) /* Text Labels: Red or otherwise */
+                    color = palette.label(cell.signal);
 
-                cv::Vec3b color;
+                else if (cell.mask & 4) /* County Boundaries: Black */
+                    color = black;
 
-                if (mask & 2) {
-                    /* Text Labels: Red or otherwise */
-                    if (red >= 180 && green <= 75 && blue <= 75 && dBm != 0) {
-                        color[0] = 255 ^ blue;  // OpenCV uses BGR order
-                        color[1] = 255 ^ green;
-                        color[2] = 255 ^ red;
-                    } else {
-                        color[0] = 0;    // Blue component
-                        color[1] = 0;    // Green component
-                        color[2] = 255;  // Red component
-                    }
-                    cityorcounty = 1;
-                } else if (mask & 4) {
-                    /* County Boundaries: Black */
-                    color[0] = 0;
-                    color[1] = 0;
-                    color[2] = 0;
-                    cityorcounty = 1;
-                }
+                else if (palette.plotted(cell.signal)) /* Power level regions in color */
+                    color = palette.color(cell.signal);
 
-                if (cityorcounty == 0) {
-                    if (contour_threshold_ != 0 && dBm < contour_threshold_) {
-                        if (transparent_mode_) {
-                            /* Transparent background */
-                            color[0] = 0;
-                            color[1] = 0;
-                            color[2] = 0;
-                        } else if (ngs) {
-                            /* No terrain */
-                            color[0] = 255;
-                            color[1] = 255;
-                            color[2] = 255;
-                        } else {
-                            if (dem_[indx].data[x0][y0] == 0) {
-                                /* Sea level */
-                                color[0] = 170;  // Blue
-                                color[1] = 0;    // Green
-                                color[2] = 0;    // Red
-                            } else {
-                                /* Terrain: Greyscale */
-                                terrain =
-                                    (unsigned)(0.5 +
-                                               pow((double)(dem_[indx].data[x0][y0] - min_elevation_),
-                                                   one_over_gamma) *
-                                                   conversion);
-                                color[0] = terrain;
-                                color[1] = terrain;
-                                color[2] = terrain;
-                            }
-                        }
-                    } else {
-                        /* Plot signal power level regions in color */
-                        if (red != 0 || green != 0 || blue != 0) {
-                            color[0] = blue;  // BGR order in OpenCV
-                            color[1] = green;
-                            color[2] = red;
-                        } else {
-                            /* terrain / sea-level */
-                            if (transparent_mode_) {
-                                /* Transparent background */
-                                color[0] = 0;
-                                color[1] = 0;
-                                color[2] = 0;
-                            } else if (ngs) {
-                                color[0] = 255;
-                                color[1] = 255;
-                                color[2] = 255;
-                            } else {
-                                if (dem_[indx].data[x0][y0] == 0) {
-                                    /* Sea level */
-                                    color[0] = 170;  // Blue
-                                    color[1] = 0;    // Green
-                                    color[2] = 0;    // Red
-                                } else {
-                                    /* Elevation: Greyscale */
-                                    terrain = (unsigned)(0.5 + pow((double)(dem_[indx].data[x0][y0] -
-                                                                            min_elevation_),
-                                                                   one_over_gamma) *
-                                                                   conversion);
-                                    color[0] = terrain;
-                                    color[1] = terrain;
-                                    color[2] = terrain;
-                                }
-                            }
-                        }
-                    }
-                }
-                image.at<cv::Vec3b>(y, x) = color;
+                else /* Terrain, sea-level or transparent background */
+                    color = palette.background(dem_[indx].data[x0][y0], spare);
             } else {
                 /* We should never get here, but if */
                 /* we do, display the region as black */
-                image.at<cv::Vec3b>(y, x) = cv::Vec3b(0, 0, 0);
+                color = black;
             }
+
+            memcpy(pixel, color, channels);
+            pixel += channels;
         }
-    }
+    });
 
-     image_ = image.clone();
-     cv::imwrite("ddd.png", image_);
+     stream.finish();
 
      // Write the data to a struct
      updateImageBounds(pngfile, west, north, east, south, width, height);
@@ -5173,29 +6186,29 @@ void SplatProcessor::GraphTerrain(struct site source, struct site destination, c
 
     if (clutter_ > 0.0) fd1 = fopen("clutter.gp", "wb");
 
-    for (x = 0; x < path_.length; x++) {
-        if ((path_.elevation[x] + clutter_) > maxheight) maxheight = path_.elevation[x] + clutter_;
+    for (x = 0; x < ctx_->path.length; x++) {
+        if ((ctx_->path.elevation[x] + clutter_) > maxheight) maxheight = ctx_->path.elevation[x] + clutter_;
 
-        if (path_.elevation[x] < minheight) minheight = path_.elevation[x];
+        if (ctx_->path.elevation[x] < minheight) minheight = ctx_->path.elevation[x];
 
         if (metric_) {
-            fprintf(fd, "%f\t%f\n", KM_PER_MILE * path_.distance[x],
-                    METERS_PER_FOOT * path_.elevation[x]);
+            fprintf(fd, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[x],
+                    METERS_PER_FOOT * ctx_->path.elevation[x]);
 
-            if (fd1 != NULL && x > 0 && x < path_.length - 2)
+            if (fd1 != NULL && x > 0 && x < ctx_->path.length - 2)
                 fprintf(
-                    fd1, "%f\t%f\n", KM_PER_MILE * path_.distance[x],
-                    METERS_PER_FOOT * (path_.elevation[x] == 0.0 ? path_.elevation[x]
-                                                                : (path_.elevation[x] + clutter_)));
+                    fd1, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[x],
+                    METERS_PER_FOOT * (ctx_->path.elevation[x] == 0.0 ? ctx_->path.elevation[x]
+                                                                : (ctx_->path.elevation[x] + clutter_)));
         }
 
         else {
-            fprintf(fd, "%f\t%f\n", path_.distance[x], path_.elevation[x]);
+            fprintf(fd, "%f\t%f\n", ctx_->path.distance[x], ctx_->path.elevation[x]);
 
-            if (fd1 != NULL && x > 0 && x < path_.length - 2)
+            if (fd1 != NULL && x > 0 && x < ctx_->path.length - 2)
                 fprintf(
-                    fd1, "%f\t%f\n", path_.distance[x],
-                    (path_.elevation[x] == 0.0 ? path_.elevation[x] : (path_.elevation[x] + clutter_)));
+                    fd1, "%f\t%f\n", ctx_->path.distance[x],
+                    (ctx_->path.elevation[x] == 0.0 ? ctx_->path.elevation[x] : (ctx_->path.elevation[x] + clutter_)));
         }
     }
 
@@ -5338,17 +6351,17 @@ void SplatProcessor::GraphElevation(struct site source, struct site destination,
 
     fd2 = fopen("reference.gp", "wb");
 
-    for (x = 1; x < path_.length - 1; x++) {
-        remote.lat = path_.lat[x];
-        remote.lon = path_.lon[x];
+    for (x = 1; x < ctx_->path.length - 1; x++) {
+        remote.lat = ctx_->path.lat[x];
+        remote.lon = ctx_->path.lon[x];
         remote.alt = 0.0;
         angle = ElevationAngle(destination, remote);
 
         if (clutter_ > 0.0) {
-            remote2.lat = path_.lat[x];
-            remote2.lon = path_.lon[x];
+            remote2.lat = ctx_->path.lat[x];
+            remote2.lon = ctx_->path.lon[x];
 
-            if (path_.elevation[x] != 0.0)
+            if (ctx_->path.elevation[x] != 0.0)
                 remote2.alt = clutter_;
             else
                 remote2.alt = 0.0;
@@ -5357,20 +6370,20 @@ void SplatProcessor::GraphElevation(struct site source, struct site destination,
         }
 
         if (metric_) {
-            fprintf(fd, "%f\t%f\n", KM_PER_MILE * path_.distance[x], angle);
+            fprintf(fd, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[x], angle);
 
             if (fd1 != NULL)
-                fprintf(fd1, "%f\t%f\n", KM_PER_MILE * path_.distance[x], clutter_angle);
+                fprintf(fd1, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[x], clutter_angle);
 
-            fprintf(fd2, "%f\t%f\n", KM_PER_MILE * path_.distance[x], refangle);
+            fprintf(fd2, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[x], refangle);
         }
 
         else {
-            fprintf(fd, "%f\t%f\n", path_.distance[x], angle);
+            fprintf(fd, "%f\t%f\n", ctx_->path.distance[x], angle);
 
-            if (fd1 != NULL) fprintf(fd1, "%f\t%f\n", path_.distance[x], clutter_angle);
+            if (fd1 != NULL) fprintf(fd1, "%f\t%f\n", ctx_->path.distance[x], clutter_angle);
 
-            fprintf(fd2, "%f\t%f\n", path_.distance[x], refangle);
+            fprintf(fd2, "%f\t%f\n", ctx_->path.distance[x], refangle);
         }
 
         if (angle > maxangle) maxangle = angle;
@@ -5381,13 +6394,13 @@ void SplatProcessor::GraphElevation(struct site source, struct site destination,
     }
 
     if (metric_) {
-        fprintf(fd, "%f\t%f\n", KM_PER_MILE * path_.distance[path_.length - 1], refangle);
-        fprintf(fd2, "%f\t%f\n", KM_PER_MILE * path_.distance[path_.length - 1], refangle);
+        fprintf(fd, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[ctx_->path.length - 1], refangle);
+        fprintf(fd2, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[ctx_->path.length - 1], refangle);
     }
 
     else {
-        fprintf(fd, "%f\t%f\n", path_.distance[path_.length - 1], refangle);
-        fprintf(fd2, "%f\t%f\n", path_.distance[path_.length - 1], refangle);
+        fprintf(fd, "%f\t%f\n", ctx_->path.distance[ctx_->path.length - 1], refangle);
+        fprintf(fd2, "%f\t%f\n", ctx_->path.distance[ctx_->path.length - 1], refangle);
     }
 
     fclose(fd);
@@ -5539,14 +6552,14 @@ void SplatProcessor::GraphHeight(struct site source, struct site destination, ch
 
     if (fresnel_plot) {
         lambda = 9.8425e8 / (LR_.frq_mhz * 1e6);
-        d = 5280.0 * path_.distance[path_.length - 1];
+        d = 5280.0 * ctx_->path.distance[ctx_->path.length - 1];
     }
 
     if (normalized) {
         ed = GetElevation(destination);
         es = GetElevation(source);
         nb = -destination.alt - ed;
-        nm = (-source.alt - es - nb) / (path_.distance[path_.length - 1]);
+        nm = (-source.alt - es - nb) / (ctx_->path.distance[ctx_->path.length - 1]);
     }
 
     fd = fopen("profile.gp", "wb");
@@ -5561,9 +6574,9 @@ void SplatProcessor::GraphHeight(struct site source, struct site destination, ch
         fd4 = fopen("fresnel_pt_6.gp", "wb");
     }
 
-    for (x = 0; x < path_.length - 1; x++) {
-        remote.lat = path_.lat[x];
-        remote.lon = path_.lon[x];
+    for (x = 0; x < ctx_->path.length - 1; x++) {
+        remote.lat = ctx_->path.lat[x];
+        remote.lon = ctx_->path.lon[x];
         remote.alt = 0.0;
 
         terrain = GetElevation(remote);
@@ -5586,13 +6599,13 @@ void SplatProcessor::GraphHeight(struct site source, struct site destination, ch
          */
 
         if ((LR_.frq_mhz >= 20.0) && (LR_.frq_mhz <= 20000.0) && fresnel_plot) {
-            d1 = 5280.0 * path_.distance[x];
+            d1 = 5280.0 * ctx_->path.distance[x];
             f_zone = -1.0 * sqrt(lambda * d1 * (d - d1) / d);
             fpt6_zone = f_zone * fzone_clearance_;
         }
 
         if (normalized) {
-            r = -(nm * path_.distance[x]) - nb;
+            r = -(nm * ctx_->path.distance[x]) - nb;
             height += r;
 
             if ((LR_.frq_mhz >= 20.0) && (LR_.frq_mhz <= 20000.0) && fresnel_plot) {
@@ -5605,38 +6618,38 @@ void SplatProcessor::GraphHeight(struct site source, struct site destination, ch
             r = 0.0;
 
         if (metric_) {
-            fprintf(fd, "%f\t%f\n", KM_PER_MILE * path_.distance[x], METERS_PER_FOOT * height);
+            fprintf(fd, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[x], METERS_PER_FOOT * height);
 
-            if (fd1 != NULL && x > 0 && x < path_.length - 2)
-                fprintf(fd1, "%f\t%f\n", KM_PER_MILE * path_.distance[x],
+            if (fd1 != NULL && x > 0 && x < ctx_->path.length - 2)
+                fprintf(fd1, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[x],
                         METERS_PER_FOOT * (terrain == 0.0 ? height : (height + clutter_)));
 
-            fprintf(fd2, "%f\t%f\n", KM_PER_MILE * path_.distance[x], METERS_PER_FOOT * r);
-            fprintf(fd5, "%f\t%f\n", KM_PER_MILE * path_.distance[x],
+            fprintf(fd2, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[x], METERS_PER_FOOT * r);
+            fprintf(fd5, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[x],
                     METERS_PER_FOOT * (height - terrain));
         }
 
         else {
-            fprintf(fd, "%f\t%f\n", path_.distance[x], height);
+            fprintf(fd, "%f\t%f\n", ctx_->path.distance[x], height);
 
-            if (fd1 != NULL && x > 0 && x < path_.length - 2)
-                fprintf(fd1, "%f\t%f\n", path_.distance[x],
+            if (fd1 != NULL && x > 0 && x < ctx_->path.length - 2)
+                fprintf(fd1, "%f\t%f\n", ctx_->path.distance[x],
                         (terrain == 0.0 ? height : (height + clutter_)));
 
-            fprintf(fd2, "%f\t%f\n", path_.distance[x], r);
-            fprintf(fd5, "%f\t%f\n", path_.distance[x], height - terrain);
+            fprintf(fd2, "%f\t%f\n", ctx_->path.distance[x], r);
+            fprintf(fd5, "%f\t%f\n", ctx_->path.distance[x], height - terrain);
         }
 
         if ((LR_.frq_mhz >= 20.0) && (LR_.frq_mhz <= 20000.0) && fresnel_plot) {
             if (metric_) {
-                fprintf(fd3, "%f\t%f\n", KM_PER_MILE * path_.distance[x], METERS_PER_FOOT * f_zone);
-                fprintf(fd4, "%f\t%f\n", KM_PER_MILE * path_.distance[x],
+                fprintf(fd3, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[x], METERS_PER_FOOT * f_zone);
+                fprintf(fd4, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[x],
                         METERS_PER_FOOT * fpt6_zone);
             }
 
             else {
-                fprintf(fd3, "%f\t%f\n", path_.distance[x], f_zone);
-                fprintf(fd4, "%f\t%f\n", path_.distance[x], fpt6_zone);
+                fprintf(fd3, "%f\t%f\n", ctx_->path.distance[x], f_zone);
+                fprintf(fd4, "%f\t%f\n", ctx_->path.distance[x], fpt6_zone);
             }
 
             if (f_zone < minheight) minheight = f_zone;
@@ -5654,31 +6667,31 @@ void SplatProcessor::GraphHeight(struct site source, struct site destination, ch
     }
 
     if (normalized)
-        r = -(nm * path_.distance[path_.length - 1]) - nb;
+        r = -(nm * ctx_->path.distance[ctx_->path.length - 1]) - nb;
     else
         r = 0.0;
 
     if (metric_) {
-        fprintf(fd, "%f\t%f\n", KM_PER_MILE * path_.distance[path_.length - 1], METERS_PER_FOOT * r);
-        fprintf(fd2, "%f\t%f\n", KM_PER_MILE * path_.distance[path_.length - 1], METERS_PER_FOOT * r);
+        fprintf(fd, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[ctx_->path.length - 1], METERS_PER_FOOT * r);
+        fprintf(fd2, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[ctx_->path.length - 1], METERS_PER_FOOT * r);
     }
 
     else {
-        fprintf(fd, "%f\t%f\n", path_.distance[path_.length - 1], r);
-        fprintf(fd2, "%f\t%f\n", path_.distance[path_.length - 1], r);
+        fprintf(fd, "%f\t%f\n", ctx_->path.distance[ctx_->path.length - 1], r);
+        fprintf(fd2, "%f\t%f\n", ctx_->path.distance[ctx_->path.length - 1], r);
     }
 
     if ((LR_.frq_mhz >= 20.0) && (LR_.frq_mhz <= 20000.0) && fresnel_plot) {
         if (metric_) {
-            fprintf(fd3, "%f\t%f\n", KM_PER_MILE * path_.distance[path_.length - 1],
+            fprintf(fd3, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[ctx_->path.length - 1],
                     METERS_PER_FOOT * r);
-            fprintf(fd4, "%f\t%f\n", KM_PER_MILE * path_.distance[path_.length - 1],
+            fprintf(fd4, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[ctx_->path.length - 1],
                     METERS_PER_FOOT * r);
         }
 
         else {
-            fprintf(fd3, "%f\t%f\n", path_.distance[path_.length - 1], r);
-            fprintf(fd4, "%f\t%f\n", path_.distance[path_.length - 1], r);
+            fprintf(fd3, "%f\t%f\n", ctx_->path.distance[ctx_->path.length - 1], r);
+            fprintf(fd4, "%f\t%f\n", ctx_->path.distance[ctx_->path.length - 1], r);
         }
     }
 
@@ -5953,9 +6966,9 @@ void SplatProcessor::ObstructionAnalysis(struct site xmtr, struct site rcvr, dou
        acos().  However, note the inverted comparison: if
        acos(A) > acos(B), then B > A. */
 
-    for (x = path_.length - 1; x > 0; x--) {
-        site_x.lat = path_.lat[x];
-        site_x.lon = path_.lon[x];
+    for (x = ctx_->path.length - 1; x > 0; x--) {
+        site_x.lat = ctx_->path.lat[x];
+        site_x.lon = ctx_->path.lon[x];
         site_x.alt = 0.0;
 
         h_x = GetElevation(site_x) + earthradius_ + clutter_;
@@ -6109,9 +7122,9 @@ void SplatProcessor::PathReport(struct site source, struct site destination, cha
        terminal setting and output file type.  If no extension is
        found, .png is assumed. */
 
-    int x, y, z, errnum;
-    char basename[255], term[30], ext[15], strmode[100], report_name[80], block = 0, propstring[20];
-    double maxloss = -100000.0, minloss = 100000.0, loss, haavt, angle1, angle2, azimuth,
+    int x, y, z, errnum = 0;
+    char basename[255], term[30], ext[15], strmode[100] = "", report_name[80], block = 0, propstring[20];
+    double maxloss = -100000.0, minloss = 100000.0, loss = 0.0, haavt, angle1, angle2, azimuth,
            pattern = 1.0, patterndB = 0.0, total_loss = 0.0, cos_xmtr_angle, cos_test_angle = 0.0,
            source_alt, test_alt, dest_alt, source_alt2, dest_alt2, distance, elevation,
            four_thirds_earth, field_strength, free_space_loss = 0.0, eirp = 0.0, voltage, rxp, dBm,
@@ -6176,7 +7189,7 @@ void SplatProcessor::PathReport(struct site source, struct site destination, cha
     if (got_azimuth_pattern_ || got_elevation_pattern_) {
         x = (int)rint(10.0 * (10.0 - angle2));
 
-        if (x >= 0 && x <= 1000) pattern = (double)LR_.antenna_pattern[(int)rint(azimuth)][x];
+        if (x >= 0 && x <= 1000) pattern = (double)LR_.pattern->amplitude((int)rint(azimuth), x);
 
         patterndB = 20.0 * log10(pattern);
     }
@@ -6379,25 +7392,47 @@ void SplatProcessor::PathReport(struct site source, struct site destination, cha
         /* Copy elevations plus clutter along
            path into the elev[] array. */
 
-        for (x = 1; x < path_.length - 1; x++)
-            elev_[x + 2] =
-                METERS_PER_FOOT *
-                (path_.elevation[x] == 0.0 ? path_.elevation[x] : (clutter_ + path_.elevation[x]));
-
-        /* Copy ending points without clutter */
-
-        elev_[2] = path_.elevation[0] * METERS_PER_FOOT;
-        elev_[path_.length + 1] = path_.elevation[path_.length - 1] * METERS_PER_FOOT;
+        CopyLRElevations(*ctx_);
 
         fd = fopen("profile.gp", "w");
 
         azimuth = rint(Azimuth(source, destination));
 
-        for (y = 2; y < (path_.length - 1); y++) /* path_.length-1 avoids LR error */
+        /* Determine path loss for each point along
+           the path using ITWOM's point_to_point mode
+           starting at y=2 (number_of_points = 1), the
+           shortest distance terrain can play a role in
+           path loss.  The whole path goes to the model
+           in one batch, which summarizes the profile and
+           finds the radio and climate constants once. */
+
+        std::vector<itm_receiver_type> rx(std::max(ctx_->path.length - 3, 0));
+
+        for (y = 2; y < (ctx_->path.length - 1); y++) {
+            rx[y - 2].np = y - 1; /* (number of points - 1) */
+
+            /* Distance between elevation samples */
+
+            rx[y - 2].xi = METERS_PER_MILE * (ctx_->path.distance[y] - ctx_->path.distance[y - 1]);
+            rx[y - 2].rht_m = destination.alt * METERS_PER_FOOT;
+        }
+
+        if (olditm_)
+            point_to_point_ITM_batch(ctx_->elev.data(), source.alt * METERS_PER_FOOT,
+                                     LR_.eps_dielect, LR_.sgm_conductivity, LR_.eno_ns_surfref,
+                                     LR_.frq_mhz, LR_.radio_climate, LR_.pol, LR_.conf, LR_.rel,
+                                     rx.data(), (int)rx.size(), profile_summaries_);
+        else
+            point_to_point_batch(ctx_->elev.data(), source.alt * METERS_PER_FOOT, LR_.eps_dielect,
+                                 LR_.sgm_conductivity, LR_.eno_ns_surfref, LR_.frq_mhz,
+                                 LR_.radio_climate, LR_.pol, LR_.conf, LR_.rel, rx.data(),
+                                 (int)rx.size(), profile_summaries_);
+
+        for (y = 2; y < (ctx_->path.length - 1); y++) /* ctx_->path.length-1 avoids LR error */
         {
-            distance = 5280.0 * path_.distance[y];
-            source_alt = four_thirds_earth + source.alt + path_.elevation[0];
-            dest_alt = four_thirds_earth + destination.alt + path_.elevation[y];
+            distance = 5280.0 * ctx_->path.distance[y];
+            source_alt = four_thirds_earth + source.alt + ctx_->path.elevation[0];
+            dest_alt = four_thirds_earth + destination.alt + ctx_->path.elevation[y];
             dest_alt2 = dest_alt * dest_alt;
             source_alt2 = source_alt * source_alt;
 
@@ -6413,8 +7448,8 @@ void SplatProcessor::PathReport(struct site source, struct site destination, cha
                    the first obstruction along the path. */
 
                 for (x = 2, block = 0; x < y && block == 0; x++) {
-                    distance = 5280.0 * (path_.distance[y] - path_.distance[x]);
-                    test_alt = four_thirds_earth + path_.elevation[x];
+                    distance = 5280.0 * (ctx_->path.distance[y] - ctx_->path.distance[x]);
+                    test_alt = four_thirds_earth + ctx_->path.elevation[x];
 
                     /* Calculate the cosine of the elevation
                        angle of the terrain (test point)
@@ -6439,28 +7474,9 @@ void SplatProcessor::PathReport(struct site source, struct site destination, cha
                    to the first obstruction (if it exists). */
             }
 
-            /* Determine path loss for each point along
-               the path using ITWOM's point_to_point mode
-               starting at x=2 (number_of_points = 1), the
-               shortest distance terrain can play a role in
-               path loss. */
-
-            elev_[0] = y - 1; /* (number of points - 1) */
-
-            /* Distance between elevation samples */
-
-            elev_[1] = METERS_PER_MILE * (path_.distance[y] - path_.distance[y - 1]);
-
-            if (olditm_)
-                point_to_point_ITM(
-                    elev_, source.alt * METERS_PER_FOOT, destination.alt * METERS_PER_FOOT,
-                    LR_.eps_dielect, LR_.sgm_conductivity, LR_.eno_ns_surfref, LR_.frq_mhz,
-                    LR_.radio_climate, LR_.pol, LR_.conf, LR_.rel, loss, strmode, errnum);
-            else
-                point_to_point(elev_, source.alt * METERS_PER_FOOT,
-                               destination.alt * METERS_PER_FOOT, LR_.eps_dielect,
-                               LR_.sgm_conductivity, LR_.eno_ns_surfref, LR_.frq_mhz, LR_.radio_climate,
-                               LR_.pol, LR_.conf, LR_.rel, loss, strmode, errnum);
+            loss = rx[y - 2].dbloss;
+            strcpy(strmode, rx[y - 2].strmode);
+            errnum = rx[y - 2].errnum;
 
             if (block)
                 elevation = ((acos(cos_test_angle)) / DEG2RAD) - 90.0;
@@ -6473,7 +7489,7 @@ void SplatProcessor::PathReport(struct site source, struct site destination, cha
             x = (int)rint(10.0 * (10.0 - elevation));
 
             if (x >= 0 && x <= 1000) {
-                pattern = (double)LR_.antenna_pattern[(int)azimuth][x];
+                if (LR_.pattern) pattern = (double)LR_.pattern->amplitude((int)azimuth, x);
 
                 if (pattern != 0.0) patterndB = 20.0 * log10(pattern);
             }
@@ -6484,10 +7500,10 @@ void SplatProcessor::PathReport(struct site source, struct site destination, cha
             total_loss = loss - patterndB;
 
             if (metric_)
-                fprintf(fd, "%f\t%f\n", KM_PER_MILE * path_.distance[y], total_loss);
+                fprintf(fd, "%f\t%f\n", KM_PER_MILE * ctx_->path.distance[y], total_loss);
 
             else
-                fprintf(fd, "%f\t%f\n", path_.distance[y], total_loss);
+                fprintf(fd, "%f\t%f\n", ctx_->path.distance[y], total_loss);
 
             if (total_loss > maxloss) maxloss = total_loss;
 
@@ -6818,57 +7834,209 @@ void SplatProcessor::SiteReport(const char *ppmFilePath, struct site xmtr) {
     fprintf(stdout, "\nSite analysis report written to: \"%s\"\n", reportName);
 }
 
+static int PathArraySize(int maxpages, int ippd) {
+    /* Returns the longest path (in samples) that ReadPath() will
+       trace over a pool of maxpages pages.  The page counts that
+       ./configure supported keep their original ARRAYSIZE; other
+       pool sizes are bounded by the pool's pixel count or its
+       diagonal, whichever is larger. */
+
+    static const int pages[8] = {1, 4, 9, 16, 25, 36, 49, 64};
+    static const int sd[8] = {0, 4950, 10870, 19240, 30025, 43217, 58813, 76810};
+    static const int hd[8] = {5092, 14844, 32600, 57713, 90072, 129650, 176437, 230430};
+    int x, diagonal;
+
+    for (x = 0; x < 8; x++)
+        if (pages[x] == maxpages) {
+            if (ippd == 1200 && sd[x]) return sd[x];
+
+            if (ippd == 3600) return hd[x];
+        }
+
+    diagonal = (int)ceil(M_SQRT2 * sqrt((double)maxpages) * ippd);
+
+    return (maxpages * ippd > diagonal ? maxpages * ippd : diagonal) + 10;
+}
+
+bool SplatProcessor::AllocatePage(int indx, bool data) {
+    /* Gives dem[indx] a zeroed coverage raster, and a private data
+       grid if "data" is set, allocated for the current resolution.
+       Memory is kept across loads into the same page unless the
+       resolution changes; a data grid shared with the TerrainCache
+       is never reused for loading. */
+
+    struct dem &page = dem_[indx];
+    size_t cells = (size_t)ippd_ * ippd_;
+
+    try {
+        coverage_.allocate(indx, ippd_);
+
+        if (!data)
+            page.data.cells.reset();
+
+        else if (page.data.ippd != ippd_ || page.data.cells.use_count() != 1)
+            page.data.cells.reset(new short[cells]);
+    } catch (const std::bad_alloc &) {
+        page = dem();
+        coverage_.release(indx);
+
+        fprintf(stderr, "\n*** ERROR: Out of memory allocating DEM page %d (%dx%d)\n", indx + 1,
+                ippd_, ippd_);
+        fflush(stderr);
+        return false;
+    }
+
+    page.data.ippd = ippd_;
+
+    return true;
+}
+
+bool SplatProcessor::UnshareTerrain(int indx) {
+    /* Gives dem[indx] a private copy of its data grid if the grid
+       is still shared with the TerrainCache or another processor,
+       so that user-defined terrain never leaks into other jobs. */
+
+    struct dem &page = dem_[indx];
+    size_t cells = (size_t)page.data.ippd * page.data.ippd;
+
+    if (!page.data.cells || page.data.cells.use_count() == 1) return true;
+
+    try {
+        std::shared_ptr<short[]> copy(new short[cells]);
+
+        memcpy(copy.get(), page.data.cells.get(), sizeof(short) * cells);
+        page.data.cells = copy;
+    } catch (const std::bad_alloc &) {
+        fprintf(stderr, "\n*** ERROR: Out of memory copying DEM page %d\n", indx + 1);
+        fflush(stderr);
+        return false;
+    }
+
+    return true;
+}
+
+void SplatProcessor::ReleasePages() {
+    /* Frees every DEM page and empties the pool, leaving room
+       for maxpages_ pages to be loaded by the next job. */
+
+    dem_.clear();
+    dem_.shrink_to_fit();
+    dem_.resize(maxpages_);
+    coverage_.reset(maxpages_);
+    page_index_.assign(180 * 360, -1);
+}
+
+void SplatProcessor::setMaxPages(int pages) {
+    if (pages < 1) throw std::invalid_argument("Page pool must hold at least one page");
+
+    maxpages_ = pages;
+    ReleasePages();
+}
+
+void SplatProcessor::setAdaptiveRadials(double spacing) {
+    if (spacing < 0.0) throw std::invalid_argument("Radial spacing must not be negative");
+
+    adaptive_spacing_ = spacing;
+}
+
+void SplatProcessor::setPruning(int margin_db, double window) {
+    if (window < 0.0) throw std::invalid_argument("Pruning window must not be negative");
+
+    prune_margin_ = margin_db < 0 ? -1 : margin_db;
+    prune_window_ = window;
+}
+
+double SplatProcessor::DegreeLimit() {
+    /* Returns the largest range (degrees) around a transmitter
+       that the page pool can cover, which prevents the demand
+       for a really wide coverage from allocating more "pages"
+       than the pool holds.  A side of n pages covers a range
+       of (n - 1) / 2 degrees either side of the transmitter. */
+
+    int side = (int)sqrt((double)maxpages_);
+
+    if (side >= 2) return 0.5 * (side - 1);
+
+    return (maxpages_ == 1 ? 0.125 : 0.25);
+}
+
 void SplatProcessor::LoadTopoData(int max_lon, int min_lon, int max_lat, int min_lat) {
     /* This function loads the SDF files required
        to cover the limits of the region specified. */
-    int x, y, width, ymin, ymax;
+    int x, y, width, tiles;
 
     width = ReduceAngle(max_lon - min_lon);
+    tiles = (width + 1) * (max_lat - min_lat + 1);
 
-    if ((max_lon - min_lon) <= 180.0) {
-        for (y = 0; y <= width; y++)
-            for (x = min_lat; x <= max_lat; x++) {
-                ymin = (int)(min_lon + (double)y);
+    for (y = 0; y <= width; y++)
+        for (x = min_lat; x <= max_lat; x++) {
+            if ((max_lon - min_lon) <= 180.0)
+                LoadTile(x, min_lon + y);
+            else
+                LoadTile(x, max_lon + y);
 
-                while (ymin < 0) ymin += 360;
+            ReportProgress(SMSPLAT_TERRAIN,
+                           (double)(y * (max_lat - min_lat + 1) + x - min_lat + 1) / tiles);
+        }
+}
 
-                while (ymin >= 360) ymin -= 360;
+void SplatProcessor::LoadTile(int lat, int lon) {
+    /* Loads the SDF file of the tile whose south-east corner
+       is at "lat" north, "lon" west. */
 
-                ymax = ymin + 1;
+    int ymin = lon, ymax;
+    char name[20];
 
-                while (ymax < 0) ymax += 360;
+    while (ymin < 0) ymin += 360;
 
-                while (ymax >= 360) ymax -= 360;
+    while (ymin >= 360) ymin -= 360;
 
-                if (ippd_ == 3600)
-                    snprintf(string_, 19, "%d_%d_%d_%d-hd", x, x + 1, ymin, ymax);
-                else
-                    snprintf(string_, 16, "%d_%d_%d_%d", x, x + 1, ymin, ymax);
-                LoadSDF(string_);
-            }
-    }
+    ymax = ymin + 1;
 
-    else {
-        for (y = 0; y <= width; y++)
-            for (x = min_lat; x <= max_lat; x++) {
-                ymin = max_lon + y;
+    while (ymax < 0) ymax += 360;
 
-                while (ymin < 0) ymin += 360;
+    while (ymax >= 360) ymax -= 360;
 
-                while (ymin >= 360) ymin -= 360;
+    if (ippd_ == 3600)
+        snprintf(name, 19, "%d_%d_%d_%d-hd", lat, lat + 1, ymin, ymax);
+    else
+        snprintf(name, 16, "%d_%d_%d_%d", lat, lat + 1, ymin, ymax);
+    LoadSDF(name);
+}
 
-                ymax = ymin + 1;
+void SplatProcessor::LoadSectorTopoData(struct site source, double start, double end,
+                                        int max_lon, int min_lon, int max_lat, int min_lat) {
+    /* This function loads the SDF files of the tiles, within the
+       limits given, that the sector of radius max_range_ between
+       azimuths "start" and "end" (degrees) around the source passes
+       over.  The sector is walked along great circles in steps of a
+       sixteenth of a degree, so that it cannot slip between two
+       samples across more than a sliver of a tile. */
 
-                while (ymax < 0) ymax += 360;
+    int rays, steps, r, k, lat, lon;
+    double span = end - start, step = 3959.0 * DEG2RAD / 16.0;
+    struct site point;
+    std::set<std::pair<int, int>> tiles;
 
-                while (ymax >= 360) ymax -= 360;
+    rays = (int)ceil(span * DEG2RAD * max_range_ / step) + 1;
+    steps = (int)ceil(max_range_ / step);
 
-                if (ippd_ == 3600)
-                    snprintf(string_, 19, "%d_%d_%d_%d-hd", x, x + 1, ymin, ymax);
-                else
-                    snprintf(string_, 16, "%d_%d_%d_%d", x, x + 1, ymin, ymax);
-                LoadSDF(string_);
-            }
+    for (r = 0; r <= rays; r++) {
+        for (k = 0; k <= steps; k++) {
+            point = Destination(source, start + span * r / rays,
+                                (k < steps ? step * k : max_range_));
+
+            lat = (int)floor(point.lat);
+            lon = (int)floor(point.lon) % 360;
+
+            if (lat < min_lat || lat > max_lat || LonDiff(lon, min_lon) < 0.0 ||
+                LonDiff(max_lon, lon) < 0.0)
+                continue;
+
+            if (tiles.insert(std::make_pair(lat, lon)).second) LoadTile(lat, lon);
+        }
+
+        ReportProgress(SMSPLAT_TERRAIN, (double)(r + 1) / (rays + 1));
     }
 }
 
@@ -7100,9 +8268,9 @@ void SplatProcessor::WriteKML(struct site source, struct site destination) {
     fprintf(fd, "    <altitudeMode>relativeToGround</altitudeMode>\n");
     fprintf(fd, "    <coordinates>\n");
 
-    for (x = 0; x < path_.length; x++)
-        fprintf(fd, "      %f,%f,5\n", (path_.lon[x] < 180.0 ? -path_.lon[x] : 360.0 - path_.lon[x]),
-                path_.lat[x]);
+    for (x = 0; x < ctx_->path.length; x++)
+        fprintf(fd, "      %f,%f,5\n", (ctx_->path.lon[x] < 180.0 ? -ctx_->path.lon[x] : 360.0 - ctx_->path.lon[x]),
+                ctx_->path.lat[x]);
 
     fprintf(fd, "    </coordinates>\n");
     fprintf(fd, "   </LineString>\n");
@@ -7128,10 +8296,10 @@ void SplatProcessor::WriteKML(struct site source, struct site destination) {
 
     /* Walk across the "path", indentifying obstructions along the way */
 
-    for (y = 0; y < path_.length; y++) {
-        distance = 5280.0 * path_.distance[y];
-        tx_alt = earthradius_ + source.alt + path_.elevation[0];
-        rx_alt = earthradius_ + destination.alt + path_.elevation[y];
+    for (y = 0; y < ctx_->path.length; y++) {
+        distance = 5280.0 * ctx_->path.distance[y];
+        tx_alt = earthradius_ + source.alt + ctx_->path.elevation[0];
+        rx_alt = earthradius_ + destination.alt + ctx_->path.elevation[y];
 
         /* Calculate the cosine of the elevation of the
            transmitter as seen at the temp rx point. */
@@ -7140,8 +8308,8 @@ void SplatProcessor::WriteKML(struct site source, struct site destination) {
                          (2.0 * rx_alt * distance);
 
         for (x = y, block = 0; x >= 0 && block == 0; x--) {
-            distance = 5280.0 * (path_.distance[y] - path_.distance[x]);
-            test_alt = earthradius_ + path_.elevation[x];
+            distance = 5280.0 * (ctx_->path.distance[y] - ctx_->path.distance[x]);
+            test_alt = earthradius_ + ctx_->path.elevation[x];
 
             cos_test_angle = ((rx_alt * rx_alt) + (distance * distance) - (test_alt * test_alt)) /
                              (2.0 * rx_alt * distance);
@@ -7158,10 +8326,10 @@ void SplatProcessor::WriteKML(struct site source, struct site destination) {
 
         if (block)
             fprintf(fd, "      %f,%f,-30\n",
-                    (path_.lon[y] < 180.0 ? -path_.lon[y] : 360.0 - path_.lon[y]), path_.lat[y]);
+                    (ctx_->path.lon[y] < 180.0 ? -ctx_->path.lon[y] : 360.0 - ctx_->path.lon[y]), ctx_->path.lat[y]);
         else
             fprintf(fd, "      %f,%f,5\n",
-                    (path_.lon[y] < 180.0 ? -path_.lon[y] : 360.0 - path_.lon[y]), path_.lat[y]);
+                    (ctx_->path.lon[y] < 180.0 ? -ctx_->path.lon[y] : 360.0 - ctx_->path.lon[y]), ctx_->path.lat[y]);
     }
 
     fprintf(fd, "    </coordinates>\n");
@@ -7222,6 +8390,7 @@ void SplatProcessor::printHelp(const char *splat_name, const char *splat_version
     fprintf(stdout, "      -gc ground clutter height (feet/meters)\n");
     fprintf(stdout, "     -ngs display greyscale topography as white in .ppm files\n");
     fprintf(stdout, "     -trans display transparent topography in .ppm files\n");
+    fprintf(stdout, "            (the -dbm image buffer gets an alpha channel)\n");
     fprintf(stdout, "     -erp override ERP in .lrp file (Watts)\n");
     fprintf(stdout, "     -ano name of alphanumeric output file\n");
     fprintf(stdout, "     -ani name of alphanumeric input file\n");
@@ -7232,17 +8401,24 @@ void SplatProcessor::printHelp(const char *splat_name, const char *splat_version
     fprintf(stdout, "     -log copy command line string to this output file\n");
     fprintf(stdout, "   -gpsav preserve gnuplot temporary working files after SPLAT! execution\n");
     fprintf(stdout, "  -metric employ metric rather than imperial units for all user I/O\n");
-    fprintf(stdout, "  -olditm invoke Longley-Rice rather than the default ITWOM model\n\n");
+    fprintf(stdout, "  -olditm invoke Longley-Rice rather than the default ITWOM model\n");
+    fprintf(stdout, " -threads number of -L/-LA sweep threads (default = one per CPU)\n");
+    fprintf(stdout, "      -hd use 1 arc-second (-hd.sdf) rather than 3 arc-second terrain\n");
+    fprintf(stdout, "-maxpages number of one degree terrain pages that may be loaded\n");
+    fprintf(stdout, "   -prune stop -L/-LA radials this many dB below the plotted contours,\n");
+    fprintf(stdout, "          optionally followed by the distance they must stay there (default 5)\n");
+    fprintf(stdout, "-adaptive space -L/-LA radials for the coverage radius, at most this many\n");
+    fprintf(stdout, "          pixels apart (default 1), and interpolate pixels between them\n\n");
     fprintf(stdout, "If that flew by too fast, consider piping the output through 'less':\n");
 
-    if (HD_MODE == 0)
+    if (hd_mode_ == 0)
         fprintf(stdout, "\n\tsplat | less\n\n");
     else
         fprintf(stdout, "\n\tsplat-hd | less\n\n");
 
     fprintf(stdout, "Type 'man splat', or see the documentation for more details.\n\n");
 
-    y = (int)sqrt((int)MAXPAGES);
+    y = (int)sqrt((double)maxpages_);
 
     fprintf(stdout, "This compilation of %s supports analysis over a region of %d square\n",
             splat_name_, y);
@@ -7263,76 +8439,60 @@ void SplatProcessor::prepareHeader(const char *splat_name, const char *splat_ver
     sprintf(header, "\n\t\t--==[ Welcome To %s v%s ]==--\n\n", splat_name, splat_version);
 }
 
-void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y) {
-    auto start = std::chrono::high_resolution_clock::now();
-    int x, z = 0, min_lat, min_lon, max_lat, max_lon, rxlat, rxlon, txlat, txlon, west_min,
-           west_max, north_min, north_max;
+SplatProcessor::Job::Job() {
+    for (int x = 0; x < 32; x++) {
+        tx_site[x].lat = 91.0;
+        tx_site[x].lon = 361.0;
+        tx_site[x].alt = 0.0;
+        tx_site[x].name[0] = 0;
+        tx_site[x].filename[0] = 0;
+    }
 
-    unsigned char coverage = 0, LRmap = 0, terrain_plot = 0, elevation_plot = 0, height_plot = 0,
-                  map = 0, longley_plot = 0, cities = 0, bfs = 0, txsites = 0, norm = 0,
-                  topomap = 0, geo = 0, kml = 0, pt2pt_mode = 0, area_mode = 0, max_txsites,
-                  ngs = 0, nolospath = 0, nositereports = 0, fresnel_plot = 1, command_line_log = 0;
+    rx_site = tx_site[0];
+}
 
-    char mapfile[255], city_file[5][255], elevation_file[255], height_file[255], longley_file[255],
-        terrain_file[255], string[255], rxfile[255],
-        *env = NULL, txfile[255], boundary_file[5][255], udt_file[255], rxsite = 0,
-        ani_filename[255], ano_filename[255], ext[20], logfile[255];
+static const char *DefaultSDFPath() {
+    /* Returns the SDF path given in $HOME/.splat_path, or "" if
+       there is no such file.  The file is only read once. */
 
-    double altitude = 0.0, altitudeLR = 0.0, tx_range = 0.0, rx_range = 0.0, deg_range = 0.0,
-           deg_limit = 0.0, deg_range_lon, er_mult;
+    static const std::string path = [] {
+        char string[255] = "";
+        const char *env = getenv("HOME");
+        int x;
 
-    struct site tx_site[32], rx_site;
+        snprintf(string, 253, "%s/.splat_path", env ? env : "");
 
-    FILE *fd;
+        FILE *fd = fopen(string, "r");
 
-    olditm_ = 0;
-    kml = 0;
-    geo = 0;
-    dbm_ = 0;
-    gpsav_ = 0;
-    metric_ = 0;  // CHECK
-    rxfile[0] = 0;
-    txfile[0] = 0;
-    string[0] = 0;
-    mapfile[0] = 0;
-    clutter_ = 0.0;
-    forced_erp_ = -1.0;
-    forced_freq_ = 0.0;
-    elevation_file[0] = 0;
-    terrain_file[0] = 0;
-    sdf_path_[0] = 0;
-    udt_file[0] = 0;
-    path_.length = 0;
-    max_txsites = 30;
-    fzone_clearance_ = 0.6;  // CHECK
-    contour_threshold_ = 0;
-    rx_site.lat = 91.0;
-    rx_site.lon = 361.0;
-    longley_file[0] = 0;
-    ano_filename[0] = 0;
-    ani_filename[0] = 0;
-    smooth_contours_ = 0;
-    earthradius_ = EARTHRADIUS;
-
-    ippd_ = IPPD;        /* pixels per degree (integer) */
-    ppd_ = (double)ippd_; /* pixels per degree (double)  */
-    dpp_ = 1.0 / ppd_;    /* degrees per pixel */
-    mpi_ = ippd_ - 1;     /* maximum pixel index per degree */
-
-    for (x = 0; x < 4; x++) {
-        tx_site[x].lat = 91.0;
-        tx_site[x].lon = 361.0;
-    }
+        string[0] = 0;
 
-    for (x = 0; x < MAXPAGES; x++) {
-        dem_[x].min_el = 32768;
-        dem_[x].max_el = -32768;
-        dem_[x].min_north = 90;
-        dem_[x].max_north = -90;
-        dem_[x].min_west = 360;
-        dem_[x].max_west = -1;
-    }
+        if (fd != NULL) {
+            if (fgets(string, 253, fd) == NULL) string[0] = 0;
+
+            /* Remove <CR> and/or <LF> from string */
+
+            for (x = 0; string[x] != 13 && string[x] != 10 && string[x] != 0 && x < 253; x++)
+                ;
+            string[x] = 0;
+
+            fclose(fd);
+        }
+
+        return std::string(string);
+    }();
+
+    return path.c_str();
+}
+
+void SplatProcessor::ParseJob(int argc, char *argv[], Job &job) {
+    int x, y = argc - 1, z = 0;
 
+    job = Job();
+
+    for (x = 0; x < argc; x++) {
+        job.command_line += argv[x];
+        job.command_line += ' ';
+    }
 
     /* Scan for command line arguments */
         for (x = 1; x <= y; x++)
@@ -7343,13 +8503,13 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    sscanf(argv[z], "%lf", &max_range_);
+                    sscanf(argv[z], "%lf", &job.max_range);
 
-                    if (max_range_ < 0.0)
-                        max_range_ = 0.0;
+                    if (job.max_range < 0.0)
+                        job.max_range = 0.0;
 
-                    if (max_range_ > 1000.0)
-                        max_range_ = 1000.0;
+                    if (job.max_range > 1000.0)
+                        job.max_range = 1000.0;
                 }
             }
 
@@ -7359,15 +8519,13 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    sscanf(argv[z], "%lf", &er_mult);
+                    sscanf(argv[z], "%lf", &job.er_mult);
 
-                    if (er_mult < 0.1)
-                        er_mult = 1.0;
+                    if (job.er_mult < 0.1)
+                        job.er_mult = 1.0;
 
-                    if (er_mult > 1.0e6)
-                        er_mult = 1.0e6;
-
-                    earthradius_ *= er_mult;
+                    if (job.er_mult > 1.0e6)
+                        job.er_mult = 1.0e6;
                 }
             }
 
@@ -7377,10 +8535,10 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    sscanf(argv[z], "%lf", &clutter_);
+                    sscanf(argv[z], "%lf", &job.clutter);
 
-                    if (clutter_ < 0.0)
-                        clutter_ = 0.0;
+                    if (job.clutter < 0.0)
+                        job.clutter = 0.0;
                 }
             }
 
@@ -7390,28 +8548,25 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    sscanf(argv[z], "%lf", &fzone_clearance_);
+                    sscanf(argv[z], "%lf", &job.fzone_clearance);
 
-                    if (fzone_clearance_ < 0.0 || fzone_clearance_ > 100.0)
-                        fzone_clearance_ = 60.0;
+                    if (job.fzone_clearance < 0.0 || job.fzone_clearance > 100.0)
+                        job.fzone_clearance = 60.0;
 
-                    fzone_clearance_ /= 100.0;
+                    job.fzone_clearance /= 100.0;
                 }
             }
 
-            strncpy(mapfile, mapFilePath_.c_str(), 253);
-            map = 1;
-
             if (strcmp(argv[x], "-log") == 0)
             {
                 z = x + 1;
 
-                logfile[0] = 0;
+                job.logfile[0] = 0;
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
-                    strncpy(logfile, argv[z], 253);
+                    strncpy(job.logfile, argv[z], 253);
 
-                command_line_log = 1;
+                job.command_line_log = 1;
             }
 
             if (strcmp(argv[x], "-udt") == 0)
@@ -7419,7 +8574,7 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
                 z = x + 1;
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
-                    strncpy(udt_file, argv[z], 253);
+                    strncpy(job.udt_file, argv[z], 253);
             }
 
             if (strcmp(argv[x], "-c") == 0)
@@ -7428,11 +8583,10 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    sscanf(argv[z], "%lf", &altitude);
-                    map = 1;
-                    coverage = 1;
-                    area_mode = 1;
-                    max_txsites = 4;
+                    sscanf(argv[z], "%lf", &job.altitude);
+                    job.coverage = 1;
+                    job.area_mode = 1;
+                    job.max_txsites = 4;
                 }
             }
 
@@ -7441,7 +8595,7 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
                 z = x + 1;
 
                 if (z <= y && argv[z][0]) /* A minus argument is legal here */
-                    sscanf(argv[z], "%d", &contour_threshold_);
+                    sscanf(argv[z], "%d", &job.contour_threshold);
             }
 
             if (strcmp(argv[x], "-p") == 0)
@@ -7450,9 +8604,9 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    strncpy(terrain_file, argv[z], 253);
-                    terrain_plot = 1;
-                    pt2pt_mode = 1;
+                    strncpy(job.terrain_file, argv[z], 253);
+                    job.terrain_plot = 1;
+                    job.pt2pt_mode = 1;
                 }
             }
 
@@ -7462,9 +8616,9 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    strncpy(elevation_file, argv[z], 253);
-                    elevation_plot = 1;
-                    pt2pt_mode = 1;
+                    strncpy(job.elevation_file, argv[z], 253);
+                    job.elevation_plot = 1;
+                    job.pt2pt_mode = 1;
                 }
             }
 
@@ -7474,51 +8628,93 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    strncpy(height_file, argv[z], 253);
-                    height_plot = 1;
-                    pt2pt_mode = 1;
+                    strncpy(job.height_file, argv[z], 253);
+                    job.height_plot = 1;
+                    job.pt2pt_mode = 1;
                 }
 
                 if (strcmp(argv[x], "-H") == 0)
-                    norm = 1;
+                    job.norm = 1;
                 else
-                    norm = 0;
+                    job.norm = 0;
             }
 
             if (strcmp(argv[x], "-metric") == 0)
-                metric_ = 1;
+                job.metric = 1;
 
             if (strcmp(argv[x], "-gpsav") == 0)
-                gpsav_ = 1;
+                job.gpsav = 1;
 
             if (strcmp(argv[x], "-geo") == 0)
-                geo = 1;
+                job.geo = 1;
 
             if (strcmp(argv[x], "-kml") == 0)
-                kml = 1;
+                job.kml = 1;
 
             if (strcmp(argv[x], "-nf") == 0)
-                fresnel_plot = 0;
+                job.fresnel_plot = 0;
 
             if (strcmp(argv[x], "-ngs") == 0)
-                ngs = 1;
+                job.ngs = 1;
 
             if (strcmp(argv[x], "-n") == 0)
-                nolospath = 1;
+                job.nolospath = 1;
 
             if (strcmp(argv[x], "-dbm") == 0)
-                dbm_ = 1;
+                job.dbm = 1;
 
             if (strcmp(argv[x], "-sc") == 0)
-                smooth_contours_ = 1;
+                job.smooth_contours = 1;
 
             if (strcmp(argv[x], "-olditm") == 0)
-                olditm_ = 1;
+                job.olditm = 1;
+
+            if (strcmp(argv[x], "-threads") == 0)
+            {
+                z = x + 1;
+
+                if (z <= y && argv[z][0] && argv[z][0] != '-')
+                    threads_ = (unsigned int)atoi(argv[z]);
+            }
+
+            if (strcmp(argv[x], "-hd") == 0)
+                hd_mode_ = 1;
+
+            if (strcmp(argv[x], "-maxpages") == 0)
+            {
+                z = x + 1;
+
+                if (z <= y && argv[z][0] && argv[z][0] != '-' && atoi(argv[z]) > 0)
+                    maxpages_ = atoi(argv[z]);
+            }
+
+            if (strcmp(argv[x], "-adaptive") == 0)
+            {
+                z = x + 1;
+                adaptive_spacing_ = 1.0;
+
+                if (z <= y && argv[z][0] && argv[z][0] != '-' && atof(argv[z]) > 0.0)
+                    adaptive_spacing_ = atof(argv[z]);
+            }
+
+            if (strcmp(argv[x], "-prune") == 0)
+            {
+                z = x + 1;
+
+                if (z <= y && argv[z][0] && argv[z][0] != '-')
+                {
+                    prune_margin_ = abs(atoi(argv[z]));
+                    z++;
+
+                    if (z <= y && argv[z][0] && argv[z][0] != '-')
+                        prune_window_ = fabs(atof(argv[z]));
+                }
+            }
 
             if (strcmp(argv[x], "-N") == 0)
             {
-                nolospath = 1;
-                nositereports = 1;
+                job.nolospath = 1;
+                job.nositereports = 1;
             }
 
             if (strcmp(argv[x], "-d") == 0)
@@ -7526,7 +8722,7 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
                 z = x + 1;
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
-                    strncpy(sdf_path_, argv[z], 253);
+                    strncpy(job.sdf_path, argv[z], 253);
             }
             if (strcmp(argv[x], "-t") == 0)
             {
@@ -7535,26 +8731,26 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
                 // Check if transmitter name is provided
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    strncpy(tx_site[0].name, argv[z], 49);
+                    strncpy(job.tx_site[0].name, argv[z], 49);
 
                     // Check for latitude
                     z++;
                     if (z <= y && argv[z][0] && argv[z][0] != '-')
                     {
-                        sscanf(argv[z], "%lf", &tx_site[0].lat);
+                        sscanf(argv[z], "%lf", &job.tx_site[0].lat);
 
                         // Check for longitude
                         z++;
                         if (z <= y && argv[z][0] && argv[z][0] != '-')
                         {
-                            sscanf(argv[z], "%lf", &tx_site[0].lon);
+                            sscanf(argv[z], "%lf", &job.tx_site[0].lon);
 
                             // First negate the longitude value if needed
-                            tx_site[0].lon = -tx_site[0].lon;
+                            job.tx_site[0].lon = -job.tx_site[0].lon;
 
                             // Then apply the same normalization as in LoadQTH
-                            if (tx_site[0].lon < 0.0)
-                                tx_site[0].lon += 360.0;
+                            if (job.tx_site[0].lon < 0.0)
+                                job.tx_site[0].lon += 360.0;
 
                             // Check for altitude
                             z++;
@@ -7571,9 +8767,9 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
                                 if (result == 1)
                                 {
                                     // Always convert from meters to feet
-                                    tx_site[0].alt = altitude_meters * 3.28084;
+                                    job.tx_site[0].alt = altitude_meters * 3.28084;
                                     printf("DEBUG: Parsed altitude: %f meters = %f feet\n",
-                                           altitude_meters, tx_site[0].alt);
+                                           altitude_meters, job.tx_site[0].alt);
                                 }
                                 else
                                 {
@@ -7583,10 +8779,10 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
                                 }
 
                                 // Initialize filename based on transmitter name
-                                snprintf(tx_site[0].filename, 254, "%s.qth", tx_site[0].name);
+                                snprintf(job.tx_site[0].filename, 254, "%s.qth", job.tx_site[0].name);
 
                                 // Validate parameters
-                                if (tx_site[0].lat < -90.0 || tx_site[0].lat > 90.0)
+                                if (job.tx_site[0].lat < -90.0 || job.tx_site[0].lat > 90.0)
                                 {
                                     fprintf(stderr, "Error: Transmitter latitude must be between -90 and 90 degrees\n");
                                     fflush(stderr);
@@ -7594,14 +8790,14 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
                                 }
 
                                 // After normalization, longitude should be 0-360
-                                if (tx_site[0].lon < 0.0 || tx_site[0].lon > 360.0)
+                                if (job.tx_site[0].lon < 0.0 || job.tx_site[0].lon > 360.0)
                                 {
                                     fprintf(stderr, "Error: Normalized transmitter longitude must be between 0 and 360 degrees\n");
                                     fflush(stderr);
                                     exit(1);
                                 }
 
-                                if (tx_site[0].alt < 0)
+                                if (job.tx_site[0].alt < 0)
                                 {
                                     fprintf(stderr, "Error: Transmitter altitude must be non-negative\n");
                                     fflush(stderr);
@@ -7609,9 +8805,9 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
                                 }
 
                                 // Increment txsites counter since we've successfully added a transmitter
-                                txsites = 1;
+                                job.txsites = 1;
                                 printf("DEBUG: Final values - lat: %f, lon: %f, alt: %f\n",
-                                       tx_site[0].lat, tx_site[0].lon, tx_site[0].alt);
+                                       job.tx_site[0].lat, job.tx_site[0].lon, job.tx_site[0].alt);
 
                                 x = z; // Update x to skip the processed arguments
                             }
@@ -7651,12 +8847,11 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    sscanf(argv[z], "%lf", &altitudeLR);
-                    map = 1;
-                    LRmap = 1;
-                    area_mode = 1;
+                    sscanf(argv[z], "%lf", &job.altitudeLR);
+                    job.LRmap = 1;
+                    job.area_mode = 1;
 
-                    if (coverage)
+                    if (job.coverage)
                         fprintf(stdout, "c and L are exclusive options, ignoring L.\n");
                 }
             }
@@ -7664,7 +8859,7 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
             {
                 fprintf(stdout, "trasnparent mode activated");
                 fflush(stdout);
-                transparent_mode_ = 1; // Enable transparency mode
+                job.transparent = 1; // Enable transparency mode
             }
             if (strcmp(argv[x], "-LA") == 0)
             {
@@ -7673,27 +8868,26 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
                 // Check if altitude is provided
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    sscanf(argv[z], "%lf", &altitudeLR);
+                    sscanf(argv[z], "%lf", &job.altitudeLR);
 
                     // Check for start angle
                     z++;
                     if (z <= y && argv[z][0] && argv[z][0] != '-')
                     {
-                        sscanf(argv[z], "%lf", &start_angle_);
+                        sscanf(argv[z], "%lf", &job.start_angle);
 
                         // Check for end angle
                         z++;
                         if (z <= y && argv[z][0] && argv[z][0] != '-')
                         {
-                            sscanf(argv[z], "%lf", &end_angle_);
+                            sscanf(argv[z], "%lf", &job.end_angle);
 
                             // Enable specified angle mode
-                            map = 1;
-                            LRmap = 1;
-                            area_mode = 1;
-                            specified_angle_mode_ = 1; // New flag for -LA option
+                                    job.LRmap = 1;
+                            job.area_mode = 1;
+                            job.specified_angle_mode = 1; // New flag for -LA option
 
-                            if (coverage)
+                            if (job.coverage)
                                 fprintf(stdout,
                                         "specified_angle_mode is set in -L coverage settings.\n");
                         }
@@ -7725,9 +8919,9 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    strncpy(longley_file, argv[z], 253);
-                    longley_plot = 1;
-                    pt2pt_mode = 1;
+                    strncpy(job.longley_file, argv[z], 253);
+                    job.longley_plot = 1;
+                    job.pt2pt_mode = 1;
                 }
             }
 
@@ -7739,10 +8933,10 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    strncpy(rxfile, argv[z], 253);
-                    rx_site = LoadQTH(rxfile);
-                    rxsite = 1;
-                    pt2pt_mode = 1;
+                    strncpy(job.rxfile, argv[z], 253);
+                    job.rx_site = LoadQTH(job.rxfile);
+                    job.rxsite = 1;
+                    job.pt2pt_mode = 1;
                 }
             }
 
@@ -7752,10 +8946,10 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 z = x + 1;
 
-                while (z <= y && argv[z][0] && argv[z][0] != '-' && cities < 5)
+                while (z <= y && argv[z][0] && argv[z][0] != '-' && job.cities < 5)
                 {
-                    strncpy(city_file[cities], argv[z], 253);
-                    cities++;
+                    strncpy(job.city_file[job.cities], argv[z], 253);
+                    job.cities++;
                     z++;
                 }
 
@@ -7768,10 +8962,10 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 z = x + 1;
 
-                while (z <= y && argv[z][0] && argv[z][0] != '-' && bfs < 5)
+                while (z <= y && argv[z][0] && argv[z][0] != '-' && job.bfs < 5)
                 {
-                    strncpy(boundary_file[bfs], argv[z], 253);
-                    bfs++;
+                    strncpy(job.boundary_file[job.bfs], argv[z], 253);
+                    job.bfs++;
                     z++;
                 }
 
@@ -7784,13 +8978,13 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    sscanf(argv[z], "%lf", &forced_freq_);
+                    sscanf(argv[z], "%lf", &job.forced_freq);
 
-                    if (forced_freq_ < 20.0)
-                        forced_freq_ = 0.0;
+                    if (job.forced_freq < 20.0)
+                        job.forced_freq = 0.0;
 
-                    if (forced_freq_ > 20.0e3)
-                        forced_freq_ = 20.0e3;
+                    if (job.forced_freq > 20.0e3)
+                        job.forced_freq = 20.0e3;
                 }
             }
 
@@ -7800,10 +8994,10 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
                 {
-                    sscanf(argv[z], "%lf", &forced_erp_);
+                    sscanf(argv[z], "%lf", &job.forced_erp);
 
-                    if (forced_erp_ < 0.0)
-                        forced_erp_ = -1.0;
+                    if (job.forced_erp < 0.0)
+                        job.forced_erp = -1.0;
                 }
             }
 
@@ -7812,7 +9006,7 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
                 z = x + 1;
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
-                    strncpy(ano_filename, argv[z], 253);
+                    strncpy(job.ano_filename, argv[z], 253);
             }
 
             if (strcmp(argv[x], "-ani") == 0)
@@ -7820,625 +9014,637 @@ void SplatProcessor::parseArguments(int argc, char *argv[], char *header, int &y
                 z = x + 1;
 
                 if (z <= y && argv[z][0] && argv[z][0] != '-')
-                    strncpy(ani_filename, argv[z], 253);
+                    strncpy(job.ani_filename, argv[z], 253);
             }
         }
+}
 
-        /* Perform some error checking on the arguments
-           and switches parsed from the command-line.
-           If an error is encountered, print a message
-           and exit gracefully. */
-        if (tx_site[0].name == nullptr || tx_site[0].lat == 91.0 || tx_site[0].lon == 361.0 || tx_site[0].alt == 0.0)
-        {
-            fprintf(stderr, "\n%c*** ERROR: No transmitter site(s) specified!\n\n", 7);
-            exit(-1);
-        }
+void SplatProcessor::RunJob(const Job &request) {
+    auto start = std::chrono::high_resolution_clock::now();
+    int x, y, z = 0, min_lat, min_lon, max_lat, max_lon, rxlat, rxlon, txlat, txlon, west_min,
+           west_max, north_min, north_max;
+    unsigned char map = 1, topomap = 0;
+    char mapfile[255], string[255], txfile[255], ext[20];
+    double tx_range = 0.0, rx_range = 0.0, deg_range = 0.0, deg_limit = 0.0, deg_range_lon;
+    FILE *fd;
+    char header[80];
 
-        for (x = 0, y = 0; x < txsites; x++)
-        {
-            if (tx_site[x].lat == 91.0 && tx_site[x].lon == 361.0)
-            {
-                fprintf(stderr, "\n*** ERROR: Transmitter site #%d not found!", x + 1);
-                y++;
-            }
-        }
+    /* The run completes a copy of the job with the heights,
+       file names and sites it derives from it. */
 
-        if (y)
-        {
-            fprintf(stderr, "%c\n\n", 7);
-            exit(-1);
-        }
+    Job job = request;
 
-        if ((coverage + LRmap + ani_filename[0]) == 0 && rx_site.lat == 91.0 && rx_site.lon == 361.0)
-        {
-            if (max_range_ != 0.0 && txsites != 0)
-            {
-                /* Plot topographic map of radius "max_range_" */
+    prepareHeader(splat_name_, splat_version_, header);
 
-                map = 0;
-                topomap = 1;
-            }
+    olditm_ = job.olditm;
+    got_elevation_pattern_ = 0;
+    got_azimuth_pattern_ = 0;
+    LR_.pattern.reset();
+    dbm_ = job.dbm;
+    gpsav_ = job.gpsav;
+    metric_ = job.metric;
+    clutter_ = job.clutter;
+    forced_erp_ = job.forced_erp;
+    forced_freq_ = job.forced_freq;
+    strncpy(sdf_path_, job.sdf_path, 253);
+    sdf_path_[253] = 0;
+    ctx_->path.length = 0;
+    fzone_clearance_ = job.fzone_clearance;
+    contour_threshold_ = job.contour_threshold;
+    pruned_points_ = 0;
+    smooth_contours_ = job.smooth_contours;
+    earthradius_ = EARTHRADIUS * job.er_mult;
+    max_range_ = job.max_range;
+    transparent_mode_ = job.transparent;
+    start_angle_ = job.start_angle;
+    end_angle_ = job.end_angle;
+    specified_angle_mode_ = job.specified_angle_mode;
+    txfile[0] = 0;
+    string[0] = 0;
+    strncpy(mapfile, mapFilePath_.c_str(), 253);
+    mapfile[253] = 0;
+
+    /* Resolution and page pool size are only known once
+       -hd and -maxpages have been seen.  Start the job
+       with an empty pool; pages are allocated as loaded. */
+
+    ippd_ = (hd_mode_ ? 3600 : 1200); /* pixels per degree (integer) */
+    ppd_ = (double)ippd_;            /* pixels per degree (double)  */
+    dpp_ = 1.0 / ppd_;               /* degrees per pixel */
+    mpi_ = ippd_ - 1;                /* maximum pixel index per degree */
+
+    ReleasePages();
+    arraysize_ = PathArraySize(maxpages_, ippd_);
+
+    /* Perform some error checking on the arguments
+       and switches parsed from the command-line.
+       If an error is encountered, print a message
+       and exit gracefully. */
+    if (job.tx_site[0].name == nullptr || job.tx_site[0].lat == 91.0 || job.tx_site[0].lon == 361.0 || job.tx_site[0].alt == 0.0)
+    {
+        fprintf(stderr, "\n%c*** ERROR: No transmitter site(s) specified!\n\n", 7);
+        exit(-1);
+    }
 
-            else
-            {
-                fprintf(stderr, "\n%c*** ERROR: No receiver site found or specified!\n\n", 7);
-                exit(-1);
-            }
+    for (x = 0, y = 0; x < job.txsites; x++)
+    {
+        if (job.tx_site[x].lat == 91.0 && job.tx_site[x].lon == 361.0)
+        {
+            fprintf(stderr, "\n*** ERROR: Transmitter site #%d not found!", x + 1);
+            y++;
         }
+    }
+
+    if (y)
+    {
+        fprintf(stderr, "%c\n\n", 7);
+        exit(-1);
+    }
 
-        /* No major errors were detected.  Whew!  :-) */
+    if ((job.coverage + job.LRmap + job.ani_filename[0]) == 0 && job.rx_site.lat == 91.0 && job.rx_site.lon == 361.0)
+    {
+        if (max_range_ != 0.0 && job.txsites != 0)
+        {
+            /* Plot topographic map of radius "max_range_" */
 
-        /* Adjust input parameters if -metric option is used */
+            map = 0;
+            topomap = 1;
+        }
 
-        if (metric_)
+        else
         {
-            altitudeLR /= METERS_PER_FOOT; /* meters --> feet */
-            max_range_ /= KM_PER_MILE;      /* kilometers --> miles */
-            altitude /= METERS_PER_FOOT;   /* meters --> feet */
-            clutter_ /= METERS_PER_FOOT;    /* meters --> feet */
+            fprintf(stderr, "\n%c*** ERROR: No receiver site found or specified!\n\n", 7);
+            exit(-1);
         }
+    }
 
-        /* If no SDF path was specified on the command line (-d), check
-           for a path specified in the $HOME/.splat_path file.  If the
-           file is not found, then sdf_path[] remains NULL, and the
-           current working directory is assumed to contain the SDF
-           files. */
-
-        if (sdf_path_[0] == 0)
-        {
-            env = getenv("HOME");
-            snprintf(string_, 253, "%s/.splat_path", env);
-            fd = fopen(string_, "r");
+    /* No major errors were detected.  Whew!  :-) */
 
-            if (fd != NULL)
-            {
-                fgets(string, 253, fd);
+    /* Adjust input parameters if -metric option is used */
 
-                /* Remove <CR> and/or <LF> from string */
+    if (metric_)
+    {
+        job.altitudeLR /= METERS_PER_FOOT; /* meters --> feet */
+        max_range_ /= KM_PER_MILE;      /* kilometers --> miles */
+        job.altitude /= METERS_PER_FOOT;   /* meters --> feet */
+        clutter_ /= METERS_PER_FOOT;    /* meters --> feet */
+    }
 
-                for (x = 0; string[x] != 13 && string[x] != 10 && string[x] != 0 && x < 253; x++)
-                    ;
-                string[x] = 0;
+    /* If no SDF path was specified on the command line (-d), check
+       for a path specified in the $HOME/.splat_path file.  If the
+       file is not found, then sdf_path[] remains NULL, and the
+       current working directory is assumed to contain the SDF
+       files. */
 
-                strncpy(sdf_path_, string_, 253);
+    if (sdf_path_[0] == 0)
+        strncpy(sdf_path_, DefaultSDFPath(), 253);
 
-                fclose(fd);
-            }
-        }
+    /* Ensure a trailing '/' is present in sdf_path */
 
-        /* Ensure a trailing '/' is present in sdf_path */
+    if (sdf_path_[0])
+    {
+        x = strlen(sdf_path_);
 
-        if (sdf_path_[0])
+        if (sdf_path_[x - 1] != '/' && x != 0)
         {
-            x = strlen(sdf_path_);
-
-            if (sdf_path_[x - 1] != '/' && x != 0)
-            {
-                sdf_path_[x] = '/';
-                sdf_path_[x + 1] = 0;
-            }
+            sdf_path_[x] = '/';
+            sdf_path_[x + 1] = 0;
         }
+    }
 
-        fprintf(stdout, "%s", header);
-        fflush(stdout);
+    fprintf(stdout, "%s", header);
+    fflush(stdout);
 
-        if (ani_filename[0])
-        {
-            ReadLRParm(tx_site[0], 0); /* Get ERP status */
-            y = LoadANO(ani_filename);
+    if (job.ani_filename[0])
+    {
+        ReadLRParm(job.tx_site[0], 0); /* Get ERP status */
+        y = LoadANO(job.ani_filename);
 
-            for (x = 0; x < txsites && x < max_txsites; x++)
-                PlaceMarker(tx_site[x]);
+        for (x = 0; x < job.txsites && x < job.max_txsites; x++)
+            PlaceMarker(job.tx_site[x]);
 
-            if (rxsite)
-                PlaceMarker(rx_site);
+        if (job.rxsite)
+            PlaceMarker(job.rx_site);
 
-            if (bfs)
-            {
-                for (x = 0; x < bfs; x++)
-                    LoadBoundaries(boundary_file[x]);
+        if (job.bfs)
+        {
+            for (x = 0; x < job.bfs; x++)
+                LoadBoundaries(job.boundary_file[x]);
 
-                fprintf(stdout, "\n");
-                fflush(stdout);
-            }
+            fprintf(stdout, "\n");
+            fflush(stdout);
+        }
 
-            if (cities)
-            {
-                for (x = 0; x < cities; x++)
-                    LoadCities(city_file[x]);
+        if (job.cities)
+        {
+            for (x = 0; x < job.cities; x++)
+                LoadCities(job.city_file[x]);
 
-                fprintf(stdout, "\n");
-                fflush(stdout);
-            }
-            if (LR_.erp == 0.0)
+            fprintf(stdout, "\n");
+            fflush(stdout);
+        }
+        if (LR_.erp == 0.0)
+        {
+            WritePPMDBM(mapfile, job.ngs, job.tx_site, job.txsites);
+            //WritePPMLR(mapfile, geo, kml, ngs, tx_site, txsites);
+        }
+        else
+        {
+            if (dbm_)
             {
-                WritePPMDBM(mapfile, ngs, tx_site, txsites);
-                //WritePPMLR(mapfile, geo, kml, ngs, tx_site, txsites);
+                WritePPMDBM(mapfile, job.ngs, job.tx_site, job.txsites);
             }
             else
             {
-                if (dbm_)
-                {
-                    WritePPMDBM(mapfile, ngs, tx_site, txsites);
-                }
-                else
-                {
-                    WritePPMSS(mapfile, geo, kml, ngs, tx_site, txsites);
-                }
+                WritePPMSS(mapfile, job.geo, job.kml, job.ngs, job.tx_site, job.txsites);
             }
-
-            exit(0);
         }
 
-        x = 0;
-        y = 0;
-
-        min_lat = 90;
-        max_lat = -90;
+        exit(0);
+    }
 
-        min_lon = (int)floor(tx_site[0].lon);
-        max_lon = (int)floor(tx_site[0].lon);
+    x = 0;
+    y = 0;
 
-        for (y = 0, z = 0; z < txsites && z < max_txsites; z++)
-        {
-            txlat = (int)floor(tx_site[z].lat);
-            txlon = (int)floor(tx_site[z].lon);
+    min_lat = 90;
+    max_lat = -90;
 
-            if (txlat < min_lat)
-                min_lat = txlat;
+    min_lon = (int)floor(job.tx_site[0].lon);
+    max_lon = (int)floor(job.tx_site[0].lon);
 
-            if (txlat > max_lat)
-                max_lat = txlat;
+    for (y = 0, z = 0; z < job.txsites && z < job.max_txsites; z++)
+    {
+        txlat = (int)floor(job.tx_site[z].lat);
+        txlon = (int)floor(job.tx_site[z].lon);
 
-            if (LonDiff(txlon, min_lon) < 0.0)
-                min_lon = txlon;
+        if (txlat < min_lat)
+            min_lat = txlat;
 
-            if (LonDiff(txlon, max_lon) >= 0.0)
-                max_lon = txlon;
-        }
+        if (txlat > max_lat)
+            max_lat = txlat;
 
-        if (rxsite)
-        {
-            rxlat = (int)floor(rx_site.lat);
-            rxlon = (int)floor(rx_site.lon);
+        if (LonDiff(txlon, min_lon) < 0.0)
+            min_lon = txlon;
 
-            if (rxlat < min_lat)
-                min_lat = rxlat;
+        if (LonDiff(txlon, max_lon) >= 0.0)
+            max_lon = txlon;
+    }
 
-            if (rxlat > max_lat)
-                max_lat = rxlat;
+    if (job.rxsite)
+    {
+        rxlat = (int)floor(job.rx_site.lat);
+        rxlon = (int)floor(job.rx_site.lon);
 
-            if (LonDiff(rxlon, min_lon) < 0.0)
-                min_lon = rxlon;
+        if (rxlat < min_lat)
+            min_lat = rxlat;
 
-            if (LonDiff(rxlon, max_lon) >= 0.0)
-                max_lon = rxlon;
-        }
+        if (rxlat > max_lat)
+            max_lat = rxlat;
 
-        /* Load the required SDF files */
+        if (LonDiff(rxlon, min_lon) < 0.0)
+            min_lon = rxlon;
 
-        LoadTopoData(max_lon, min_lon, max_lat, min_lat);
+        if (LonDiff(rxlon, max_lon) >= 0.0)
+            max_lon = rxlon;
+    }
 
-        if (area_mode || topomap)
-        {
-            for (z = 0; z < txsites && z < max_txsites; z++)
-            {
-                /* "Ball park" estimates used to load any additional
-                   SDF files required to conduct this analysis. */
+    /* Load the required SDF files */
 
-                tx_range = sqrt(1.5 * (tx_site[z].alt + GetElevation(tx_site[z])));
+    LoadTopoData(max_lon, min_lon, max_lat, min_lat);
 
-                if (LRmap)
-                    rx_range = sqrt(1.5 * altitudeLR);
-                else
-                    rx_range = sqrt(1.5 * altitude);
+    if (job.area_mode || topomap)
+    {
+        for (z = 0; z < job.txsites && z < job.max_txsites; z++)
+        {
+            /* "Ball park" estimates used to load any additional
+               SDF files required to conduct this analysis. */
 
-                /* deg_range determines the maximum
-                   amount of topo data we read */
+            tx_range = sqrt(1.5 * (job.tx_site[z].alt + GetElevation(job.tx_site[z])));
 
-                deg_range = (tx_range + rx_range) / 57.0;
+            if (job.LRmap)
+                rx_range = sqrt(1.5 * job.altitudeLR);
+            else
+                rx_range = sqrt(1.5 * job.altitude);
 
-                /* max_range_ regulates the size of the
-                   analysis.  A small, non-zero amount can
-                   be used to shrink the size of the analysis
-                   and limit the amount of topo data read by
-                   SPLAT!  A large number will increase the
-                   width of the analysis and the size of
-                   the map. */
+            /* deg_range determines the maximum
+               amount of topo data we read */
 
-                if (max_range_ == 0.0)
-                    max_range_ = tx_range + rx_range;
+            deg_range = (tx_range + rx_range) / 57.0;
 
-                deg_range = max_range_ / 57.0;
+            /* max_range_ regulates the size of the
+               analysis.  A small, non-zero amount can
+               be used to shrink the size of the analysis
+               and limit the amount of topo data read by
+               SPLAT!  A large number will increase the
+               width of the analysis and the size of
+               the map. */
 
-                /* Prevent the demand for a really wide coverage
-                   from allocating more "pages" than are available
-                   in memory. */
+            if (max_range_ == 0.0)
+                max_range_ = tx_range + rx_range;
 
-                switch (MAXPAGES)
-                {
-                case 1:
-                    deg_limit = 0.125;
-                    break;
+            deg_range = max_range_ / 57.0;
 
-                case 2:
-                    deg_limit = 0.25;
-                    break;
+            /* Prevent the demand for a really wide coverage
+               from allocating more "pages" than are available
+               in memory. */
 
-                case 4:
-                    deg_limit = 0.5;
-                    break;
+            deg_limit = DegreeLimit();
 
-                case 9:
-                    deg_limit = 1.0;
-                    break;
+            if (fabs(job.tx_site[z].lat) < 70.0)
+                deg_range_lon = deg_range / cos(DEG2RAD * job.tx_site[z].lat);
+            else
+                deg_range_lon = deg_range / cos(DEG2RAD * 70.0);
 
-                case 16:
-                    deg_limit = 1.5; /* WAS 2.0 */
-                    break;
+            /* Correct for squares in degrees not being square in miles */
 
-                case 25:
-                    deg_limit = 2.0; /* WAS 3.0 */
-                    break;
+            if (deg_range > deg_limit)
+                deg_range = deg_limit;
 
-                case 36:
-                    deg_limit = 2.5; /* New! */
-                    break;
+            if (deg_range_lon > deg_limit)
+                deg_range_lon = deg_limit;
 
-                case 49:
-                    deg_limit = 3.0; /* New! */
-                    break;
+            north_min = (int)floor(job.tx_site[z].lat - deg_range);
+            north_max = (int)floor(job.tx_site[z].lat + deg_range);
 
-                case 64:
-                    deg_limit = 3.5; /* New! */
-                    break;
-                }
+            west_min = (int)floor(job.tx_site[z].lon - deg_range_lon);
 
-                if (fabs(tx_site[z].lat) < 70.0)
-                    deg_range_lon = deg_range / cos(DEG2RAD * tx_site[z].lat);
-                else
-                    deg_range_lon = deg_range / cos(DEG2RAD * 70.0);
+            while (west_min < 0)
+                west_min += 360;
 
-                /* Correct for squares in degrees not being square in miles */
+            while (west_min >= 360)
+                west_min -= 360;
 
-                if (deg_range > deg_limit)
-                    deg_range = deg_limit;
+            west_max = (int)floor(job.tx_site[z].lon + deg_range_lon);
 
-                if (deg_range_lon > deg_limit)
-                    deg_range_lon = deg_limit;
+            while (west_max < 0)
+                west_max += 360;
 
-                north_min = (int)floor(tx_site[z].lat - deg_range);
-                north_max = (int)floor(tx_site[z].lat + deg_range);
+            while (west_max >= 360)
+                west_max -= 360;
 
-                west_min = (int)floor(tx_site[z].lon - deg_range_lon);
+            if (north_min < min_lat)
+                min_lat = north_min;
 
-                while (west_min < 0)
-                    west_min += 360;
+            if (north_max > max_lat)
+                max_lat = north_max;
 
-                while (west_min >= 360)
-                    west_min -= 360;
+            /* A sector (-LA) sweep only needs the tiles its
+               wedge passes over, not the whole square. */
 
-                west_max = (int)floor(tx_site[z].lon + deg_range_lon);
+            if (job.LRmap && specified_angle_mode_ && !job.coverage)
+            {
+                LoadSectorTopoData(job.tx_site[z], start_angle_, end_angle_, west_max, west_min,
+                                   north_max, north_min);
+                continue;
+            }
 
-                while (west_max < 0)
-                    west_max += 360;
+            if (LonDiff(west_min, min_lon) < 0.0)
+                min_lon = west_min;
 
-                while (west_max >= 360)
-                    west_max -= 360;
+            if (LonDiff(west_max, max_lon) >= 0.0)
+                max_lon = west_max;
+        }
 
-                if (north_min < min_lat)
-                    min_lat = north_min;
+        /* Load any additional SDF files, if required */
 
-                if (north_max > max_lat)
-                    max_lat = north_max;
+        if (!(job.LRmap && specified_angle_mode_ && !job.coverage))
+            LoadTopoData(max_lon, min_lon, max_lat, min_lat);
+    }
 
-                if (LonDiff(west_min, min_lon) < 0.0)
-                    min_lon = west_min;
+    if (job.udt_file[0])
+        LoadUDT(job.udt_file);
 
-                if (LonDiff(west_max, max_lon) >= 0.0)
-                    max_lon = west_max;
-            }
+    CheckCancelled();
 
-            /* Load any additional SDF files, if required */
+    /***** Let the SPLATting begin! *****/
 
-            LoadTopoData(max_lon, min_lon, max_lat, min_lat);
-        }
+    if (job.pt2pt_mode)
+    {
+        PlaceMarker(job.rx_site);
 
-        if (udt_file[0])
-            LoadUDT(udt_file);
+        if (job.terrain_plot)
+        {
+            /* Extract extension (if present)
+               from "terrain_file" */
 
-        /***** Let the SPLATting begin! *****/
+            y = strlen(job.terrain_file);
 
-        if (pt2pt_mode)
-        {
-            PlaceMarker(rx_site);
+            for (x = y - 1; x > 0 && job.terrain_file[x] != '.'; x--)
+                ;
 
-            if (terrain_plot)
+            if (x > 0) /* Extension found */
             {
-                /* Extract extension (if present)
-                   from "terrain_file" */
+                for (z = x + 1; z <= y && (z - (x + 1)) < 10; z++)
+                    ext[z - (x + 1)] = tolower(job.terrain_file[z]);
 
-                y = strlen(terrain_file);
+                ext[z - (x + 1)] = 0; /* Ensure an ending 0 */
+                job.terrain_file[x] = 0;  /* Chop off extension */
+            }
 
-                for (x = y - 1; x > 0 && terrain_file[x] != '.'; x--)
-                    ;
+            else
+                strncpy(ext, "png\0", 4);
+        }
 
-                if (x > 0) /* Extension found */
-                {
-                    for (z = x + 1; z <= y && (z - (x + 1)) < 10; z++)
-                        ext[z - (x + 1)] = tolower(terrain_file[z]);
+        if (job.elevation_plot)
+        {
+            /* Extract extension (if present)
+               from "elevation_file" */
 
-                    ext[z - (x + 1)] = 0; /* Ensure an ending 0 */
-                    terrain_file[x] = 0;  /* Chop off extension */
-                }
+            y = strlen(job.elevation_file);
 
-                else
-                    strncpy(ext, "png\0", 4);
-            }
+            for (x = y - 1; x > 0 && job.elevation_file[x] != '.'; x--)
+                ;
 
-            if (elevation_plot)
+            if (x > 0) /* Extension found */
             {
-                /* Extract extension (if present)
-                   from "elevation_file" */
+                for (z = x + 1; z <= y && (z - (x + 1)) < 10; z++)
+                    ext[z - (x + 1)] = tolower(job.elevation_file[z]);
 
-                y = strlen(elevation_file);
+                ext[z - (x + 1)] = 0;  /* Ensure an ending 0 */
+                job.elevation_file[x] = 0; /* Chop off extension */
+            }
 
-                for (x = y - 1; x > 0 && elevation_file[x] != '.'; x--)
-                    ;
+            else
+                strncpy(ext, "png\0", 4);
+        }
 
-                if (x > 0) /* Extension found */
-                {
-                    for (z = x + 1; z <= y && (z - (x + 1)) < 10; z++)
-                        ext[z - (x + 1)] = tolower(elevation_file[z]);
+        if (job.height_plot)
+        {
+            /* Extract extension (if present)
+               from "height_file" */
 
-                    ext[z - (x + 1)] = 0;  /* Ensure an ending 0 */
-                    elevation_file[x] = 0; /* Chop off extension */
-                }
+            y = strlen(job.height_file);
 
-                else
-                    strncpy(ext, "png\0", 4);
-            }
+            for (x = y - 1; x > 0 && job.height_file[x] != '.'; x--)
+                ;
 
-            if (height_plot)
+            if (x > 0) /* Extension found */
             {
-                /* Extract extension (if present)
-                   from "height_file" */
+                for (z = x + 1; z <= y && (z - (x + 1)) < 10; z++)
+                    ext[z - (x + 1)] = tolower(job.height_file[z]);
 
-                y = strlen(height_file);
+                ext[z - (x + 1)] = 0; /* Ensure an ending 0 */
+                job.height_file[x] = 0;   /* Chop off extension */
+            }
 
-                for (x = y - 1; x > 0 && height_file[x] != '.'; x--)
-                    ;
+            else
+                strncpy(ext, "png\0", 4);
+        }
 
-                if (x > 0) /* Extension found */
-                {
-                    for (z = x + 1; z <= y && (z - (x + 1)) < 10; z++)
-                        ext[z - (x + 1)] = tolower(height_file[z]);
+        if (job.longley_plot)
+        {
+            /* Extract extension (if present)
+               from "longley_file" */
 
-                    ext[z - (x + 1)] = 0; /* Ensure an ending 0 */
-                    height_file[x] = 0;   /* Chop off extension */
-                }
+            y = strlen(job.longley_file);
 
-                else
-                    strncpy(ext, "png\0", 4);
-            }
+            for (x = y - 1; x > 0 && job.longley_file[x] != '.'; x--)
+                ;
 
-            if (longley_plot)
+            if (x > 0) /* Extension found */
             {
-                /* Extract extension (if present)
-                   from "longley_file" */
-
-                y = strlen(longley_file);
+                for (z = x + 1; z <= y && (z - (x + 1)) < 10; z++)
+                    ext[z - (x + 1)] = tolower(job.longley_file[z]);
 
-                for (x = y - 1; x > 0 && longley_file[x] != '.'; x--)
-                    ;
-
-                if (x > 0) /* Extension found */
-                {
-                    for (z = x + 1; z <= y && (z - (x + 1)) < 10; z++)
-                        ext[z - (x + 1)] = tolower(longley_file[z]);
+                ext[z - (x + 1)] = 0; /* Ensure an ending 0 */
+                job.longley_file[x] = 0;  /* Chop off extension */
+            }
 
-                    ext[z - (x + 1)] = 0; /* Ensure an ending 0 */
-                    longley_file[x] = 0;  /* Chop off extension */
-                }
+            else
+                strncpy(ext, "png\0", 4);
+        }
 
-                else
-                    strncpy(ext, "png\0", 4);
-            }
+        for (x = 0; x < job.txsites && x < 4; x++)
+        {
+            PlaceMarker(job.tx_site[x]);
 
-            for (x = 0; x < txsites && x < 4; x++)
+            if (job.nolospath == 0)
             {
-                PlaceMarker(tx_site[x]);
-
-                if (nolospath == 0)
+                switch (x)
                 {
-                    switch (x)
-                    {
-                    case 0:
-                        PlotPath(tx_site[x], rx_site, 1);
-                        break;
+                case 0:
+                    PlotPath(*ctx_, job.tx_site[x], job.rx_site, 1);
+                    break;
 
-                    case 1:
-                        PlotPath(tx_site[x], rx_site, 8);
-                        break;
+                case 1:
+                    PlotPath(*ctx_, job.tx_site[x], job.rx_site, 8);
+                    break;
 
-                    case 2:
-                        PlotPath(tx_site[x], rx_site, 16);
-                        break;
+                case 2:
+                    PlotPath(*ctx_, job.tx_site[x], job.rx_site, 16);
+                    break;
 
-                    case 3:
-                        PlotPath(tx_site[x], rx_site, 32);
-                    }
+                case 3:
+                    PlotPath(*ctx_, job.tx_site[x], job.rx_site, 32);
                 }
+            }
 
-                if (nositereports == 0)
-                    SiteReport(mapfile, tx_site[x]);
+            if (job.nositereports == 0)
+                SiteReport(mapfile, job.tx_site[x]);
 
-                if (kml)
-                    WriteKML(tx_site[x], rx_site);
+            if (job.kml)
+                WriteKML(job.tx_site[x], job.rx_site);
 
-                if (txsites > 1)
-                    snprintf(string, 250, "%s-%c.%s%c", longley_file, '1' + x, ext, 0);
-                else
-                    snprintf(string, 250, "%s.%s%c", longley_file, ext, 0);
+            if (job.txsites > 1)
+                snprintf(string, 250, "%s-%c.%s%c", job.longley_file, '1' + x, ext, 0);
+            else
+                snprintf(string, 250, "%s.%s%c", job.longley_file, ext, 0);
 
-                if (nositereports == 0)
+            if (job.nositereports == 0)
+            {
+                if (job.longley_file[0] == 0)
                 {
-                    if (longley_file[0] == 0)
-                    {
-                        ReadLRParm(tx_site[x], 0);
-                        PathReport(tx_site[x], rx_site, string, 0);
-                    }
-
-                    else
-                    {
-                        ReadLRParm(tx_site[x], 1);
-                        PathReport(tx_site[x], rx_site, string, longley_file[0]);
-                    }
+                    ReadLRParm(job.tx_site[x], 0);
+                    PathReport(job.tx_site[x], job.rx_site, string, 0);
                 }
 
-                if (terrain_plot)
+                else
                 {
-                    if (txsites > 1)
-                        snprintf(string, 250, "%s-%c.%s%c", terrain_file, '1' + x, ext, 0);
-                    else
-                        snprintf(string, 250, "%s.%s%c", terrain_file, ext, 0);
-                    GraphTerrain(tx_site[x], rx_site, string);
+                    ReadLRParm(job.tx_site[x], 1);
+                    PathReport(job.tx_site[x], job.rx_site, string, job.longley_file[0]);
                 }
+            }
 
-                if (elevation_plot)
-                {
-                    if (txsites > 1)
-                        snprintf(string, 250, "%s-%c.%s%c", elevation_file, '1' + x, ext, 0);
-                    else
-                        snprintf(string, 250, "%s.%s%c", elevation_file, ext, 0);
-                    GraphElevation(tx_site[x], rx_site, string);
-                }
+            if (job.terrain_plot)
+            {
+                if (job.txsites > 1)
+                    snprintf(string, 250, "%s-%c.%s%c", job.terrain_file, '1' + x, ext, 0);
+                else
+                    snprintf(string, 250, "%s.%s%c", job.terrain_file, ext, 0);
+                GraphTerrain(job.tx_site[x], job.rx_site, string);
+            }
 
-                if (height_plot)
-                {
-                    if (txsites > 1)
-                        snprintf(string, 250, "%s-%c.%s%c", height_file, '1' + x, ext, 0);
-                    else
-                        snprintf(string, 250, "%s.%s%c", height_file, ext, 0);
+            if (job.elevation_plot)
+            {
+                if (job.txsites > 1)
+                    snprintf(string, 250, "%s-%c.%s%c", job.elevation_file, '1' + x, ext, 0);
+                else
+                    snprintf(string, 250, "%s.%s%c", job.elevation_file, ext, 0);
+                GraphElevation(job.tx_site[x], job.rx_site, string);
+            }
 
-                    GraphHeight(tx_site[x], rx_site, string, fresnel_plot, norm);
-                }
+            if (job.height_plot)
+            {
+                if (job.txsites > 1)
+                    snprintf(string, 250, "%s-%c.%s%c", job.height_file, '1' + x, ext, 0);
+                else
+                    snprintf(string, 250, "%s.%s%c", job.height_file, ext, 0);
+
+                GraphHeight(job.tx_site[x], job.rx_site, string, job.fresnel_plot, job.norm);
             }
         }
+    }
 
-        // THE HEAVY PART OF THE CODE
-        if (area_mode && topomap == 0)
+    // THE HEAVY PART OF THE CODE
+    if (job.area_mode && topomap == 0)
+    {
+        for (x = 0; x < job.txsites && x < job.max_txsites; x++)
         {
-            for (x = 0; x < txsites && x < max_txsites; x++)
+            if (job.coverage)
             {
-                if (coverage)
-                {
-                    PlotLOSMap(tx_site[x], altitude);
-                }
-                else if (!ReadCustomLRParm(tx_site[0], true))
+                PlotLOSMap(*ctx_, job.tx_site[x], job.altitude);
+            }
+            else if (!ReadCustomLRParm(job.tx_site[0], true))
+            {
+                fprintf(stdout, "Using default LRP parameters since no valid LRP file found\n");
+            }
+            //else if (ReadLRParm(tx_site[x], 1))
+            {
+                if (specified_angle_mode_)
                 {
-                    fprintf(stdout, "Using default LRP parameters since no valid LRP file found\n");
+                    // Call the new function for specified angles
+                    PlotLRMapSpecifiedAngles(*ctx_, job.tx_site[x], job.altitudeLR, job.ano_filename, start_angle_,
+                                             end_angle_);
                 }
-                //else if (ReadLRParm(tx_site[x], 1))
+                else
                 {
-                    if (specified_angle_mode_)
-                    {
-                        // Call the new function for specified angles
-                        PlotLRMapSpecifiedAngles(tx_site[x], altitudeLR, ano_filename, start_angle_,
-                                                 end_angle_);
-                    }
-                    else
-                    {
-                        // Call the original function for full coverage
-                        PlotLRMap(tx_site[x], altitudeLR, ano_filename);
-                    }
-                    // don't need to generate site report for each transmitter site
-                    // SiteReport(mapfile, tx_site[x]);
+                    // Call the original function for full coverage
+                    PlotLRMap(*ctx_, job.tx_site[x], job.altitudeLR, job.ano_filename);
                 }
+                // don't need to generate site report for each transmitter site
+                // SiteReport(mapfile, tx_site[x]);
             }
         }
+    }
+
+    CheckCancelled();
+
+    if (map || topomap)
+    {
+        /* Label the map */
 
-        if (map || topomap)
+        if (job.cities)
         {
-            /* Label the map */
+            for (y = 0; y < job.cities; y++)
+                LoadCities(job.city_file[y]);
 
-            if (cities)
-            {
-                for (y = 0; y < cities; y++)
-                    LoadCities(city_file[y]);
+            fprintf(stdout, "\n");
+            fflush(stdout);
+        }
 
-                fprintf(stdout, "\n");
-                fflush(stdout);
-            }
+        /* Load city and county boundary data files */
 
-            /* Load city and county boundary data files */
+        if (job.bfs)
+        {
+            for (y = 0; y < job.bfs; y++)
+                LoadBoundaries(job.boundary_file[y]);
 
-            if (bfs)
-            {
-                for (y = 0; y < bfs; y++)
-                    LoadBoundaries(boundary_file[y]);
+            fprintf(stdout, "\n");
+            fflush(stdout);
+        }
 
-                fprintf(stdout, "\n");
-                fflush(stdout);
-            }
+        /* Plot the map */
+
+        if (job.coverage || job.pt2pt_mode || topomap)
+        {
 
-            /* Plot the map */
+            WritePPM(mapfile, job.geo, job.kml, job.ngs, job.tx_site, job.txsites);
+        }
 
-            if (coverage || pt2pt_mode || topomap)
-            {
+        else
+        {
 
-                WritePPM(mapfile, geo, kml, ngs, tx_site, txsites);
+            if (LR_.erp == 0.0)
+            {
+                WritePPMLR(mapfile, job.geo, job.kml, job.ngs, job.tx_site, job.txsites);
             }
+            else if (dbm_)
+            {
 
+                WritePPMDBM(mapfile, job.ngs, job.tx_site, job.txsites);
+            }
             else
             {
 
-                if (LR_.erp == 0.0)
-                {
-                    WritePPMLR(mapfile, geo, kml, ngs, tx_site, txsites);
-                }
-                else if (dbm_)
-                {
-
-                    WritePPMDBM(mapfile, ngs, tx_site, txsites);
-                }
-                else
-                {
-
-                    WritePPMSS(mapfile, geo, kml, ngs, tx_site, txsites);
-                }
+                WritePPMSS(mapfile, job.geo, job.kml, job.ngs, job.tx_site, job.txsites);
             }
         }
+    }
 
-        if (command_line_log && strlen(logfile) > 0)
-        {
-            fd = fopen(logfile, "w");
-
-            if (fd != NULL)
-            {
-                for (x = 0; x < argc; x++)
-                    fprintf(fd, "%s ", argv[x]);
+    if (job.command_line_log && strlen(job.logfile) > 0)
+    {
+        fd = fopen(job.logfile, "w");
 
-                fprintf(fd, "\n");
+        if (fd != NULL)
+        {
+            fprintf(fd, "%s\n", job.command_line.c_str());
 
-                fclose(fd);
+            fclose(fd);
 
-                fprintf(stdout, "\nCommand-line parameter log written to: \"%s\"\n", logfile);
-            }
+            fprintf(stdout, "\nCommand-line parameter log written to: \"%s\"\n", job.logfile);
         }
-
-        printf("\n");
     }
 
+    printf("\n");
+
     /* That's all, folks! */
-//}
+}
 
 void SplatProcessor::process() {
     int y;
-    char header[80];
     strncpy(splat_version_, "2.0.0\0", 6);
 
-    if (HD_MODE == 1)
+    if (hd_mode_ == 1)
         strncpy(splat_name_, "SPLAT! HD\0", 10);
     else
         strncpy(splat_name_, "SPLAT!\0", 7);
@@ -8450,16 +9656,24 @@ void SplatProcessor::process() {
         printHelp(splat_name_, splat_version_, y);
     }
 
-    y = argv_.size() - 1;
+    if (!argv_.empty()) {
+        std::unique_ptr<Job> job(new Job);
 
-    // Prepare header for welcome message
-    prepareHeader(splat_name_, splat_version_, header);
-    parseArguments(argv_.size(), argv_.data(), header, y);
-    argv_.clear();
+        ParseJob(argv_.size(), argv_.data(), *job);
+        argv_.clear();
+        RunJob(*job);
+    } else if (job_) {
+        std::unique_ptr<Job> job = std::move(job_);
+
+        RunJob(*job);
+    }
+}
+
+void SplatProcessor::setJob(const Job &job) {
+    job_.reset(new Job(job));
 }
 
 void SplatProcessor::resetSplat() {
-    opened_ = 0,
     gpsav_ = 0,
     max_range_ = 0.0,
     forced_erp_ = -1.0,
@@ -8478,33 +9692,40 @@ void SplatProcessor::resetSplat() {
     specified_angle_mode_ = 0,
     transparent_mode_ = 0,
     generatedImageInfo_ = SMSplatGenInfo();
+
+    /* Terrain is reloaded by the next job; give the memory back */
+
+    ReleasePages();
     }
 
 void SplatProcessor::setParameters(const SMSplatInputInfo &params) {
-    // Stringify parameters
-    argv_.push_back("splat");
+    // Validate the parameters, then describe the job they ask for:
+    // a -L (or, for a sector, -LA) dBm map of one transmitter, as
+    // "-t name lat lon alt -f freq -L height -dbm -olditm -sc -trans
+    // -metric -R radius -fz fresnel -d elevation_path" would.
+    std::unique_ptr<Job> job(new Job);
 
-    //  ====== Validate parameters ======
     // Transmitter site Check
-    argv_.push_back("-t");
-    if (params.transmitter_name != nullptr && strlen(params.transmitter_name) > 0) {
-        argv_.push_back((char *)params.transmitter_name);
-    } else {
+    if (params.transmitter_name == nullptr || strlen(params.transmitter_name) == 0) {
         throw std::invalid_argument("Transmitter name must not be empty");
     }
     if (params.transmitter_lat < -90.0 || params.transmitter_lat > 90.0) {
         throw std::invalid_argument("Transmitter latitude must be between -90° (South Pole) and +90° (North Pole)");
     }
-    argv_.push_back(strdup(std::to_string(params.transmitter_lat).c_str()));
     if (params.transmitter_lon < -180.0 || params.transmitter_lon > 180.0) {
         throw std::invalid_argument("Transmitter longitude must be between -180° (West) and +180° (East)");
     }
-    argv_.push_back(strdup(std::to_string(params.transmitter_lon).c_str())); 
     if (params.transmitter_alt < 0) {
         throw std::invalid_argument("Transmitter altitude must be non-negative");
     }
-    argv_.push_back(strdup(std::to_string(params.transmitter_alt).c_str()));
 
+    // Coverage type Check: the types the application offers
+    static const char *coverage_types[] = {"full", "partial", "segment", "default"};
+    if (params.itm_cov_type == nullptr ||
+        std::none_of(std::begin(coverage_types), std::end(coverage_types),
+                     [&](const char *type) { return strcmp(params.itm_cov_type, type) == 0; })) {
+        throw std::invalid_argument("Invalid ITM coverage type");
+    }
 
     // Angle range Check
     if (params.start_angle < 0 || params.start_angle > 360 || params.end_angle < 0 ||
@@ -8513,73 +9734,61 @@ void SplatProcessor::setParameters(const SMSplatInputInfo &params) {
     }
 
     // Frequency Check
-    if (params.frequency >= 20.0 && params.frequency <= 20000.0) {
-        argv_.push_back("-f");
-        std::string frequencyStr = std::to_string(params.frequency);
-        argv_.push_back(strdup(frequencyStr.c_str()));
-    } else {
+    if (params.frequency < 20.0 || params.frequency > 20000.0) {
         throw std::invalid_argument("Frequency must be between 20 MHz and 20 GHz");
     }
 
     // Receiver height Check
-
     if (params.receiver_height < 0) {
         throw std::invalid_argument("Receiver height must be non-negative");
     }
 
-
-    if (params.start_angle == 0.0 && params.end_angle == 360.0) {
-        argv_.push_back("-L");
-        std::string receiverHeightStr = std::to_string(params.receiver_height);
-        argv_.push_back(strdup(receiverHeightStr.c_str()));
-    } else if (params.start_angle > 0.0 || params.end_angle < 360.0) {
-        argv_.push_back("-LA");
-        std::string receiverHeightStr = std::to_string(params.receiver_height);
-        argv_.push_back(strdup(receiverHeightStr.c_str()));
-
-        std::string startAngleStr = std::to_string(params.start_angle);
-        argv_.push_back(strdup(startAngleStr.c_str()));
-
-        std::string endAngleStr = std::to_string(params.end_angle);
-        argv_.push_back(strdup(endAngleStr.c_str()));
-    }
-
-    // Add other flags based on booleans (dbm, olditm, sc, ngs)
-    argv_.push_back("-dbm");
-    argv_.push_back("-olditm");
-    argv_.push_back("-sc");
-    argv_.push_back("-ngs");
-    argv_.push_back("-metric");
-
-    // Add radius, frequency, and fresnel_zone if provided
-    if (params.radius >= 0.0 && params.radius <= 1000.0) {
-        argv_.push_back("-R");
-        std::string radiusStr = std::to_string(params.radius);
-        argv_.push_back(strdup(radiusStr.c_str()));
-    } else {
+    if (params.radius < 0.0 || params.radius > 1000.0) {
         throw std::invalid_argument("Radius must be between 0.0 and 1000.0");
     }
 
-
-    if (params.fresnel_zone >= 0.0 && params.fresnel_zone <= 100.0) {
-        argv_.push_back("-fz");
-        std::string fresnelZoneStr = std::to_string(params.fresnel_zone);
-        argv_.push_back(strdup(fresnelZoneStr.c_str()));
-    } else {
+    if (params.fresnel_zone < 0.0 || params.fresnel_zone > 100.0) {
         throw std::invalid_argument("Fresnel zone must be between 0.0 and 100.0");
     }
 
     // Elevation path Check
     if (!std::filesystem::exists(elevFilePath_)) {
         throw std::invalid_argument("Elevation path does not exist");
-    } else {
-        argv_.push_back("-d");
-        argv_.push_back(strdup(elevFilePath_.c_str()));
     }
 
-    // Log the final argv for debugging
-    for (int i = 0; i < argv_.size(); ++i) {
-        std::cout << "argv[" << i << "] = " << argv_[i] << std::endl;
-    }
+    // Transmitter: longitude in degrees west, altitude meters --> feet
+    struct site &tx = job->tx_site[0];
+    strncpy(tx.name, params.transmitter_name, 49);
+    tx.name[49] = 0;
+    snprintf(tx.filename, 254, "%s.qth", tx.name);
+    tx.lat = params.transmitter_lat;
+    tx.lon = -params.transmitter_lon;
+    if (tx.lon < 0.0) tx.lon += 360.0;
+    tx.alt = params.transmitter_alt * 3.28084;
+    job->txsites = 1;
+
+    job->forced_freq = params.frequency;
+    job->altitudeLR = params.receiver_height;
+    job->LRmap = 1;
+    job->area_mode = 1;
+
+    if (params.start_angle > 0.0 || params.end_angle < 360.0) {
+        job->start_angle = params.start_angle;
+        job->end_angle = params.end_angle;
+        job->specified_angle_mode = 1;
+    }
+
+    job->dbm = 1;
+    job->olditm = 1;
+    job->smooth_contours = 1;
+    job->transparent = 1;
+    job->metric = 1;
+    job->max_range = params.radius;
+    job->fzone_clearance = params.fresnel_zone / 100.0;
+    strncpy(job->sdf_path, elevFilePath_.c_str(), 253);
+
+    job_ = std::move(job);
+    argv_.clear();
+
     updateCoverageInfo(params.transmitter_name, params.transmitter_lat, params.transmitter_lon, params.radius);
 }
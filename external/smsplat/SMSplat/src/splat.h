@@ -14,89 +14,136 @@
 #include <fstream>
 #include <iomanip>  // For formatting output
 #include <memory>
+#include <atomic>
+#include <stdexcept>
 #include <cstring>  // For strcmp
+#include <set>
 #include <vector>
 #include "../include/splat_config.h"
 #include <filesystem>
 #include "sm_splat_info.h"
+#include "terrain_cache.h"
+#include "antenna_pattern.h"
+#include "coverage_raster.h"
+#include "map_palette.h"
+#include "raster_stream.h"
 /*
-  Parameters for 3 arc-second standard resolution mode of operation
-  Generated by ./configure by levonyeghiazaryan on Mon Jan 20 01:02:33 PM +04 2025
+  HD_MODE and MAXPAGES (see splat_config.h) only select the default
+  resolution and page pool size.  Both can be changed at run time
+  with setHDMode()/-hd and setMaxPages()/-maxpages, and DEM pages
+  are allocated on the heap as tiles are loaded.
 */
-// #define HD_MODE 0
-// #define MAXPAGES 4
 
-#if HD_MODE == 0
-#if MAXPAGES == 4
-#define ARRAYSIZE 4950
-#endif
+struct itm_session_type;  // Per-job ITM constants (itwom3.0.hpp)
+class WorkerPool;         // Threads running ParallelFor() bodies (splat.cpp)
 
-#if MAXPAGES == 9
-#define ARRAYSIZE 10870
-#endif
+class SplatCancelled : public std::runtime_error {
+    /* Thrown by SplatProcessor::process() when the job is
+       cancelled through the flag given to setCancelFlag(). */
 
-#if MAXPAGES == 16
-#define ARRAYSIZE 19240
-#endif
-
-#if MAXPAGES == 25
-#define ARRAYSIZE 30025
-#endif
-
-#if MAXPAGES == 36
-#define ARRAYSIZE 43217
-#endif
-
-#if MAXPAGES == 49
-#define ARRAYSIZE 58813
-#endif
-
-#if MAXPAGES == 64
-#define ARRAYSIZE 76810
-#endif
-
-#define IPPD 1200
-#endif
-
-#if HD_MODE == 1
-#if MAXPAGES == 1
-#define ARRAYSIZE 5092
-#endif
-
-#if MAXPAGES == 4
-#define ARRAYSIZE 14844
-#endif
-
-#if MAXPAGES == 9
-#define ARRAYSIZE 32600
-#endif
-
-#if MAXPAGES == 16
-#define ARRAYSIZE 57713
-#endif
-
-#if MAXPAGES == 25
-#define ARRAYSIZE 90072
-#endif
+   public:
+    SplatCancelled() : std::runtime_error("SPLAT! job cancelled") {}
+};
 
-#if MAXPAGES == 36
-#define ARRAYSIZE 129650
-#endif
+class SplatProcessor {
+   public:
+    struct site {
+        double lat;
+        double lon;
+        float alt;
+        char name[50];
+        char filename[255];
+    };
 
-#if MAXPAGES == 49
-#define ARRAYSIZE 176437
-#endif
+    struct path {
+        std::vector<double> lat;
+        std::vector<double> lon;
+        std::vector<double> elevation;
+        std::vector<double> distance;
+        int length = 0;
+
+        void grow(int samples) {
+            /* Makes room for at least this many samples */
+
+            if ((int)lat.size() >= samples) return;
+
+            lat.resize(samples);
+            lon.resize(samples);
+            elevation.resize(samples);
+            distance.resize(samples);
+        }
+    };
 
-#if MAXPAGES == 64
-#define ARRAYSIZE 230430
-#endif
+    struct PathContext {
+        /* Scratch state for evaluating paths over the terrain held
+           by a SplatProcessor.  Each thread sweeping radials needs
+           its own context; the terrain itself is only read. */
+
+        struct path path;            // Great circle path being evaluated
+        std::vector<double> elev;    // Profile handed to point_to_point()
+        std::vector<double> elev_sum, elev_moment, elev_max;  // Summaries of elev for the models
+        std::vector<int> elev_hull;  // Room for the transmitter horizon of elev's prefixes
+        std::vector<int> horizon;          // Points of path higher than all before them
+        std::vector<double> horizon_cos;   // Cosine of each one's angle from the source
+        int horizon_end = 2;               // First point of path not yet on the horizon
+        char string[255];            // Text returned by dec2dms()
+        unsigned char los_mask_value = 1;  // Mask bit for the next PlotLOSMap() pass
+        unsigned char lr_mask_value = 1;   // Mask tag for the next PlotLRMap() pass
+    };
 
-#define IPPD 3600
-#endif
+    enum LRUnits { LR_LOSS, LR_FIELD, LR_DBM };  // What a -L/-LA map plots
+
+    typedef int (SplatProcessor::*LRKernel)(PathContext &ctx, struct site source,
+                                            struct site destination,
+                                            const std::vector<int> &points, std::string *ano);
+
+    struct Job {
+        /* Everything one run of the engine needs: its sites, the
+           analysis to perform and where to write the results.  The
+           command line (-t, -L, -R, ...) is parsed into one by
+           ParseJob(); setParameters() fills one in directly.  Heights
+           and distances are in feet and miles, or in meters and
+           kilometers when "metric" is set, as on the command line. */
+
+        struct site tx_site[32];     // Transmitters; lat 91, lon 361 if unset (alt in feet)
+        unsigned char txsites = 0;   // Transmitters given
+        unsigned char max_txsites = 30;  // Transmitters analysed
+        struct site rx_site;         // Receiver (-r); lat 91, lon 361 if unset
+        char rxsite = 0;
+
+        unsigned char coverage = 0;  // -c: line-of-sight map at receiver height "altitude"
+        unsigned char LRmap = 0;     // -L/-LA: path loss map at receiver height "altitudeLR"
+        unsigned char area_mode = 0, pt2pt_mode = 0;
+        unsigned char specified_angle_mode = 0;  // -LA: only "start_angle" to "end_angle"
+        double altitude = 0.0, altitudeLR = 0.0;
+        double start_angle = 0.0, end_angle = 360.0;
+
+        double max_range = 0.0;      // -R, 0 = as far as the radio horizon
+        double er_mult = 1.0;        // -m earth radius multiplier
+        double clutter = 0.0;        // -gc ground clutter height
+        double fzone_clearance = 0.6;  // -fz, as a fraction of the first Fresnel zone
+        double forced_freq = 0.0;    // -f (MHz), 0 = from the .lrp file
+        double forced_erp = -1.0;    // -erp (W), -1 = from the .lrp file
+        int contour_threshold = 0;   // -db
+
+        unsigned char olditm = 0, dbm = 0, metric = 0, gpsav = 0, smooth_contours = 0,
+                      transparent = 0, geo = 0, kml = 0, ngs = 0, nolospath = 0,
+                      nositereports = 0, fresnel_plot = 1, norm = 0;
+
+        unsigned char terrain_plot = 0, elevation_plot = 0, height_plot = 0, longley_plot = 0,
+                      cities = 0, bfs = 0, command_line_log = 0;
+        char terrain_file[255] = "", elevation_file[255] = "", height_file[255] = "",
+             longley_file[255] = "", rxfile[255] = "", udt_file[255] = "",
+             ano_filename[255] = "", ani_filename[255] = "", logfile[255] = "",
+             city_file[5][255], boundary_file[5][255];
+        char sdf_path[255] = "";     // -d, "" = as given by $HOME/.splat_path
+        std::string command_line;    // Written to "logfile" by -log
+
+        Job();
+    };
 
-class SplatProcessor {
    private:
-    char string_[255], sdf_path_[255], opened_, gpsav_, splat_name_[20], splat_version_[10], dashes_[100],
+    char sdf_path_[255], gpsav_, splat_name_[20], splat_version_[10], dashes_[100],
         olditm_;
 
     double earthradius_, max_range_, forced_erp_, dpp_, ppd_, fzone_clearance_, forced_freq_, clutter_;
@@ -106,33 +153,29 @@ class SplatProcessor {
 
     unsigned char got_elevation_pattern_, got_azimuth_pattern_, metric_, dbm_, smooth_contours_;
 
-    struct site {
-        double lat;
-        double lon;
-        float alt;
-        char name[50];
-        char filename[255];
-    };
+    template <typename T>
+    struct PageGrid {
+        /* ippd x ippd samples of one DEM page, indexed [x][y] */
 
-    struct path {
-        double lat[ARRAYSIZE];
-        double lon[ARRAYSIZE];
-        double elevation[ARRAYSIZE];
-        double distance[ARRAYSIZE];
-        int length;
-    } path_;
+        std::shared_ptr<T[]> cells;  // Terrain may be shared with the TerrainCache
+        int ippd = 0;
+
+        T *operator[](int x) const { return cells.get() + (size_t)x * ippd; }
+    };
 
     struct dem {
-        int min_north;
-        int max_north;
-        int min_west;
-        int max_west;
-        int max_el;
-        int min_el;
-        short data[IPPD][IPPD];
-        unsigned char mask[IPPD][IPPD];
-        unsigned char signal[IPPD][IPPD];
-    } dem_[MAXPAGES];
+        int min_north = 90;
+        int max_north = -90;  // -90 marks a free page
+        int min_west = 360;
+        int max_west = -1;
+        int max_el = -32768;
+        int min_el = 32768;
+        PageGrid<short> data;  // Never written once shared, see UnshareTerrain()
+    };
+
+    std::vector<struct dem> dem_;  // Page pool, maxpages_ entries
+    CoverageRaster coverage_;      // Mask and signal of each dem_ page for the current job
+    std::vector<int> page_index_;  // dem_ index by (min_north + 90) * 360 + max_west, or -1
 
     struct LR {
         double eps_dielect;
@@ -144,7 +187,7 @@ class SplatProcessor {
         double erp;
         int radio_climate;
         int pol;
-        float antenna_pattern[361][1001];
+        std::shared_ptr<const AntennaPattern> pattern;  // nullptr = radiates equally everywhere
     } LR_;
 
     struct region {
@@ -157,11 +200,29 @@ class SplatProcessor {
     double end_angle_;    // End angle in degrees
     int specified_angle_mode_;
     unsigned char transparent_mode_;
-
-    double elev_[ARRAYSIZE + 10];
+    unsigned int threads_;  // Sweep and map drawing workers, 0 = one per hardware thread
+    std::shared_ptr<WorkerPool> workers_;  // Started by the first ParallelFor(), then kept
+    unsigned char hd_mode_;  // 1 = 1 arc-second (3600 ppd) terrain, 0 = 3 arc-second
+    int maxpages_;           // Number of DEM pages the pool may hold
+    int arraysize_;          // Longest path, in samples, for the current job
+    unsigned char profile_summaries_;  // 1 = path prefixes use the radial's profile summaries
+    int prune_margin_;       // dB beyond the faintest plotted level at which radials stop, -1 = off
+    double prune_window_;    // Distance (user units) a radial must stay that faint to stop
+    unsigned char prune_active_;  // 1 = the current sweep stops faint radials early
+    double prune_floor_;     // Weakest result worth evaluating in the current sweep
+    double prune_span_;      // prune_window_ in miles
+    unsigned long pruned_points_;  // Path loss evaluations skipped by pruning this job
+    double adaptive_spacing_;  // Widest gap (pixels) between -L/-LA radials at max_range_, 0 = edge radials
+    std::shared_ptr<itm_session_type> itm_session_;  // ITM constants of the current sweep
+    std::unique_ptr<PathContext> ctx_;  // Context used by the single-threaded API
+    std::unique_ptr<Job> job_;  // Job for the next process(), if not given by argv_
+    SMSplatProgress progress_;  // Told how far the current job has got, if set
+    const std::atomic<bool> *cancel_;  // Stops the current job once true, if set
+    int sweep_quarter_;         // Quarters of the current -L/-LA sweep done
 
     SMSplatGenInfo generatedImageInfo_;
     cv::Mat image_;
+    RasterStream::Sink raster_sink_;  // Receives map blocks instead of image_, if set
     std::string homeDir_;
     std::string mapFilePath_;
     std::string lrpFilePathInput_;
@@ -216,6 +277,11 @@ class SplatProcessor {
        bits in the mask based on the latitude and longitude of the
        area pointed to. */
 
+    int FindPage(double lat, double lon, int &x, int &y);
+    /* This function returns the index of the DEM page holding
+       the given latitude and longitude, and the pixel within it
+       in x and y, or -1 if no page in memory holds the point. */
+
     int OrMask(double lat, double lon, int value);
     /* Lines, text, markings, and coverage areas are stored in a
        mask that is combined with topology data when topographic
@@ -227,6 +293,16 @@ class SplatProcessor {
     /* This function returns the mask bits based on the latitude
        and longitude given. */
 
+    unsigned char *MaskCell(double lat, double lon);
+    /* This function returns a pointer to the mask byte that
+       GetMask(), PutMask() and OrMask() address for the given
+       latitude and longitude, or NULL if it is not in memory. */
+
+    unsigned char *SignalCell(double lat, double lon);
+    /* This function returns a pointer to the signal level that
+       GetSignal() and PutSignal() address for the given latitude
+       and longitude, or NULL if it is not in memory. */
+
     int PutSignal(double lat, double lon, unsigned char signal);
     /* This function writes a signal level (0-255)
        at the specified location for later recall. */
@@ -270,6 +346,10 @@ class SplatProcessor {
        elevation and distance information for points
        along that path in the "path" structure. */
 
+    void ReadPath(struct site source, struct site destination, struct path &out);
+    /* Same as above, but fills the caller's "out" structure
+       so that concurrent radials can each use their own. */
+
     double ElevationAngle2(struct site source, struct site destination, double er);
     /* This function returns the angle of elevation (in degrees)
        of the destination as seen from the source location, UNLESS
@@ -277,6 +357,12 @@ class SplatProcessor {
        elevation angle to the first obstruction is returned instead.
        "er" represents the earth radius. */
 
+    struct site Destination(struct site source, double azimuthx, double distance);
+    /* This function returns the location "distance" miles from
+       the source along the great circle leaving it in the
+       direction of "azimuth" (degrees).  Only the latitude and
+       longitude of the result are filled in. */
+
     double AverageTerrain(struct site source, double azimuthx, double start_distance,
                           double end_distance);
     /* This function returns the average terrain calculated in
@@ -328,6 +414,28 @@ class SplatProcessor {
        and .el) files that correspond in name to previously
        loaded SPLAT! .lrp files.  */
 
+    void UpdateRegionLimits(int indx);
+    /* This function widens the elevation extremes and the
+       quadrangle limits of the whole region in memory to
+       include the page just loaded into dem[indx]. */
+
+    bool FindSDF(char *name, TerrainCache::Source &source);
+    /* This function identifies the file LoadSDF() would read for
+       the tile in "name": the first .bsdf, .sdf or .sdf.bz2 found in
+       the current directory or sdf_path.  Returns false if there
+       is none, leaving the tile at sea level. */
+
+    int LoadSDF_Cache(char *name, const TerrainCache::Source &source);
+    /* This function attaches a tile already read from "source" and
+       held by the process-wide TerrainCache to the first available
+       dem[] structure, sharing its elevation data.  Returns -1 if
+       the tile is not cached. */
+
+    void CacheTile(char *name, const TerrainCache::Source &source);
+    /* This function hands the page just read from "source" for the
+       tile in "name" to the TerrainCache so that later jobs can
+       share it. */
+
     int LoadSDF_SDF(char *name);
     /* This function reads uncompressed SPLAT Data Files (.sdf)
        containing digital elevation model data into memory.
@@ -335,10 +443,26 @@ class SplatProcessor {
        quadrangle limits are stored in the first available
        dem[] structure. */
 
-    char *BZfgets(BZFILE *bzfd, unsigned length);
+    int LoadSDF_BIN(char *name);
+    /* This function maps binary SPLAT Data Files (.bsdf, written
+       by sdf2bsdf) and copies their elevation grid into the first
+       available dem[] structure without any parsing.  Returns 0
+       if the tile is already loaded or no page is free, and -1
+       if no valid .bsdf exists for it. */
+
+    struct BZReader {
+        /* Read state of the .sdf.bz2 file LoadSDF_BZ() is loading */
+
+        BZFILE *bzfd = NULL;
+        int x = 0, y = 0, nbuf = 0;  // Next char of buffer, of output, chars in buffer
+        char opened = 0;             // 0 until the first block is read, and after EOF
+        std::vector<char> buffer, output;  // Uncompressed block, string being returned
+    };
+
+    char *BZfgets(BZReader &bz, unsigned length);
     /* This function returns at most one less than 'length' number
-       of characters from a bz2 compressed file whose file descriptor
-       is pointed to by *bzfd.  In operation, a buffer is filled with
+       of characters from a bz2 compressed file whose read state
+       is held by bz.  In operation, a buffer is filled with
        uncompressed data (size = BZBUFFER), which is then parsed
        and doled out as NULL terminated character strings every time
        this function is invoked.  A NULL string indicates an EOF
@@ -352,9 +476,10 @@ class SplatProcessor {
 
     char LoadSDF(char *name);
     /* This function loads the requested SDF file from the filesystem.
-       It first tries to invoke the LoadSDF_SDF() function to load an
+       It first tries to invoke the LoadSDF_BIN() function to map a
+       binary .bsdf tile, then the LoadSDF_SDF() function to load an
        uncompressed SDF file (since uncompressed files load slightly
-       faster).  If that attempt fails, then it tries to load a
+       faster).  If those attempts fail, then it tries to load a
        compressed SDF file by invoking the LoadSDF_BZ() function.
        If that fails, then we can assume that no elevation data
        exists for the region requested, and that the region
@@ -390,7 +515,8 @@ class SplatProcessor {
        condition will result in the default parameters hard coded
        into this function to be used and written to "splat.lrp". */
 
-    void PlotPath(struct site source, struct site destination, char mask_value);
+    void PlotPath(PathContext &ctx, struct site source, struct site destination,
+                  char mask_value);
     /* This function analyzes the path between the source and
        destination locations.  It determines which points along
        the path have line-of-sight visibility to the source.
@@ -400,13 +526,97 @@ class SplatProcessor {
        mask[][] array, which are displayed in green when PPM
        maps are later generated by SPLAT!. */
 
-    void PlotLRPath(struct site source, struct site destination, unsigned char mask_value,
-                    FILE *fd);
+    int PlotLRPath(PathContext &ctx, struct site source, struct site destination,
+                   unsigned char mask_value, FILE *fd);
     /* This function plots the RF path loss between source and
        destination points based on the ITWOM propagation model,
-       taking into account antenna pattern data, if available. */
-
-    void PlotLOSMap(struct site source, double altitude);
+       taking into account antenna pattern data, if available.
+       Returns the number of points left unevaluated by pruning. */
+
+    void CopyLRElevations(PathContext &ctx);
+    /* Copies the elevations (plus clutter) of ctx.path into
+       ctx.elev[] in the layout point_to_point expects. */
+
+    LRKernel SelectLRKernel(bool listed) const;
+    /* Returns the PlotLRKernel() specialization for the current
+       propagation model, elevation pattern and map units, and for
+       whether alphanumeric output is "listed". */
+
+    int PlotLRPoints(PathContext &ctx, struct site source, struct site destination,
+                     const std::vector<int> &points, std::string *ano);
+    /* This function evaluates the path loss to each of the given
+       points of ctx.path, in order, and passes the results to
+       PlotLRPoint().  ctx.elev[] must already hold the output of
+       CopyLRElevations().  When pruning, the rest of the points are
+       dropped once the radial has stayed below prune_floor_ for
+       prune_span_ miles; the number dropped is returned. */
+
+    template <bool OldITM, bool Obstruction, int Units>
+    int PlotLRKernel(PathContext &ctx, struct site source, struct site destination,
+                     const std::vector<int> &points, std::string *ano);
+    /* PlotLRPoints() for one propagation model, with or without
+       the search for the first obstruction, and one of LRUnits. */
+
+    template <bool Obstruction, int Units>
+    double PlotLRPoint(PathContext &ctx, struct site source, struct site destination, int y,
+                       double loss, double offset, std::string *ano);
+    /* This function merges the path loss to point y of ctx.path,
+       as found by the propagation model, into the signal[][] array.
+       "offset" is the strength, in the map's units, of a 0 dB loss.
+       Alphanumeric output, if requested, is appended to *ano.
+       Returns the strength plotted, in the map's units (dBm, dBuV/m,
+       or minus the path loss), so that larger is always stronger. */
+
+    void SectorEdges(struct site source, std::vector<struct site> &edges, double start,
+                     double end);
+    /* Drops those of "edges", consecutive points along one side
+       of the map, whose azimuth from the source lies outside
+       [start, end], locating the ones inside by bisection. */
+
+    void PlotLRAdaptive(PathContext &ctx, struct site source, double altitude, FILE *fd,
+                        double start, double end);
+    /* This function sweeps the coverage between azimuths "start"
+       and "end" with radials spaced for the coverage radius, at
+       most adaptive_spacing_ pixels apart at max_range_, rather
+       than with one radial per edge pixel, and then interpolates
+       any pixels within the radius that they missed. */
+
+    void FillLRGaps(struct site source, unsigned char mask_value, double start, double end);
+    /* Gives each pixel within max_range_ of the source, and
+       between azimuths "start" and "end", that the current
+       sweep did not evaluate the average signal of its evaluated
+       neighbours, until no more gaps can be filled. */
+
+    void EndLRMap(PathContext &ctx, FILE *fd, unsigned long pruned);
+    /* Closes the alphanumeric output of a sweep, reports on it,
+       and moves on to the next mask value. */
+
+    void PreparePruning(struct site source, FILE *fd);
+    /* Works out prune_floor_ from the contour levels and threshold
+       the map will be drawn with, and enables pruning for the sweep
+       if it was requested and no alphanumeric output is wanted. */
+
+    int ThreadCount();
+    /* Returns the number of sweep workers to use.  A value
+       of zero (the default) means one per hardware thread. */
+
+    void ParallelFor(int count, int threads, const std::function<void(int, int)> &body);
+    /* Runs body(index, worker) for every index in [0, count) on up
+       to "threads" workers of the processor's pool, the calling
+       thread being worker 0. */
+
+    void RenderRows(RasterStream &stream, int rows,
+                    const std::function<void(int, unsigned char *)> &draw);
+    /* Draws the rows of a map image on the sweep workers, handing
+       them to the stream a block at a time. */
+
+    void PlotLRRadials(PathContext &ctx, struct site source, const std::vector<struct site> &edges,
+                       unsigned char mask_value, FILE *fd, int z);
+    /* This function runs PlotLRPath() for every edge point in
+       "edges" on a pool of worker threads, producing a result
+       that is bit-identical to calling it for each in turn. */
+
+    void PlotLOSMap(PathContext &ctx, struct site source, double altitude);
     /* This function performs a 360 degree sweep around the
        transmitter site (source location), and plots the
        line-of-sight coverage of the transmitter on the SPLAT!
@@ -419,8 +629,8 @@ class SplatProcessor {
     double AdjustAngleForNegativeXAxis(double angle);
     // Add up 90 degrees to shift reference to the positive y-axis instead of negative x-axis.
 
-    void PlotLRMapSpecifiedAngles(struct site source, double altitude, char *plo_filename,
-                                  double start_angle, double end_angle);
+    void PlotLRMapSpecifiedAngles(PathContext &ctx, struct site source, double altitude,
+                                  char *plo_filename, double start_angle, double end_angle);
     /* This function performs a 360 degree sweep around the
        transmitter site (source location), and plots the
        Irregular Terrain Model attenuation on the SPLAT!
@@ -430,7 +640,7 @@ class SplatProcessor {
        of a topographic map when the WritePPMLR() or
        WritePPMSS() functions are later invoked. */
 
-    void PlotLRMap(struct site source, double altitude, char *plo_filename);
+    void PlotLRMap(PathContext &ctx, struct site source, double altitude, char *plo_filename);
     /* This function performs a 360 degree sweep around the
        transmitter site (source location), and plots the
        Irregular Terrain Model attenuation on the SPLAT!
@@ -446,6 +656,12 @@ class SplatProcessor {
 
     void LoadDBMColors();
 
+    void ClassifySignals(MapPalette &palette, int offset, unsigned char dbm);
+    /* Fills the palette's signal tables from the loaded colour
+       levels.  "offset" is subtracted from each signal byte to give
+       the value compared against them, and "dbm" marks a power level
+       map, where labels over 0 dBm are never inverted. */
+
     void WritePPM(char *filename, unsigned char geo, unsigned char kml, unsigned char ngs,
                   struct site *xmtr, unsigned char txsites);
     /* This function generates a topographic map in Portable Pix Map
@@ -538,10 +754,39 @@ class SplatProcessor {
 
     void SiteReport(const char *ppmFilePath, struct site xmtr);
 
+    bool AllocatePage(int indx, bool data = true);
+    /* Gives dem[indx] a zeroed coverage raster, plus a private
+       data grid unless "data" is false, allocated for the current
+       resolution.  Returns false, after reporting the error, if
+       memory is exhausted. */
+
+    bool UnshareTerrain(int indx);
+    /* Gives dem[indx] a private copy of its data grid if the grid
+       is shared, so it can be modified.  Returns false, after
+       reporting the error, if memory is exhausted. */
+
+    void ReleasePages();
+    /* Frees every DEM page and empties the pool, leaving room
+       for maxpages_ pages to be loaded by the next job. */
+
+    double DegreeLimit();
+    /* Returns the largest range (degrees) around a transmitter
+       that the page pool can cover. */
+
     void LoadTopoData(int max_lon, int min_lon, int max_lat, int min_lat);
     /* This function loads the SDF files required
        to cover the limits of the region specified. */
 
+    void LoadTile(int lat, int lon);
+    /* Loads the SDF file of the tile whose south-east corner
+       is at "lat" north, "lon" west. */
+
+    void LoadSectorTopoData(struct site source, double start, double end, int max_lon,
+                            int min_lon, int max_lat, int min_lat);
+    /* Loads only those tiles, within the limits given, that the
+       sector of radius max_range_ between azimuths "start" and
+       "end" around the source passes over. */
+
     int LoadANO(char *filename);
     /* This function reads a SPLAT! alphanumeric output
        file (-ani option) for analysis and/or map generation. */
@@ -552,17 +797,85 @@ class SplatProcessor {
 
     void prepareHeader(const char *splat_name, const char *splat_version, char *header);
 
-    void parseArguments(int argc, char *argv[], char *header, int &y);
+    void ParseJob(int argc, char *argv[], Job &job);
+    // Fills in "job" from SPLAT! command-line arguments.  Options that
+    // configure the processor itself (-threads, -hd, -maxpages,
+    // -adaptive, -prune) are applied to it instead
+
+    void RunJob(const Job &request);
+    // Runs "job"; called by process(), which names the program in the
+    // banner first
+
+    void setJob(const Job &job);
+    // Runs "job" on the next process(), rather than parsing argv_
 
     void process();
+    // Runs the job given by argv_, if any, else the one set by
+    // setJob() or setParameters()
 
     virtual void setParameters(const SMSplatInputInfo &params);
 
     void resetSplat();
 
+    void setThreadCount(unsigned int threads) { threads_ = threads; }
+    // Number of radial sweep workers (0 = one per hardware thread)
+
+    void setHDMode(bool hd) { hd_mode_ = hd ? 1 : 0; }
+    // Use 1 arc-second (-hd.sdf) rather than 3 arc-second terrain
+
+    void setMaxPages(int pages);
+    // Size of the DEM page pool; frees any pages currently loaded
+
+    void setProfileSummaries(bool summaries) { profile_summaries_ = summaries ? 1 : 0; }
+    // Evaluate radials from running profile summaries (the default)
+    // rather than rescanning every prefix; results agree to within
+    // rounding.  ITWOM still takes the terrain roughness of each
+    // prefix from the prefix itself
+
+    void setAdaptiveRadials(double spacing);
+    // Cast -L/-LA radials at most "spacing" pixels apart at the
+    // coverage radius, rather than to every edge pixel of the
+    // terrain in memory, and interpolate the pixels they miss;
+    // 0 (the default) keeps the edge radials
+
+    void setPruning(int margin_db, double window);
+    // Stop evaluating a radial once it has stayed margin_db fainter
+    // than the faintest plotted contour for "window" miles (kilometers
+    // with -metric); a negative margin (the default) disables pruning
+
+    unsigned long getPrunedEvaluations() const { return pruned_points_; }
+    // Path loss evaluations skipped by pruning in the current or
+    // most recent job
+
     // Add this new method to get the generated image info
     SMSplatGenInfo getGeneratedImageInfo() const { return generatedImageInfo_; }
     const cv::Mat &getImageBuffer() const { return image_; }
+
+    void setProgress(const SMSplatProgress &progress) { progress_ = progress; }
+    // Reports the terrain, sweep and render phases of each job to
+    // "progress", on the thread running process(), a few hundred
+    // times per job at most; an empty function stops the reports
+
+    void setCancelFlag(const std::atomic<bool> *cancel) { cancel_ = cancel; }
+    // Once *cancel turns true, sweeps stop evaluating radials and the
+    // job in progress throws SplatCancelled at its next check; NULL
+    // (the default) runs every job to completion
+
+    bool Cancelled() const { return cancel_ != NULL && cancel_->load(std::memory_order_relaxed); }
+
+    void CheckCancelled() const;
+    // Throws SplatCancelled if the current job has been cancelled
+
+    void ReportProgress(SMSplatPhase phase, double fraction);
+    // Passes "fraction" of "phase" done on to the progress function,
+    // unless the job has been cancelled
+
+    void setRasterSink(const RasterStream::Sink &sink) { raster_sink_ = sink; }
+    // Hands the -dbm map to "sink" in blocks of RasterStream::BLOCK_ROWS
+    // rows (BGR, or BGRA with -trans, with the index of each block's
+    // first row) as it is rendered, rather than keeping it whole for
+    // getImageBuffer(), which is then left empty; an empty sink
+    // restores the default
 };
 
 class ScopedTimer {
@@ -0,0 +1,97 @@
+#include "terrain_cache.h"
+
+/* 512 MB holds about 180 standard or 20 HD tiles */
+
+#define TERRAIN_CACHE_CAPACITY (512UL * 1024UL * 1024UL)
+
+static size_t TileBytes(const TerrainCache::Tile &tile) {
+    return sizeof(short) * (size_t)tile.ippd * tile.ippd;
+}
+
+TerrainCache::TerrainCache() : stats_() { stats_.capacity = TERRAIN_CACHE_CAPACITY; }
+
+TerrainCache &TerrainCache::instance() {
+    static TerrainCache cache;
+
+    return cache;
+}
+
+TerrainCache::Key TerrainCache::keyOf(const Tile &tile) {
+    return Key(tile.source.device, tile.source.inode, tile.source.modified, tile.min_north,
+               tile.max_north, tile.min_west, tile.max_west, tile.ippd);
+}
+
+std::shared_ptr<const TerrainCache::Tile> TerrainCache::find(const Source &source, int min_north,
+                                                             int max_north, int min_west,
+                                                             int max_west, int ippd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(Key(source.device, source.inode, source.modified, min_north, max_north,
+                              min_west, max_west, ippd));
+
+    if (it == index_.end()) {
+        stats_.misses++;
+        return nullptr;
+    }
+
+    /* Move to the front of the LRU list */
+
+    lru_.splice(lru_.begin(), lru_, it->second);
+    stats_.hits++;
+
+    return *it->second;
+}
+
+void TerrainCache::insert(std::shared_ptr<const Tile> tile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Key key = keyOf(*tile);
+    auto it = index_.find(key);
+
+    /* Another processor may have loaded the same tile meanwhile */
+
+    if (it != index_.end()) {
+        stats_.bytes -= TileBytes(**it->second);
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+
+    lru_.push_front(tile);
+    index_[key] = lru_.begin();
+    stats_.bytes += TileBytes(*tile);
+
+    evict();
+}
+
+void TerrainCache::evict() {
+    while (stats_.bytes > stats_.capacity && !lru_.empty()) {
+        const std::shared_ptr<const Tile> &oldest = lru_.back();
+
+        stats_.bytes -= TileBytes(*oldest);
+        stats_.evictions++;
+        index_.erase(keyOf(*oldest));
+        lru_.pop_back();
+    }
+
+    stats_.tiles = lru_.size();
+}
+
+void TerrainCache::setCapacity(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    stats_.capacity = bytes;
+    evict();
+}
+
+void TerrainCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    lru_.clear();
+    index_.clear();
+    stats_.bytes = 0;
+    stats_.tiles = 0;
+}
+
+TerrainCache::Stats TerrainCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return stats_;
+}
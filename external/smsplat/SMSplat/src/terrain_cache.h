@@ -0,0 +1,84 @@
+#ifndef TERRAIN_CACHE_H
+#define TERRAIN_CACHE_H
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+/*
+  Process-wide cache of one degree terrain tiles, shared by every
+  SplatProcessor.  Tiles are read-only once inserted and reference
+  counted: a processor keeps the tiles it is using alive even after
+  the cache evicts them, and the least recently used tiles are
+  evicted once the cache holds more than its byte capacity.  Tiles
+  are told apart by the file they were read from as well as by their
+  bounds, so jobs reading different SDF directories, or a file that
+  has since been rewritten, never share them.
+*/
+
+class TerrainCache {
+   public:
+    struct Source {
+        unsigned long long device = 0;  // File the tile is read from (st_dev, st_ino)
+        unsigned long long inode = 0;
+        long long modified = 0;         // Its modification time, in nanoseconds
+    };
+
+    struct Tile {
+        int min_north;
+        int max_north;
+        int min_west;
+        int max_west;
+        int min_el;
+        int max_el;
+        int ippd;                     // 1200 (3 arc-second) or 3600 (HD)
+        Source source;
+        std::shared_ptr<short[]> data;  // ippd x ippd elevations, [x][y]; never written
+    };
+
+    struct Stats {
+        unsigned long hits;
+        unsigned long misses;
+        unsigned long evictions;
+        size_t tiles;     // Tiles currently cached
+        size_t bytes;     // Elevation data currently cached
+        size_t capacity;  // Byte limit before tiles are evicted
+    };
+
+    static TerrainCache &instance();
+    // The cache shared by all processors in this process
+
+    std::shared_ptr<const Tile> find(const Source &source, int min_north, int max_north,
+                                     int min_west, int max_west, int ippd);
+    // Returns the tile cached from "source", or nullptr (counted as a miss)
+
+    void insert(std::shared_ptr<const Tile> tile);
+    // Adds a freshly loaded tile, evicting old tiles as needed
+
+    void setCapacity(size_t bytes);
+    // Limits the elevation data kept; 0 disables caching
+
+    void clear();
+    // Drops every cached tile (tiles in use stay alive)
+
+    Stats stats() const;
+
+   private:
+    TerrainCache();
+
+    typedef std::tuple<unsigned long long, unsigned long long, long long, int, int, int, int, int>
+        Key;
+    typedef std::list<std::shared_ptr<const Tile>> LRUList;
+
+    static Key keyOf(const Tile &tile);
+    void evict();  // Caller holds mutex_
+
+    mutable std::mutex mutex_;
+    LRUList lru_;  // Most recently used first
+    std::map<Key, LRUList::iterator> index_;
+    Stats stats_;
+};
+
+#endif  // TERRAIN_CACHE_H
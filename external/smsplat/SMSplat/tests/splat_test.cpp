@@ -1,13 +1,73 @@
 #include <gtest/gtest.h>
 #include "splat.h"
 #include "splat_config.h"
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <memory>
 #include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <thread>
+#include <functional>
 #include "sm_splat_info.h"
+#include "sdf_bin.h"
+#include "terrain_cache.h"
+#include "mercator_resampler.h"
+#include "antenna_pattern.h"
+#ifdef HAVE_GDAL
+#include "gdal_handler.h"
+#endif
 
 class SplatTest : public ::testing::Test {
+public:
+    // The -L job most tests run: "meghu", 30 m up at 40.5 N 44.5 W, plotting
+    // dBm at 1400 MHz for 10 m receivers out to 10 km with -olditm, on the
+    // terrain in "dir" (sea level where it has none).  "overrides" adjusts it.
+    static SplatProcessor::Job makeJob(
+        const std::string &dir,
+        const std::function<void(SplatProcessor::Job &)> &overrides = nullptr) {
+        SplatProcessor::Job job;
+        strcpy(job.tx_site[0].name, "meghu");
+        job.tx_site[0].lat = 40.5;
+        job.tx_site[0].lon = 360.0 - 315.5;
+        job.tx_site[0].alt = 30 * 3.28084;
+        job.txsites = 1;
+        job.forced_freq = 1400;
+        job.altitudeLR = 10;
+        job.LRmap = 1;
+        job.area_mode = 1;
+        job.dbm = 1;
+        job.olditm = 1;
+        job.metric = 1;
+        job.max_range = 10;
+        strncpy(job.sdf_path, dir.c_str(), sizeof(job.sdf_path) - 1);
+        if (overrides) overrides(job);
+        return job;
+    }
+
+    // Runs makeJob(dir, overrides) on a fresh processor, after "setup"
+    // has configured it
+    static std::unique_ptr<SplatProcessor> runJob(
+        const std::string &dir,
+        const std::function<void(SplatProcessor::Job &)> &overrides = nullptr,
+        const std::function<void(SplatProcessor &)> &setup = nullptr) {
+        auto processor = std::make_unique<SplatProcessor>();
+        if (setup) setup(*processor);
+        processor->setJob(makeJob(dir, overrides));
+        processor->process();
+        return processor;
+    }
+
+    // Moves the transmitter to 40.964 N 44.665 W with a 5 km radius
+    static void nearMeghu(SplatProcessor::Job &job) {
+        job.tx_site[0].lat = 40.964;
+        job.tx_site[0].lon = 360.0 - 315.335;
+        job.max_range = 5;
+    }
+
 protected:
     // Add this member variable
     std::string elev_path;
@@ -137,6 +197,1158 @@ TEST_F(SplatTest, InvalidParameters) {
 
 }
 
+// The threaded -L sweep must reproduce the serial signal map exactly
+TEST_F(SplatTest, ParallelSweepMatchesSerial) {
+    // The missing directory makes SPLAT! fall back to sea-level pages
+    auto run = [](unsigned int threads) {
+        return runJob("/nonexistent/", nearMeghu,
+                      [&](SplatProcessor &processor) { processor.setThreadCount(threads); });
+    };
+
+    auto serial = run(1);
+    auto parallel = run(4);
+    int covered = 0;
+
+    for (int x = 0; x < 240; x++) {
+        for (int y = 0; y < 240; y++) {
+            double lat = 40.9 + x / 1200.0, lon = 44.6 + y / 1200.0;
+            ASSERT_EQ(serial->GetSignal(lat, lon), parallel->GetSignal(lat, lon))
+                << "at " << lat << ", " << lon;
+            if (serial->GetSignal(lat, lon) != 0) covered++;
+        }
+    }
+
+    EXPECT_GT(covered, 0);
+}
+
+// One processor serves both resolutions; pages are freed between jobs
+TEST_F(SplatTest, RuntimeResolutionAndPagePool) {
+    auto processor = std::make_unique<SplatProcessor>();
+    auto run = [&](bool hd) {
+        processor->setHDMode(hd);
+        processor->setJob(makeJob("/nonexistent/", nearMeghu));
+        processor->process();
+
+        int covered = 0;
+        for (int x = 0; x < 120; x++)
+            for (int y = 0; y < 120; y++)
+                if (processor->GetSignal(40.95 + x / 3600.0, 44.65 + y / 3600.0) != 0) covered++;
+        return covered;
+    };
+
+    int hd = run(true);
+    processor->resetSplat();
+    EXPECT_EQ(processor->GetSignal(40.964, 44.665), 0);
+
+    int sd = run(false);
+    EXPECT_GT(hd, 0);
+    EXPECT_GT(sd, 0);
+
+    EXPECT_THROW(processor->setMaxPages(0), std::invalid_argument);
+}
+
+// ReadPath()'s incremental great circle stepping must track the direct formulas
+TEST_F(SplatTest, ReadPathMatchesGreatCircle) {
+    splat = runJob("/nonexistent/", nearMeghu);
+
+    const double deg2rad = 1.74532925199e-02;
+    SplatProcessor::site source = {40.964, 44.665, 30.0f, "", ""};
+    SplatProcessor::path path;
+
+    for (double bearing = 0.0; bearing < 360.0; bearing += 7.5) {
+        SplatProcessor::site destination = source;
+        destination.lat += 0.6 * cos(bearing * deg2rad);
+        destination.lon -= 0.6 * sin(bearing * deg2rad);
+
+        splat->ReadPath(source, destination, path);
+        ASSERT_GT(path.length, 100);
+
+        // The same sample positions, computed from scratch as SPLAT! always did
+        double lat1 = source.lat * deg2rad, lon1 = source.lon * deg2rad;
+        double azimuth = splat->Azimuth(source, destination) * deg2rad;
+
+        for (int c = 0; c < path.length - 1; c++) {
+            double beta = path.distance[c] / 3959.0;
+            double lat2 = asin(sin(lat1) * cos(beta) + cos(azimuth) * sin(beta) * cos(lat1));
+            double num = cos(beta) - sin(lat1) * sin(lat2), den = cos(lat1) * cos(lat2);
+            double lon2 = lon1;
+
+            if (fabs(num / den) <= 1.0)
+                lon2 = (azimuth <= 3.141592653589793 ? lon1 - splat->arccos(num, den)
+                                                     : lon1 + splat->arccos(num, den));
+
+            lon2 = fmod(lon2 + 4.0 * 3.141592653589793, 2.0 * 3.141592653589793);
+
+            ASSERT_NEAR(path.lat[c], lat2 / deg2rad, 1e-9) << "bearing " << bearing << ", sample " << c;
+            // acos() loses precision on near north-south paths; allow a hundredth of a pixel
+            ASSERT_NEAR(path.lon[c], lon2 / deg2rad, 1e-5) << "bearing " << bearing << ", sample " << c;
+
+            SplatProcessor::site sample = {path.lat[c], path.lon[c], 0.0f, "", ""};
+            ASSERT_EQ(path.elevation[c], splat->GetElevation(sample));
+        }
+    }
+}
+
+// A tile read by one job is shared with the next instead of reloaded
+TEST_F(SplatTest, TerrainCacheSharesTiles) {
+    // Flat 100 m terrain for the transmitter's tile, as a binary SDF
+    std::string dir = testing::TempDir() + "splat_cache_test/";
+    std::filesystem::create_directories(dir);
+
+    sdf_bin_header header = {};
+    memcpy(header.magic, SDF_BIN_MAGIC, 8);
+    header.version = SDF_BIN_VERSION;
+    header.byte_order = SDF_BIN_BYTE_ORDER;
+    header.ippd = 1200;
+    header.max_west = 45;
+    header.min_north = 40;
+    header.min_west = 44;
+    header.max_north = 41;
+    header.min_el = 100;
+    header.max_el = 100;
+
+    std::vector<short> elevations(1200 * 1200, 100);
+    FILE *fd = fopen((dir + "40_41_44_45.bsdf").c_str(), "wb");
+    ASSERT_NE(fd, nullptr);
+    fwrite(&header, sizeof(header), 1, fd);
+    fwrite(elevations.data(), sizeof(short), elevations.size(), fd);
+    fclose(fd);
+
+    auto run = [&]() { return runJob(dir, nearMeghu); };
+
+    TerrainCache &cache = TerrainCache::instance();
+    cache.clear();
+
+    auto first = run();
+    TerrainCache::Stats before = cache.stats();
+    auto second = run();
+    TerrainCache::Stats after = cache.stats();
+
+    EXPECT_EQ(before.tiles, 1u);
+    EXPECT_GT(after.hits, before.hits);
+    EXPECT_EQ(after.misses, before.misses);  // Sea-level tiles have no file to look up
+
+    auto covered = [](SplatProcessor &processor) {
+        int count = 0;
+        for (int x = 0; x < 120; x++)
+            for (int y = 0; y < 120; y++)
+                if (processor.GetSignal(40.93 + x / 1200.0, 44.63 + y / 1200.0) != 0) count++;
+        return count;
+    };
+
+    for (int x = 0; x < 120; x++)
+        for (int y = 0; y < 120; y++) {
+            double lat = 40.93 + x / 1200.0, lon = 44.63 + y / 1200.0;
+            ASSERT_EQ(first->GetSignal(lat, lon), second->GetSignal(lat, lon));
+        }
+
+    // User-defined terrain stays private to the processor adding it
+    SplatProcessor::site meghu = {};
+    meghu.lat = 40.964;
+    meghu.lon = 44.665;
+    EXPECT_EQ(first->AddElevation(40.964, 44.665, 50.0), 1);
+    EXPECT_DOUBLE_EQ(first->GetElevation(meghu), 492.126);  // 150 m in feet
+    EXPECT_DOUBLE_EQ(second->GetElevation(meghu), 328.084);
+
+    // A zero capacity evicts everything; processors keep their tiles
+    int coverage = covered(*second);
+    cache.setCapacity(0);
+    EXPECT_EQ(cache.stats().tiles, 0u);
+    EXPECT_GT(cache.stats().evictions, 0u);
+    EXPECT_GT(coverage, 0);
+    EXPECT_EQ(covered(*second), coverage);
+    EXPECT_DOUBLE_EQ(second->GetElevation(meghu), 328.084);  // 100 m in feet
+    cache.setCapacity(before.capacity);
+
+    std::filesystem::remove_all(dir);
+}
+
+// Runs a short -L job on the terrain in "dir", read afresh rather than
+// shared from an earlier test through the TerrainCache
+static std::unique_ptr<SplatProcessor> LoadTerrain(const std::string &dir) {
+    TerrainCache::instance().clear();
+    auto processor = SplatTest::runJob(dir, [](SplatProcessor::Job &job) { job.max_range = 1; });
+    TerrainCache::instance().clear();
+    return processor;
+}
+
+// A text SDF converted by sdf2bsdf loads with the same elevations
+TEST_F(SplatTest, BinarySDFRoundTrip) {
+#ifndef SDF2BSDF
+    GTEST_SKIP() << "sdf2bsdf is not built alongside the tests";
+#else
+    std::string text = testing::TempDir() + "splat_sdf_text/";
+    std::string binary = testing::TempDir() + "splat_sdf_binary/";
+    std::filesystem::create_directories(text);
+    std::filesystem::create_directories(binary);
+
+    std::ofstream sdf(text + "40_41_44_45.sdf");
+    sdf << "45\n40\n44\n41\n";
+    for (int x = 0; x < 1200; x++)
+        for (int y = 0; y < 1200; y++) sdf << (x * 7 + y * 13) % 900 - 50 << "\n";
+    sdf.close();
+
+    std::string convert = "cd " + binary + " && " SDF2BSDF " " + text + "40_41_44_45.sdf";
+    ASSERT_EQ(std::system(convert.c_str()), 0);
+
+    auto from_text = LoadTerrain(text);
+    auto from_binary = LoadTerrain(binary);
+    SplatProcessor::site pixel = {};
+    int differ = 0, land = 0;
+
+    for (int x = 0; x < 1200; x++)
+        for (int y = 0; y < 1200; y++) {
+            pixel.lat = 40.0 + x / 1200.0;
+            pixel.lon = 44.0 + y / 1200.0;
+            if (from_text->GetElevation(pixel) != from_binary->GetElevation(pixel)) differ++;
+            if (from_binary->GetElevation(pixel) != 0.0) land++;
+        }
+
+    EXPECT_EQ(differ, 0);
+    EXPECT_GT(land, 1200 * 1200 / 2);
+
+    std::filesystem::remove_all(text);
+    std::filesystem::remove_all(binary);
+#endif
+}
+
+// A binary SDF whose header or size does not fit the tile is ignored,
+// leaving the tile at sea level
+TEST_F(SplatTest, BinarySDFRejectsMismatchedFiles) {
+    std::string dir = testing::TempDir() + "splat_sdf_reject/";
+    std::filesystem::create_directories(dir);
+
+    auto write = [&](void (*edit)(sdf_bin_header &), size_t samples) {
+        sdf_bin_header header = {};
+        memcpy(header.magic, SDF_BIN_MAGIC, 8);
+        header.version = SDF_BIN_VERSION;
+        header.byte_order = SDF_BIN_BYTE_ORDER;
+        header.ippd = 1200;
+        header.max_west = 45;
+        header.min_north = 40;
+        header.min_west = 44;
+        header.max_north = 41;
+        header.min_el = 100;
+        header.max_el = 100;
+        edit(header);
+
+        std::vector<short> elevations(samples, 100);
+        FILE *fd = fopen((dir + "40_41_44_45.bsdf").c_str(), "wb");
+        ASSERT_NE(fd, nullptr);
+        fwrite(&header, sizeof(header), 1, fd);
+        fwrite(elevations.data(), sizeof(short), elevations.size(), fd);
+        fclose(fd);
+    };
+    auto elevation = [&]() {
+        SplatProcessor::site site = {};
+        site.lat = 40.5;
+        site.lon = 44.5;
+        return LoadTerrain(dir)->GetElevation(site);
+    };
+
+    write([](sdf_bin_header &) {}, 1200 * 1200);
+    EXPECT_DOUBLE_EQ(elevation(), 328.084);  // 100 m in feet
+
+    write([](sdf_bin_header &header) { header.magic[0] = 'X'; }, 1200 * 1200);
+    EXPECT_EQ(elevation(), 0.0);
+
+    write([](sdf_bin_header &header) { header.version++; }, 1200 * 1200);
+    EXPECT_EQ(elevation(), 0.0);
+
+    write([](sdf_bin_header &header) { header.ippd = 3600; }, 1200 * 1200);
+    EXPECT_EQ(elevation(), 0.0);
+
+    write([](sdf_bin_header &) {}, 1200 * 1200 - 1);
+    EXPECT_EQ(elevation(), 0.0);
+
+    std::filesystem::remove_all(dir);
+}
+
+// Two bzip2 compressed SDF tiles read by one job load with the same
+// elevations as their uncompressed copies
+TEST_F(SplatTest, CompressedSDFMatchesText) {
+    std::string text = testing::TempDir() + "splat_sdf_plain/";
+    std::string compressed = testing::TempDir() + "splat_sdf_bz2/";
+    std::filesystem::create_directories(text);
+    std::filesystem::create_directories(compressed);
+
+    for (int north = 40; north <= 41; north++) {
+        std::ostringstream sdf;
+        sdf << "45\n" << north << "\n44\n" << north + 1 << "\n";
+        for (int x = 0; x < 1200; x++)
+            for (int y = 0; y < 1200; y++) sdf << (x * 7 + y * (north - 27)) % 900 - 50 << "\n";
+
+        std::string name = std::to_string(north) + "_" + std::to_string(north + 1) + "_44_45.sdf";
+        std::ofstream(text + name) << sdf.str();
+
+        int bzerror;
+        FILE *fd = fopen((compressed + name + ".bz2").c_str(), "wb");
+        ASSERT_NE(fd, nullptr);
+        BZFILE *bzfd = BZ2_bzWriteOpen(&bzerror, fd, 9, 0, 0);
+        std::string data = sdf.str();
+        BZ2_bzWrite(&bzerror, bzfd, &data[0], data.size());
+        BZ2_bzWriteClose(&bzerror, bzfd, 0, NULL, NULL);
+        fclose(fd);
+        ASSERT_EQ(bzerror, BZ_OK);
+    }
+
+    // Straddle both tiles
+    auto load = [](const std::string &dir) {
+        TerrainCache::instance().clear();
+        auto processor = runJob(dir, [](SplatProcessor::Job &job) {
+            job.tx_site[0].lat = 40.995;
+            job.max_range = 2;
+        });
+        TerrainCache::instance().clear();
+        return processor;
+    };
+    auto from_text = load(text);
+    auto from_bz2 = load(compressed);
+    SplatProcessor::site pixel = {};
+    int differ = 0, land = 0;
+
+    for (int x = 0; x < 2400; x += 3)
+        for (int y = 0; y < 1200; y += 3) {
+            pixel.lat = 40.0 + x / 1200.0;
+            pixel.lon = 44.0 + y / 1200.0;
+            if (from_text->GetElevation(pixel) != from_bz2->GetElevation(pixel)) differ++;
+            if (from_bz2->GetElevation(pixel) != 0.0) land++;
+        }
+
+    EXPECT_EQ(differ, 0);
+    EXPECT_GT(land, 800 * 400 / 2);
+
+    std::filesystem::remove_all(text);
+    std::filesystem::remove_all(compressed);
+}
+
+// Writes rolling 0 - 600 m hills for a tile (40_41_44_45 by default), as a binary SDF
+static void WriteRollingHills(const std::string &dir, int north = 40, int west = 44) {
+    std::filesystem::create_directories(dir);
+
+    sdf_bin_header header = {};
+    memcpy(header.magic, SDF_BIN_MAGIC, 8);
+    header.version = SDF_BIN_VERSION;
+    header.byte_order = SDF_BIN_BYTE_ORDER;
+    header.ippd = 1200;
+    header.max_west = west + 1;
+    header.min_north = north;
+    header.min_west = west;
+    header.max_north = north + 1;
+    header.min_el = 0;
+    header.max_el = 600;
+
+    std::vector<short> elevations(1200 * 1200);
+    for (int x = 0; x < 1200; x++)
+        for (int y = 0; y < 1200; y++)
+            elevations[x * 1200 + y] =
+                (short)(300.0 + 150.0 * sin(x / 37.0) * cos(y / 23.0) + 150.0 * sin((x + y) / 91.0));
+
+    std::string name = std::to_string(north) + "_" + std::to_string(north + 1) + "_" +
+                       std::to_string(west) + "_" + std::to_string(west + 1) + ".bsdf";
+
+    FILE *fd = fopen((dir + name).c_str(), "wb");
+    if (fd == NULL) return;
+    fwrite(&header, sizeof(header), 1, fd);
+    fwrite(elevations.data(), sizeof(short), elevations.size(), fd);
+    fclose(fd);
+}
+
+// On varied terrain too, with either model, and with the workers kept
+// for a second job on the same processor
+TEST_F(SplatTest, ParallelSweepMatchesSerialOnHills) {
+    std::string dir = testing::TempDir() + "splat_parallel_hills/";
+    WriteRollingHills(dir);
+
+    for (unsigned char olditm : {1, 0}) {
+        auto model = [&](SplatProcessor::Job &job) { job.olditm = olditm; };
+        auto serial = runJob(dir, model, [](SplatProcessor &processor) {
+            processor.setThreadCount(1);
+        });
+        auto parallel = std::make_unique<SplatProcessor>();
+        parallel->setThreadCount(4);
+
+        for (int pass = 0; pass < 2; pass++) {
+            parallel->setJob(makeJob(dir, model));
+            parallel->process();
+
+            std::set<int> levels;
+
+            for (int x = 0; x < 240; x++)
+                for (int y = 0; y < 300; y++) {
+                    double lat = 40.4 + x / 1200.0, lon = 44.375 + y / 1200.0;
+                    ASSERT_EQ(serial->GetSignal(lat, lon), parallel->GetSignal(lat, lon))
+                        << "at " << lat << ", " << lon << (olditm ? " with" : " without")
+                        << " -olditm, pass " << pass;
+                    levels.insert(serial->GetSignal(lat, lon));
+                }
+
+            EXPECT_GT(levels.size(), 20u);
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+// The same tile read from another directory, or from a file rewritten
+// since, is not taken from the TerrainCache
+TEST_F(SplatTest, TerrainCacheKeepsSourcesApart) {
+    std::string hills = testing::TempDir() + "splat_cache_hills/";
+    std::string flat = testing::TempDir() + "splat_cache_flat/";
+    WriteRollingHills(hills);
+    WriteRollingHills(flat);
+
+    // Level the second copy at 100 m
+    FILE *fd = fopen((flat + "40_41_44_45.bsdf").c_str(), "r+b");
+    ASSERT_NE(fd, nullptr);
+    sdf_bin_header header;
+    ASSERT_EQ(fread(&header, sizeof(header), 1, fd), 1u);
+    header.min_el = header.max_el = 100;
+    std::vector<short> elevations(1200 * 1200, 100);
+    fseek(fd, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, fd);
+    fwrite(elevations.data(), sizeof(short), elevations.size(), fd);
+    fclose(fd);
+
+    auto run = [](const std::string &dir) {
+        return runJob(dir, [](SplatProcessor::Job &job) { job.max_range = 1; });
+    };
+    SplatProcessor::site site = {};
+    site.lat = 40.5;
+    site.lon = 44.5;
+
+    TerrainCache &cache = TerrainCache::instance();
+    cache.clear();
+
+    double hilltop = run(hills)->GetElevation(site);
+    EXPECT_NE(hilltop, 328.084);
+    EXPECT_DOUBLE_EQ(run(flat)->GetElevation(site), 328.084);  // 100 m in feet
+    EXPECT_EQ(cache.stats().tiles, 2u);
+
+    unsigned long hits = cache.stats().hits;
+    EXPECT_EQ(run(hills)->GetElevation(site), hilltop);
+    EXPECT_GT(cache.stats().hits, hits);
+
+    // Rewrite the hills as a flat tile
+    std::filesystem::copy_file(flat + "40_41_44_45.bsdf", hills + "40_41_44_45.bsdf",
+                               std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::last_write_time(hills + "40_41_44_45.bsdf",
+                                     std::filesystem::file_time_type::clock::now() +
+                                         std::chrono::seconds(1));
+    EXPECT_DOUBLE_EQ(run(hills)->GetElevation(site), 328.084);
+
+    cache.clear();
+    std::filesystem::remove_all(hills);
+    std::filesystem::remove_all(flat);
+}
+
+// Radials evaluated from profile summaries match the direct models
+TEST_F(SplatTest, ProfileSummariesMatchDirect) {
+    std::string dir = testing::TempDir() + "splat_itm_test/";
+    WriteRollingHills(dir);
+
+    for (unsigned char olditm : {1, 0}) {
+        auto run = [&](bool summaries) {
+            return runJob(
+                dir,
+                [&](SplatProcessor::Job &job) {
+                    job.max_range = 15;
+                    job.olditm = olditm;
+                },
+                [&](SplatProcessor &processor) { processor.setProfileSummaries(summaries); });
+        };
+
+        auto direct = run(false);
+        auto summarized = run(true);
+        int covered = 0;
+
+        for (int x = 0; x < 240; x++)
+            for (int y = 0; y < 240; y++) {
+                double lat = 40.4 + x / 1200.0, lon = 44.4 + y / 1200.0;
+                ASSERT_EQ(direct->GetSignal(lat, lon), summarized->GetSignal(lat, lon))
+                    << "at " << lat << ", " << lon << (olditm ? " with" : " without")
+                    << " -olditm";
+                if (direct->GetSignal(lat, lon) != 0) covered++;
+            }
+
+        EXPECT_GT(covered, 0);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+// The first obstruction found on the horizon carried along a path is the
+// one a scan of every point in front of the receiver finds
+TEST_F(SplatTest, ObstructionHorizonMatchesScan) {
+    splat = runJob("/nonexistent/", [](SplatProcessor::Job &job) {
+        job.dbm = 0;
+        job.metric = 0;
+        job.clutter = 10;
+        job.max_range = 1;
+    });
+
+    // Rolling terrain with a stretch at sea level and a few sharp ridges
+    const int length = 600;
+    const double clutter = 10.0, radius = 1.3333333333333 * 20902230.97;
+    SplatProcessor::site source = {40.5, 44.5, 30.0f, "", ""};
+    SplatProcessor::site destination = {40.5, 44.0, 20.0f, "", ""};
+    SplatProcessor::PathContext ctx;
+    SplatProcessor::path &path = ctx.path;
+    path.grow(length);
+    path.length = length;
+    for (int x = 0; x < length; x++) {
+        path.lat[x] = 40.5;
+        path.lon[x] = 44.5 - x * 0.0008;
+        path.distance[x] = x * 0.04;
+        path.elevation[x] = (x > 150 && x < 210) ? 0.0
+                                                 : 300.0 + 250.0 * sin(x * 0.021) +
+                                                       60.0 * sin(x * 0.37) + (x % 97 == 0 ? 400.0 : 0.0);
+    }
+
+    splat->CopyLRElevations(ctx);
+
+    std::vector<int> points;
+    for (int y = 2; y < length - 1; y++) points.push_back(y);
+    std::string listing;
+    splat->PlotLRPoints(ctx, source, destination, points, &listing);
+    std::istringstream lines(listing);
+
+    double xmtr_alt = radius + source.alt + path.elevation[0];
+    int blocked = 0, clear = 0;
+    for (int y = 2; y < length - 1; y++) {
+        std::string ano;
+        ASSERT_TRUE(std::getline(lines, ano)) << "point " << y;
+
+        // Scan from the transmitter for the first point at or above the receiver's angle
+        auto cosine = [&](int x, double alt) {
+            double distance = 5280.0 * path.distance[x];
+            double c = (xmtr_alt * xmtr_alt + distance * distance - alt * alt) /
+                       (2.0 * xmtr_alt * distance);
+            return std::max(-1.0, std::min(1.0, c));
+        };
+        double cos_rcvr = cosine(y, radius + destination.alt + path.elevation[y]);
+        double angle = cos_rcvr;
+        bool block = false;
+        for (int x = 2; x < y && !block; x++) {
+            double cos_test = cosine(x, radius + (path.elevation[x] == 0.0
+                                                      ? 0.0
+                                                      : path.elevation[x] + clutter));
+            if (cos_rcvr >= cos_test) {
+                block = true;
+                angle = cos_test;
+            }
+        }
+
+        char elevation[32];
+        snprintf(elevation, sizeof(elevation), ", %.3f, ", acos(angle) / 1.74532925199e-02 - 90.0);
+        ASSERT_NE(ano.find(elevation), std::string::npos) << "point " << y << ": " << ano;
+        ASSERT_EQ(ano.find(" *") != std::string::npos, block) << "point " << y << ": " << ano;
+        (block ? blocked : clear)++;
+    }
+
+    EXPECT_GT(blocked, 0);
+    EXPECT_GT(clear, 0);
+}
+
+// Pruned radials leave faint pixels unplotted but change nothing they evaluate
+TEST_F(SplatTest, PruningSkipsFaintRadials) {
+    std::string dir = testing::TempDir() + "splat_prune_test/";
+    WriteRollingHills(dir);
+
+    auto run = [&](int margin) {
+        return runJob(
+            dir,
+            [](SplatProcessor::Job &job) {
+                job.contour_threshold = -90;
+                job.max_range = 15;
+            },
+            [&](SplatProcessor &processor) { processor.setPruning(margin, 1.0); });
+    };
+
+    EXPECT_THROW(SplatProcessor().setPruning(0, -1.0), std::invalid_argument);
+
+    auto full = run(-1);
+    auto pruned = run(0);
+    int covered = 0, dropped = 0;
+
+    EXPECT_EQ(full->getPrunedEvaluations(), 0u);
+    EXPECT_GT(pruned->getPrunedEvaluations(), 0u);
+
+    for (int x = 0; x < 240; x++)
+        for (int y = 0; y < 240; y++) {
+            double lat = 40.4 + x / 1200.0, lon = 44.4 + y / 1200.0;
+            int signal = pruned->GetSignal(lat, lon);
+
+            if (signal == 0) {
+                if (full->GetSignal(lat, lon) != 0) dropped++;
+                continue;
+            }
+
+            ASSERT_EQ(full->GetSignal(lat, lon), signal) << "at " << lat << ", " << lon;
+            covered++;
+        }
+
+    EXPECT_GT(covered, 0);
+    EXPECT_GT(dropped, 0);
+
+    std::filesystem::remove_all(dir);
+}
+
+// Adaptive radials leave no pixel inside the radius unevaluated
+TEST_F(SplatTest, AdaptiveRadialsCoverRadius) {
+    std::string dir = testing::TempDir() + "splat_adaptive_test/";
+    WriteRollingHills(dir);
+
+    auto run = [&](double spacing) {
+        return runJob(dir, [](SplatProcessor::Job &job) { job.max_range = 15; },
+                      [&](SplatProcessor &processor) {
+                          if (spacing > 0.0) processor.setAdaptiveRadials(spacing);
+                      });
+    };
+
+    EXPECT_THROW(SplatProcessor().setAdaptiveRadials(-1.0), std::invalid_argument);
+    auto full = run(0.0);
+    auto adaptive = run(3.0);
+
+    SplatProcessor::site source = {}, pixel = {};
+    source.lat = 40.5;
+    source.lon = 44.5;
+    int inside = 0, close = 0;
+    double error = 0.0;
+
+    for (int x = 0; x < 480; x++)
+        for (int y = 0; y < 480; y++) {
+            pixel.lat = 40.3 + x / 1200.0;
+            pixel.lon = 44.3 + y / 1200.0;
+
+            if (adaptive->Distance(source, pixel) > 15.0 / 1.609344 - 0.05) continue;
+
+            ASSERT_NE(adaptive->GetMask(pixel.lat, pixel.lon) & 248, 0)
+                << "at " << pixel.lat << ", " << pixel.lon;
+
+            int difference = std::abs(adaptive->GetSignal(pixel.lat, pixel.lon) -
+                                      full->GetSignal(pixel.lat, pixel.lon));
+            error += difference;
+            if (difference <= 3) close++;  // Within 3 dB
+            inside++;
+        }
+
+    // Filled pixels stay near what the full sweep evaluates there
+    ASSERT_GT(inside, 0);
+    EXPECT_LT(error / inside, 1.0);
+    EXPECT_GT(close, inside * 95 / 100);
+
+    std::filesystem::remove_all(dir);
+}
+
+// A sector (-LA) job loads only the tiles its wedge passes over
+TEST_F(SplatTest, SectorLoadsOnlyItsTiles) {
+    std::string dir = testing::TempDir() + "splat_sector_test/";
+    WriteRollingHills(dir);
+    WriteRollingHills(dir, 41, 45);
+
+    auto run = [&](bool sector) {
+        return runJob(dir, [&](SplatProcessor::Job &job) {
+            job.tx_site[0].lat = 40.9;
+            job.tx_site[0].lon = 360.0 - 315.1;
+            job.max_range = 30;
+            if (sector) {
+                job.specified_angle_mode = 1;
+                job.start_angle = 100;
+                job.end_angle = 170;
+            }
+        });
+    };
+
+    // Near the corner of its tile, the transmitter's square spans four
+    // tiles; the one to the north west is not in the sector
+    SplatProcessor::site northwest = {};
+    northwest.lat = 41.2;
+    northwest.lon = 45.2;
+
+    auto full = run(false);
+    auto sector = run(true);
+
+    EXPECT_GT(full->GetElevation(northwest), -5000.0);
+    EXPECT_EQ(sector->GetElevation(northwest), -5000.0);
+
+    // Inside the sector the sweep is unchanged
+    EXPECT_NE(sector->GetSignal(40.8, 44.8), 0);
+
+    std::filesystem::remove_all(dir);
+}
+
+// A raster sink receives the -dbm map in bounded blocks, in order
+TEST_F(SplatTest, RasterSinkStreamsBlocks) {
+    std::string dir = testing::TempDir() + "splat_raster_test/";
+    WriteRollingHills(dir);
+
+    auto whole = runJob(dir);
+    const cv::Mat &image = whole->getImageBuffer();
+    ASSERT_FALSE(image.empty());
+
+    int next = 0;
+    auto streamed = runJob(dir, nullptr, [&](SplatProcessor &processor) {
+        processor.setRasterSink([&](const cv::Mat &block, int row) {
+            EXPECT_EQ(row, next);
+            EXPECT_LE(block.rows, RasterStream::BLOCK_ROWS);
+            ASSERT_EQ(block.cols, image.cols);
+            EXPECT_EQ(memcmp(block.ptr<unsigned char>(0), image.ptr<unsigned char>(row),
+                             (size_t)block.rows * block.cols * 3),
+                      0);
+            next += block.rows;
+        });
+    });
+
+    EXPECT_EQ(next, image.rows);
+    EXPECT_TRUE(streamed->getImageBuffer().empty());
+
+    std::filesystem::remove_all(dir);
+}
+
+// Palette lookups give the same pixels as shading each one directly
+TEST_F(SplatTest, MapPaletteMatchesDirectShading) {
+    MapPalette bgr(true), rgb(false);
+    unsigned char spare[4];
+    const double one_over_gamma = 1.0 / 2.5;
+    const int min_elevation = 120, max_elevation = 900;
+    double conversion = 255.0 / pow((double)(max_elevation - min_elevation), one_over_gamma);
+
+    bgr.setTerrain(min_elevation, max_elevation, one_over_gamma, MapPalette::TERRAIN);
+    rgb.setTerrain(min_elevation, max_elevation, one_over_gamma, MapPalette::TERRAIN);
+
+    // Sea level is in the table even below the lowest loaded tile
+    const unsigned char *sea = bgr.background(0, spare);
+    EXPECT_EQ(sea[0], 170);
+    EXPECT_EQ(rgb.background(0, spare)[2], 170);
+
+    // Inside the table and above it, where user terrain can reach
+    for (int elevation : {min_elevation, 500, max_elevation, max_elevation + 40}) {
+        unsigned char grey = (unsigned char)(unsigned)(
+            0.5 + pow((double)(elevation - min_elevation), one_over_gamma) * conversion);
+        const unsigned char *pixel = bgr.background(elevation, spare);
+        EXPECT_EQ(pixel[0], grey);
+        EXPECT_EQ(pixel[1], grey);
+        EXPECT_EQ(pixel[2], grey);
+    }
+
+    bgr.setTerrain(min_elevation, max_elevation, one_over_gamma, MapPalette::CLEAR);
+    EXPECT_EQ(bgr.background(500, spare)[0], 0);
+    EXPECT_EQ(bgr.background(500, spare)[3], 0);
+    bgr.setTerrain(min_elevation, max_elevation, one_over_gamma, MapPalette::WHITE);
+    EXPECT_EQ(bgr.background(0, spare)[1], 255);
+
+    // Signal colours and labels come out in each palette's byte order
+    bgr.setSignal(150, 200, 50, 10, true, true);
+    rgb.setSignal(150, 200, 50, 10, true, false);
+    EXPECT_TRUE(bgr.plotted(150));
+    EXPECT_FALSE(bgr.plotted(151));
+    EXPECT_EQ(bgr.color(150)[0], 10);
+    EXPECT_EQ(rgb.color(150)[0], 200);
+    EXPECT_EQ(bgr.label(150)[2], 255 ^ 200);
+    EXPECT_EQ(rgb.label(150)[0], 255);
+    EXPECT_EQ(rgb.label(150)[1], 0);
+}
+
+// With -trans the -dbm image is BGRA, clear exactly where the -ngs map is white
+TEST_F(SplatTest, TransparentMapCarriesAlpha) {
+    std::string dir = testing::TempDir() + "splat_alpha_test/";
+    WriteRollingHills(dir);
+
+    auto white = runJob(dir, [](SplatProcessor::Job &job) { job.ngs = 1; });
+    auto clear = runJob(dir, [](SplatProcessor::Job &job) { job.transparent = 1; });
+    const cv::Mat &bgr = white->getImageBuffer(), &bgra = clear->getImageBuffer();
+
+    ASSERT_EQ(bgr.channels(), 3);
+    ASSERT_EQ(bgra.channels(), 4);
+    ASSERT_EQ(bgra.rows, bgr.rows);
+    ASSERT_EQ(bgra.cols, bgr.cols);
+
+    int opaque = 0, transparent = 0;
+    for (int y = 0; y < bgr.rows; y++) {
+        const unsigned char *in = bgr.ptr<unsigned char>(y), *out = bgra.ptr<unsigned char>(y);
+        for (int x = 0; x < bgr.cols; x++, in += 3, out += 4) {
+            if (in[0] == 255 && in[1] == 255 && in[2] == 255) {
+                ASSERT_EQ(out[3], 0) << "at " << x << ", " << y;
+                transparent++;
+            } else {
+                ASSERT_EQ(out[3], 255) << "at " << x << ", " << y;
+                ASSERT_EQ(memcmp(in, out, 3), 0) << "at " << x << ", " << y;
+                opaque++;
+            }
+        }
+    }
+
+    EXPECT_GT(opaque, 0);
+    EXPECT_GT(transparent, 0);
+
+    std::filesystem::remove_all(dir);
+}
+
+// The native Web Mercator resampler picks, for every output pixel, the
+// source pixel under its centre, as GDAL's nearest-neighbour warper does
+TEST_F(SplatTest, MercatorResamplerMatchesPointSampling) {
+    const int src_width = 300, src_height = 200;
+    const double src_gt[6] = {-1.0, 2.0 / src_width, 0.0, 41.0, 0.0, -2.0 / src_height};
+    const double deg2rad = M_PI / 180.0, R = MercatorResampler::EARTH_RADIUS;
+
+    // A grid a little larger than the source, so some pixels fall off it
+    double west = -1.05 * deg2rad * R, east = 1.05 * deg2rad * R;
+    double north = R * log(tan(M_PI / 4.0 + 41.05 * deg2rad / 2.0));
+    double south = R * log(tan(M_PI / 4.0 + 38.95 * deg2rad / 2.0));
+    const int dst_width = 320, dst_height = 410;
+    const double dst_gt[6] = {west, (east - west) / dst_width, 0.0,
+                              north, 0.0, (south - north) / dst_height};
+
+    ASSERT_TRUE(MercatorResampler::supports(src_gt, src_height, dst_gt));
+    MercatorResampler resampler(src_width, src_height, src_gt, dst_width, dst_height, dst_gt);
+
+    for (int channels : {3, 4}) {
+        cv::Mat input(src_height, src_width, channels == 4 ? CV_8UC4 : CV_8UC3);
+        for (int y = 0; y < src_height; y++)
+            for (int x = 0; x < src_width; x++)
+                for (int c = 0; c < channels; c++)
+                    input.ptr<unsigned char>(y)[channels * x + c] =
+                        (unsigned char)(x * 7 + y * 13 + c * 61);
+
+        cv::Mat output;
+        resampler.resample(input, output);
+        ASSERT_EQ(output.channels(), 4);
+        ASSERT_EQ(output.rows, dst_height);
+        ASSERT_EQ(output.cols, dst_width);
+
+        int outside = 0;
+        for (int y = 0; y < dst_height; y++) {
+            double northing = dst_gt[3] + (y + 0.5) * dst_gt[5];
+            double row = (atan(sinh(northing / R)) / deg2rad - src_gt[3]) / src_gt[5];
+            for (int x = 0; x < dst_width; x++) {
+                double easting = dst_gt[0] + (x + 0.5) * dst_gt[1];
+                double column = (easting / R / deg2rad - src_gt[0]) / src_gt[1];
+                const unsigned char *out = output.ptr<unsigned char>(y) + 4 * x;
+                unsigned char expected[4] = {0, 0, 0, (unsigned char)(channels == 4 ? 0 : 255)};
+
+                if (row >= 0 && row < src_height && column >= 0 && column < src_width) {
+                    const unsigned char *in =
+                        input.ptr<unsigned char>((int)row) + channels * (int)column;
+                    memcpy(expected, in, channels);
+                } else
+                    outside++;
+
+                ASSERT_EQ(memcmp(out, expected, 4), 0)
+                    << channels << " channels at " << x << ", " << y;
+            }
+        }
+        EXPECT_GT(outside, 0);
+    }
+}
+
+#ifdef HAVE_GDAL
+// Warps a north-up EPSG:4326 image (BGR or BGRA) to "dst_epsg" with GDAL's
+// own nearest-neighbour warper, transforming every pixel exactly, as a
+// BGRA image; "dst_geotransform" receives the grid GDAL picked
+static cv::Mat WarpWithGDAL(const cv::Mat &input, const double src_geotransform[6],
+                            int dst_epsg, double dst_geotransform[6]) {
+    int bands = input.channels(), band_map[4] = {3, 2, 1, 4};
+    double geotransform[6];
+    std::copy(src_geotransform, src_geotransform + 6, geotransform);
+
+    GDALDriver *driver = GetGDALDriverManager()->GetDriverByName("MEM");
+    GDALDataset *source = driver->Create("", input.cols, input.rows, bands, GDT_Byte, nullptr);
+    source->RasterIO(GF_Write, 0, 0, input.cols, input.rows, input.data, input.cols, input.rows,
+                     GDT_Byte, bands, band_map, bands, (GSpacing)input.step, 1);
+    source->SetGeoTransform(geotransform);
+    source->SetProjection("EPSG:4326");
+
+    OGRSpatialReference dst_srs;
+    dst_srs.importFromEPSG(dst_epsg);
+    char *dst_wkt = nullptr;
+    dst_srs.exportToWkt(&dst_wkt);
+
+    GDALDataset *warped = (GDALDataset *)GDALAutoCreateWarpedVRT(
+        source, source->GetProjectionRef(), dst_wkt, GRA_NearestNeighbour, 0.0, nullptr);
+    cv::Mat output;
+    if (warped) {
+        warped->GetGeoTransform(dst_geotransform);
+        output.create(warped->GetRasterYSize(), warped->GetRasterXSize(), CV_8UC4);
+        output.setTo(cv::Scalar(0, 0, 0, 255));
+        warped->RasterIO(GF_Read, 0, 0, output.cols, output.rows, output.data, output.cols,
+                         output.rows, GDT_Byte, bands, band_map, 4, (GSpacing)output.step, 1);
+        GDALClose(warped);
+    }
+
+    GDALClose(source);
+    CPLFree(dst_wkt);
+    return output;
+}
+
+// Web Mercator maps reprojected natively match GDAL's warper pixel for pixel
+TEST_F(SplatTest, MercatorResamplerMatchesGDALWarper) {
+    GdalHandler handler;
+
+    // A small -L map, and a tall one far enough north that the Mercator
+    // stretch varies across it: some source rows repeat, others are skipped
+    const struct {
+        int width, height;
+        double west, north, east, south;
+    } grids[] = {{613, 487, -44.8, 40.7, -44.2, 40.3}, {1201, 2399, 10.0, 72.5, 11.5, 69.0}};
+
+    for (const auto &grid : grids) {
+        const double src_gt[6] = {grid.west, (grid.east - grid.west) / grid.width, 0.0,
+                                  grid.north, 0.0, (grid.south - grid.north) / grid.height};
+
+        for (int channels : {3, 4}) {
+            cv::Mat input(grid.height, grid.width, channels == 4 ? CV_8UC4 : CV_8UC3);
+            for (int y = 0; y < grid.height; y++)
+                for (int x = 0; x < grid.width; x++)
+                    for (int c = 0; c < channels; c++)
+                        input.ptr<unsigned char>(y)[channels * x + c] =
+                            (unsigned char)(x * 7 + y * 13 + c * 61);
+
+            double dst_gt[6];
+            cv::Mat expected = WarpWithGDAL(input, src_gt, 3857, dst_gt);
+            ASSERT_FALSE(expected.empty());
+
+            cv::Mat output;
+            ProjectedBounds bounds;
+            ASSERT_TRUE(handler.translate_and_reproject_image_buffer(
+                input, output, bounds, {grid.west, grid.north, grid.east, grid.south}));
+
+            // The same grid as GDAL's...
+            ASSERT_EQ(output.rows, expected.rows);
+            ASSERT_EQ(output.cols, expected.cols);
+            EXPECT_DOUBLE_EQ(bounds.min_x, dst_gt[0]);
+            EXPECT_DOUBLE_EQ(bounds.min_y, dst_gt[3]);
+            EXPECT_DOUBLE_EQ(bounds.max_x, dst_gt[0] + dst_gt[1] * expected.cols);
+            EXPECT_DOUBLE_EQ(bounds.max_y, dst_gt[3] + dst_gt[5] * expected.rows);
+
+            // ...and the same pixels on it
+            for (int y = 0; y < output.rows; y++)
+                for (int x = 0; x < output.cols; x++)
+                    ASSERT_EQ(memcmp(output.ptr<unsigned char>(y) + 4 * x,
+                                     expected.ptr<unsigned char>(y) + 4 * x, 4),
+                              0)
+                        << channels << " channels at " << x << ", " << y;
+        }
+    }
+}
+
+// A -trans map comes out of GdalHandler as a -ngs map did once its white
+// pixels were made clear: the same colours on a clear background, sea
+// level included, since -ngs drew it white too. Web Mercator is resampled natively; World Mercator goes through
+// GDAL's warper and its band-mapped reads and writes.
+TEST_F(SplatTest, TransparentMapReprojectsLikeWhiteBackground) {
+    std::string dir = testing::TempDir() + "splat_reproject_test/";
+    WriteRollingHills(dir);
+
+    auto white = runJob(dir, [](SplatProcessor::Job &job) { job.ngs = 1; });
+    auto clear = runJob(dir, [](SplatProcessor::Job &job) { job.transparent = 1; });
+    const SMSplatGenInfo info = clear->getGeneratedImageInfo();
+    const std::vector<double> coords = {info.coordinates.west, info.coordinates.north,
+                                        info.coordinates.east, info.coordinates.south};
+    GdalHandler handler;
+
+    for (int epsg : {3857, 3395}) {
+        cv::Mat bgr, bgra;
+        ProjectedBounds bgr_bounds, bgra_bounds;
+        ASSERT_TRUE(handler.translate_and_reproject_image_buffer(white->getImageBuffer(), bgr,
+                                                                 bgr_bounds, coords, epsg));
+        ASSERT_TRUE(handler.translate_and_reproject_image_buffer(clear->getImageBuffer(), bgra,
+                                                                 bgra_bounds, coords, epsg));
+        ASSERT_EQ(bgra.rows, bgr.rows);
+        ASSERT_EQ(bgra.cols, bgr.cols);
+
+        int opaque = 0, transparent = 0;
+        for (int y = 0; y < bgr.rows; y++) {
+            const unsigned char *in = bgr.ptr<unsigned char>(y), *out = bgra.ptr<unsigned char>(y);
+            for (int x = 0; x < bgr.cols; x++, in += 4, out += 4) {
+                ASSERT_EQ(in[3], 255) << epsg << " at " << x << ", " << y;
+
+                if (in[0] == 255 && in[1] == 255 && in[2] == 255) {
+                    ASSERT_EQ(out[3], 0) << epsg << " at " << x << ", " << y;
+                    transparent++;
+                } else if (out[3] == 0) {
+                    // Off the map: black and opaque from BGR, clear from BGRA
+                    ASSERT_EQ(in[0] | in[1] | in[2] | out[0] | out[1] | out[2], 0)
+                        << epsg << " at " << x << ", " << y;
+                } else {
+                    ASSERT_EQ(memcmp(in, out, 4), 0) << epsg << " at " << x << ", " << y;
+                    opaque++;
+                }
+            }
+        }
+
+        EXPECT_GT(opaque, 0) << epsg;
+        EXPECT_GT(transparent, 0) << epsg;
+    }
+
+    std::filesystem::remove_all(dir);
+}
+#endif
+
+// Pattern gains come from the dB table, interpolated between its entries
+// away from nulls, and a pattern built once is shared through the cache
+TEST_F(SplatTest, AntennaPatternLooksUpDecibels) {
+    const int rows = AntennaPattern::ELEVATIONS;
+    std::vector<float> amplitude((size_t)AntennaPattern::AZIMUTHS * rows);
+    for (int az = 0; az < AntennaPattern::AZIMUTHS; az++)
+        for (int el = 0; el < rows; el++)
+            amplitude[(size_t)az * rows + el] =
+                0.05f + 0.9f * (float)((az * 7 + el * 3) % 101) / 100.0f;
+    amplitude[(size_t)90 * rows + 200] = 0.0f;  // No gain given: left at 0 dB
+
+    auto pattern = std::make_shared<AntennaPattern>(amplitude, true, false);
+
+    // Table entries are exact: azimuth az, elevation 10 - el / 10
+    for (int az : {0, 45, 359, 360})
+        for (int el : {0, 100, 555, 1000})
+            EXPECT_DOUBLE_EQ(pattern->gain(az, 10.0 - el / 10.0),
+                             20.0 * log10((double)pattern->amplitude(az, el)));
+    EXPECT_EQ(pattern->gain(90.0, -10.0), 0.0);
+
+    // Halfway between four entries is their mean
+    double corners = 0.0;
+    for (int az : {12, 13})
+        for (int el : {300, 301}) corners += 20.0 * log10((double)pattern->amplitude(az, el));
+    EXPECT_NEAR(pattern->gain(12.5, 10.0 - 30.05), corners / 4.0, 1e-9);
+
+    // Next to a zero amplitude the nearest entry is used instead
+    EXPECT_EQ(pattern->gain(90.3, 10.0 - 20.04), 0.0);
+    EXPECT_DOUBLE_EQ(pattern->gain(90.3, 10.0 - 20.06),
+                     20.0 * log10((double)pattern->amplitude(90, 201)));
+    EXPECT_DOUBLE_EQ(pattern->gain(89.4, 10.0 - 19.96),
+                     20.0 * log10((double)pattern->amplitude(89, 200)));
+
+    // Above +10 and below -90 degrees the pattern is not applied
+    EXPECT_EQ(pattern->gain(10.0, 11.0), 0.0);
+    EXPECT_EQ(pattern->gain(10.0, -91.0), 0.0);
+
+    EXPECT_EQ(AntennaPattern::fileKey("/nonexistent/antenna.az"), "");
+    EXPECT_EQ(AntennaPattern::find("test:pattern"), nullptr);
+    EXPECT_EQ(AntennaPattern::insert("test:pattern", pattern), pattern);
+    EXPECT_EQ(AntennaPattern::find("test:pattern"), pattern);
+}
+
+// Renders a topographic map of "pages" sea-level pages (4, 16, 64, ...)
+// on "threads" workers, returning the .ppm written and the time taken
+static std::string RenderTopoMap(int pages, unsigned int threads, double *seconds = nullptr) {
+    auto overrides = [](SplatProcessor::Job &job) {
+        job.forced_freq = 0;
+        job.altitudeLR = 0;
+        job.LRmap = 0;
+        job.area_mode = 0;
+        job.dbm = 0;
+        job.olditm = 0;
+        job.metric = 0;
+        job.max_range = 1000;
+    };
+    auto setup = [&](SplatProcessor &processor) {
+        processor.setMaxPages(pages);
+        processor.setThreadCount(threads);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    SplatTest::runJob("/nonexistent/", overrides, setup);
+    if (seconds)
+        *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string home = std::getenv("HOME") ? std::getenv("HOME") : "";
+    std::ifstream in(home + "/.cache/splat/splat_output.ppm", std::ios::binary);
+    std::stringstream ppm;
+    ppm << in.rdbuf();
+    return ppm.str();
+}
+
+// Map rows drawn on several workers match those drawn on one
+TEST_F(SplatTest, RenderRowsMatchSerial) {
+    std::string serial = RenderTopoMap(4, 1);
+    std::string parallel = RenderTopoMap(4, 4);
+
+    ASSERT_EQ(serial.compare(0, 13, "P6\n2400 2400\n"), 0);
+    EXPECT_TRUE(serial == parallel);
+}
+
+// Benchmark: run with --gtest_also_run_disabled_tests to see how map
+// drawing scales with the number of workers
+TEST_F(SplatTest, DISABLED_RenderScaling) {
+    for (int pages : {4, 16, 64}) {
+        double serial_time, parallel_time;
+        std::string serial = RenderTopoMap(pages, 1, &serial_time);
+        std::string parallel = RenderTopoMap(pages, 0, &parallel_time);
+
+        EXPECT_TRUE(serial == parallel);
+        printf("%2d pages: %.3f s on 1 worker, %.3f s on %u (%.1fx)\n", pages, serial_time,
+               parallel_time, std::thread::hardware_concurrency(), serial_time / parallel_time);
+    }
+}
+
+// A job filled in directly runs as its command line does
+TEST_F(SplatTest, JobMatchesCommandLine) {
+    std::string dir = testing::TempDir() + "splat_job_test/";
+    WriteRollingHills(dir);
+
+    std::vector<std::string> args = {"splat", "-t", "meghu", "40.5", "315.5", "30",
+                                     "-f", "1400", "-L", "10", "-dbm", "-olditm",
+                                     "-metric", "-R", "10", "-fz", "40", "-d", dir};
+    auto parsed = std::make_unique<SplatProcessor>();
+    for (auto &arg : args) parsed->argv_.push_back(&arg[0]);
+    parsed->process();
+
+    auto direct = runJob(dir, [](SplatProcessor::Job &job) { job.fzone_clearance = 0.4; });
+
+    const cv::Mat &a = parsed->getImageBuffer(), &b = direct->getImageBuffer();
+    ASSERT_FALSE(a.empty());
+    ASSERT_EQ(a.rows, b.rows);
+    ASSERT_EQ(a.cols, b.cols);
+    EXPECT_EQ(memcmp(a.data, b.data, a.total() * a.elemSize()), 0);
+    EXPECT_EQ(direct->GetSignal(40.6, 44.6), parsed->GetSignal(40.6, 44.6));
+
+    std::filesystem::remove_all(dir);
+}
+
+// Each phase reports rising progress, and a cancelled sweep stops the job
+TEST_F(SplatTest, ProgressAndCancellation) {
+    std::string dir = testing::TempDir() + "splat_progress_test/";
+    WriteRollingHills(dir);
+
+    std::vector<std::pair<SMSplatPhase, double>> reports;
+    runJob(dir, nullptr, [&](SplatProcessor &processor) {
+        processor.setThreadCount(2);
+        processor.setProgress([&](SMSplatPhase phase, double fraction) {
+            reports.emplace_back(phase, fraction);
+        });
+    });
+
+    ASSERT_FALSE(reports.empty());
+    for (size_t k = 1; k < reports.size(); k++) {
+        EXPECT_GE(reports[k].first, reports[k - 1].first);
+        if (reports[k].first == reports[k - 1].first && reports[k].first != SMSPLAT_TERRAIN) {
+            EXPECT_GE(reports[k].second, reports[k - 1].second);
+        }
+    }
+    for (SMSplatPhase phase : {SMSPLAT_TERRAIN, SMSPLAT_SWEEP, SMSPLAT_RENDER}) {
+        auto last = std::find_if(reports.rbegin(), reports.rend(),
+                                 [&](const std::pair<SMSplatPhase, double> &r) { return r.first == phase; });
+        ASSERT_NE(last, reports.rend()) << phase;
+        EXPECT_EQ(last->second, 1.0) << phase;
+    }
+
+    std::atomic<bool> cancel(false);
+    double furthest = 0.0;
+    auto cancelled = [&](SplatProcessor &processor) {
+        processor.setThreadCount(2);
+        processor.setCancelFlag(&cancel);
+        processor.setProgress([&](SMSplatPhase phase, double fraction) {
+            EXPECT_NE(phase, SMSPLAT_RENDER);
+            if (phase == SMSPLAT_SWEEP) furthest = fraction;
+            if (phase == SMSPLAT_SWEEP && fraction >= 0.25) cancel = true;
+        });
+    };
+    EXPECT_THROW(runJob(dir, nullptr, cancelled), SplatCancelled);
+    EXPECT_LT(furthest, 1.0);
+
+    std::filesystem::remove_all(dir);
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
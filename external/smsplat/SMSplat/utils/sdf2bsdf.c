@@ -0,0 +1,244 @@
+/**************************************************************\
+ **  sdf2bsdf: Converts SPLAT Data Files (.sdf or .sdf.bz2)  **
+ **  into the binary .bsdf format described in sdf_bin.h,    **
+ **  which SPLAT! maps directly into its DEM pages.          **
+ **************************************************************
+ **                    Compile like this:                    **
+ **  cc -Wall -O3 -s -I../src sdf2bsdf.c -lbz2 -o sdf2bsdf   **
+\**************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <bzlib.h>
+#include "sdf_bin.h"
+
+#define BZBUFFER 65536
+
+int	ippd, bzerror, opened=0;
+
+short	*elev;
+
+char *BZfgets(BZFILE *bzfd, unsigned length)
+{
+	/* Returns at most one less than 'length' characters
+	   (one line) from the bz2 compressed file *bzfd. */
+
+	static int x, y, nBuf;
+	static char buffer[BZBUFFER+1], output[BZBUFFER+1];
+	char done=0;
+
+	if (opened!=1 && bzerror==BZ_OK)
+	{
+		x=0;
+		y=0;
+		nBuf=0;
+		opened=1;
+		output[0]=0;
+	}
+
+	do
+	{
+		if (x==nBuf && bzerror!=BZ_STREAM_END && bzerror==BZ_OK && opened)
+		{
+			nBuf=BZ2_bzRead(&bzerror,bzfd,buffer,BZBUFFER);
+			buffer[nBuf]=0;
+			x=0;
+		}
+
+		output[y]=buffer[x];
+
+		if (output[y]=='\n' || output[y]==0 || y==(int)length-1)
+		{
+			output[y+1]=0;
+			done=1;
+			y=0;
+		}
+
+		else
+			y++;
+		x++;
+
+	} while (done==0);
+
+	if (output[0]==0)
+	{
+		opened=0;
+		return NULL;
+	}
+
+	return (output);
+}
+
+int ReadSDF(char *filename, struct sdf_bin_header *header)
+{
+	/* Reads a text SDF, compressed or not, into elev[] and
+	   fills in the quadrangle limits and elevation extremes
+	   of *header.  Returns 0 on success. */
+
+	int x, y, data, values[4], error=0;
+	char line[20], *string;
+	FILE *fd;
+	BZFILE *bzfd=NULL;
+
+	fd=fopen(filename,"rb");
+
+	if (fd==NULL)
+	{
+		fprintf(stderr,"*** Error: Cannot open \"%s\"\n",filename);
+		return -1;
+	}
+
+	if (strstr(filename,".bz2")!=NULL)
+	{
+		bzerror=BZ_OK;
+		opened=0;
+		bzfd=BZ2_bzReadOpen(&bzerror,fd,0,0,NULL,0);
+
+		if (bzerror!=BZ_OK)
+		{
+			fprintf(stderr,"*** Error: \"%s\" is not a valid bz2 file\n",filename);
+			fclose(fd);
+			return -1;
+		}
+	}
+
+	for (x=0; x<4 && error==0; x++)
+	{
+		string=(bzfd!=NULL ? BZfgets(bzfd,19) : fgets(line,19,fd));
+
+		if (string==NULL || sscanf(string,"%d",&values[x])!=1)
+		{
+			fprintf(stderr,"*** Error: \"%s\" has a truncated header\n",filename);
+			error=-1;
+		}
+	}
+
+	header->max_west=values[0];
+	header->min_north=values[1];
+	header->min_west=values[2];
+	header->max_north=values[3];
+	header->min_el=32768;
+	header->max_el=-32768;
+
+	for (x=0; x<ippd && error==0; x++)
+		for (y=0; y<ippd && error==0; y++)
+		{
+			string=(bzfd!=NULL ? BZfgets(bzfd,19) : fgets(line,19,fd));
+
+			if (string==NULL)
+			{
+				fprintf(stderr,"*** Error: \"%s\" holds fewer than %d x %d samples (wrong resolution?)\n",filename,ippd,ippd);
+				error=-1;
+				break;
+			}
+
+			data=atoi(string);
+
+			elev[x*ippd+y]=data;
+
+			if (data>header->max_el)
+				header->max_el=data;
+
+			if (data<header->min_el)
+				header->min_el=data;
+		}
+
+	if (bzfd!=NULL)
+		BZ2_bzReadClose(&bzerror,bzfd);
+
+	fclose(fd);
+
+	return error;
+}
+
+int WriteBSDF(char *filename, struct sdf_bin_header *header)
+{
+	FILE *fd;
+	size_t count=(size_t)ippd*ippd;
+
+	fd=fopen(filename,"wb");
+
+	if (fd==NULL)
+	{
+		fprintf(stderr,"*** Error: Cannot write \"%s\"\n",filename);
+		return -1;
+	}
+
+	if (fwrite(header,sizeof(struct sdf_bin_header),1,fd)!=1 || fwrite(elev,sizeof(short),count,fd)!=count)
+	{
+		fprintf(stderr,"*** Error: Short write to \"%s\"\n",filename);
+		fclose(fd);
+		return -1;
+	}
+
+	fclose(fd);
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int z, error=0;
+	char bsdf_filename[255], *base, *ext;
+	struct sdf_bin_header header;
+
+	if (argc==1)
+	{
+		fprintf(stderr,"\nsdf2bsdf: Converts SPLAT Data Files (.sdf or .sdf.bz2) into\n");
+		fprintf(stderr,"binary .bsdf files that SPLAT! loads without parsing.\n\n");
+		fprintf(stderr,"\tsdf2bsdf file.sdf [file.sdf.bz2 ...]\n\n");
+		fprintf(stderr,"HD (one arc-second) tiles are recognized by their \"-hd\" name suffix.\n");
+		fprintf(stderr,"Output files are written into the current working directory.\n\n");
+		return 1;
+	}
+
+	elev=(short *)malloc(sizeof(short)*3600*3600);
+
+	if (elev==NULL)
+	{
+		fprintf(stderr,"*** Error: Out of memory\n");
+		return 1;
+	}
+
+	for (z=1; z<argc; z++)
+	{
+		base=strrchr(argv[z],'/');
+		base=(base!=NULL ? base+1 : argv[z]);
+
+		strncpy(bsdf_filename,base,240);
+		bsdf_filename[240]=0;
+
+		ext=strstr(bsdf_filename,".sdf");
+
+		if (ext==NULL)
+		{
+			fprintf(stderr,"*** Error: \"%s\" does not have the correct extension (.sdf or .sdf.bz2)\n",argv[z]);
+			error=1;
+			continue;
+		}
+
+		strcpy(ext,".bsdf");
+
+		ippd=(strstr(bsdf_filename,"-hd")!=NULL ? 3600 : 1200);
+
+		memset(&header,0,sizeof(header));
+		memcpy(header.magic,SDF_BIN_MAGIC,8);
+		header.version=SDF_BIN_VERSION;
+		header.byte_order=SDF_BIN_BYTE_ORDER;
+		header.ippd=ippd;
+
+		if (ReadSDF(argv[z],&header)!=0 || WriteBSDF(bsdf_filename,&header)!=0)
+		{
+			error=1;
+			continue;
+		}
+
+		fprintf(stdout,"Writing \"%s\"... Done!\n",bsdf_filename);
+		fflush(stdout);
+	}
+
+	free(elev);
+
+	return error;
+}
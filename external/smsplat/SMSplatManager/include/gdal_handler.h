@@ -27,9 +27,13 @@ public:
     GdalHandler();
     ~GdalHandler();
 
+    // Reprojects a north-up EPSG:4326 image (BGR or BGRA) to "dst_epsg",
+    // giving a BGRA image. Web Mercator is resampled natively, anything
+    // else is warped by GDAL; both use nearest-neighbour sampling.
     bool translate_and_reproject_image_buffer(const cv::Mat& input, cv::Mat& output, 
                                            ProjectedBounds& projected_bounds,
-                                           const std::vector<double>& geoCoords);
+                                           const std::vector<double>& geoCoords,
+                                           int dst_epsg = 3857);
 
 };
 
@@ -2,6 +2,7 @@
 #define SM_SPLAT_MANAGER_H
 
 #include "splat.h"
+#include <atomic>
 #include <memory>
 #include <map>
 #include <string>
@@ -17,8 +18,13 @@ class SMSplatManager {
     SMSplatManager();
     ~SMSplatManager() = default;
 
-    // Function to run SPLAT analysis with parameters
-    SMSplatGenInfo generate(const SMSplatInputInfo& input_info);
+    // Function to run SPLAT analysis with parameters.  "progress", if
+    // set, is told how far each phase has got, on the calling thread;
+    // once *cancel turns true, the run stops at its next check and
+    // throws SplatCancelled
+    SMSplatGenInfo generate(const SMSplatInputInfo& input_info,
+                            const SMSplatProgress& progress = SMSplatProgress(),
+                            const std::atomic<bool>* cancel = nullptr);
 
     // Process SPLAT viewshed and return the generated info
     SMSplatGenInfo genSimulatedGenInfo(const SMSplatInputInfo& input);
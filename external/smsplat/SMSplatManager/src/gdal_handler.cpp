@@ -8,6 +8,7 @@
 #include <gdal_alg.h>
 #include <fstream>
 #include "image_utils.h"
+#include "mercator_resampler.h"
 
 GdalHandler::GdalHandler()
 {
@@ -16,35 +17,96 @@ GdalHandler::GdalHandler()
 
 GdalHandler::~GdalHandler(){};
 
+// Output grid GDALAutoCreateWarpedVRT() picks for a width x height
+// EPSG:4326 raster, found on a band-less dataset so nothing is copied
+// or warped
+static bool suggest_warp_output(int width, int height, double geoTransform[6], const char* dstWKT,
+                                double dstGeoTransform[6], int& dstWidth, int& dstHeight) {
+    GDALDriver *memDriver = GetGDALDriverManager()->GetDriverByName("MEM");
+    GDALDataset *grid = memDriver->Create("", width, height, 0, GDT_Byte, nullptr);
+
+    if (!grid) {
+        return false;
+    }
+
+    grid->SetGeoTransform(geoTransform);
+    grid->SetProjection("EPSG:4326");
+
+    char** options = CSLSetNameValue(nullptr, "SRC_SRS", grid->GetProjectionRef());
+    options = CSLSetNameValue(options, "DST_SRS", dstWKT);
+    void* transformer = GDALCreateGenImgProjTransformer2(grid, nullptr, options);
+    bool ok = transformer &&
+              GDALSuggestedWarpOutput(grid, GDALGenImgProjTransform, transformer, dstGeoTransform,
+                                      &dstWidth, &dstHeight) == CE_None;
+
+    if (transformer) {
+        GDALDestroyGenImgProjTransformer(transformer);
+    }
+    CSLDestroy(options);
+    GDALClose(grid);
+
+    return ok;
+}
+
+static void set_projected_bounds(ProjectedBounds& projected_bounds, const double geoTransform[6],
+                                 int width, int height) {
+    projected_bounds.min_x = geoTransform[0];
+    projected_bounds.max_x = geoTransform[0] + (geoTransform[1] * width);
+    projected_bounds.min_y = geoTransform[3];
+    projected_bounds.max_y = geoTransform[3] + (geoTransform[5] * height);
+    projected_bounds.width = width;
+    projected_bounds.height = height;
+}
+
 bool GdalHandler::translate_and_reproject_image_buffer(const cv::Mat& input, cv::Mat& output, 
                                            ProjectedBounds& projected_bounds,
-                                           const std::vector<double>& geoCoords) {
+                                           const std::vector<double>& geoCoords,
+                                           int dst_epsg) {
     assert(geoCoords.size() == 4);
-    assert(!input.empty() && input.channels() == 3);
+    assert(!input.empty() && (input.channels() == 3 || input.channels() == 4));
     int inWidth = input.cols;
     int inHeight = input.rows;
-    int num_bands = 3;
+    int num_bands = input.channels();
+    // Bands are R, G, B (and A); OpenCV pixels are interleaved B, G, R (, A)
+    int bandMap[4] = {3, 2, 1, 4};
     GDALAllRegister();
     GDALSetCacheMax(1024 * 1024 * 1024); // 1GB
 
+    double geoTransform[6] = { geoCoords[0],   (geoCoords[2]-geoCoords[0])/inWidth, 0.0, geoCoords[1], 0.0, (geoCoords[3]-geoCoords[1])/inHeight };
 
+    OGRSpatialReference dstSRS;
+    dstSRS.importFromEPSG(dst_epsg);
+    char* dstWKT = nullptr;
+    dstSRS.exportToWkt(&dstWKT);
+
+    if (dst_epsg == 3857) {
+        // Web Mercator: resample rows natively onto the grid GDAL would
+        // warp to, which gives GDAL's nearest-neighbour pixels without
+        // copying the image into GDAL and back
+        double dstGeoTransform[6];
+        int dstWidth = 0, dstHeight = 0;
+
+        if (suggest_warp_output(inWidth, inHeight, geoTransform, dstWKT, dstGeoTransform,
+                                dstWidth, dstHeight) &&
+            MercatorResampler::supports(geoTransform, inHeight, dstGeoTransform)) {
+            MercatorResampler(inWidth, inHeight, geoTransform, dstWidth, dstHeight,
+                              dstGeoTransform)
+                .resample(input, output);
+            set_projected_bounds(projected_bounds, dstGeoTransform, dstWidth, dstHeight);
+            CPLFree(dstWKT);
+            return true;
+        }
+    }
+
+    // Any other projection goes through GDAL's warper
     GDALDriver *memDriver = GetGDALDriverManager()->GetDriverByName("MEM");
     GDALDataset *dataset = memDriver->Create("", inWidth, inHeight, num_bands, GDT_Byte, nullptr);
 
-    std::vector<cv::Mat> bgrChannels(3);
-    cv::split(input, bgrChannels);
-
-    dataset->GetRasterBand(1)->RasterIO(GF_Write, 0, 0, inWidth, inHeight, bgrChannels[2].data, inWidth, inHeight, GDT_Byte, 0, 0); // R
-    dataset->GetRasterBand(2)->RasterIO(GF_Write, 0, 0, inWidth, inHeight, bgrChannels[1].data, inWidth, inHeight, GDT_Byte, 0, 0); // G
-    dataset->GetRasterBand(3)->RasterIO(GF_Write, 0, 0, inWidth, inHeight, bgrChannels[0].data, inWidth, inHeight, GDT_Byte, 0, 0); // B
-    double geoTransform[6] = { geoCoords[0],   (geoCoords[2]-geoCoords[0])/inWidth, 0.0, geoCoords[1], 0.0, (geoCoords[3]-geoCoords[1])/inHeight };
+    // One interleaved write for all bands, straight from the OpenCV buffer
+    dataset->RasterIO(GF_Write, 0, 0, inWidth, inHeight, input.data, inWidth, inHeight, GDT_Byte,
+                      num_bands, bandMap, num_bands, (GSpacing)input.step, 1);
     dataset->SetGeoTransform(geoTransform);
     dataset->SetProjection("EPSG:4326");
-    
-    OGRSpatialReference dstSRS;
-    dstSRS.importFromEPSG(3857); // Web Mercator
-    char* dstWKT = nullptr;
-    dstSRS.exportToWkt(&dstWKT);
 
     GDALWarpOptions* warpOptions = GDALCreateWarpOptions();
     warpOptions->eResampleAlg = GRA_NearestNeighbour;
@@ -77,39 +139,19 @@ bool GdalHandler::translate_and_reproject_image_buffer(const cv::Mat& input, cv:
     warpedDataset->GetGeoTransform(warpedGeoTransform);
     int warpedWidth = warpedDataset->GetRasterXSize();
     int warpedHeight = warpedDataset->GetRasterYSize();
-    projected_bounds.min_x = warpedGeoTransform[0];
-    projected_bounds.max_x = warpedGeoTransform[0] + (warpedGeoTransform[1] * warpedWidth);
-    projected_bounds.min_y = warpedGeoTransform[3];
-    projected_bounds.max_y = warpedGeoTransform[3] + (warpedGeoTransform[5] * warpedHeight);
-    projected_bounds.width = warpedWidth;
-    projected_bounds.height = warpedHeight;
-
-    // Create a 4-channel output (RGBA)
-    output.create(warpedHeight, warpedWidth, CV_8UC4); // 4 channels for RGBA
-
-
-    std::vector<cv::Mat> outChannels(4);
-    cv::split(output, outChannels);
-    
-    // > 1100 ms
-    warpedDataset->GetRasterBand(1)->RasterIO(GF_Read, 0, 0, warpedWidth, warpedHeight, outChannels[2].data, warpedWidth, warpedHeight, GDT_Byte, 0, 0);
-    warpedDataset->GetRasterBand(2)->RasterIO(GF_Read, 0, 0, warpedWidth, warpedHeight, outChannels[1].data, warpedWidth, warpedHeight, GDT_Byte, 0, 0);
-    warpedDataset->GetRasterBand(3)->RasterIO(GF_Read, 0, 0, warpedWidth, warpedHeight, outChannels[0].data, warpedWidth, warpedHeight, GDT_Byte, 0, 0);
-
-
-    // Set the alpha channel (transparency)
-    for (int y = 0; y < warpedHeight; ++y) {
-        for (int x = 0; x < warpedWidth; ++x) {
-            // If the pixel is white (R == G == B == 255), set alpha to 0 (transparent)
-            if (outChannels[0].at<uchar>(y, x) == 255 && outChannels[1].at<uchar>(y, x) == 255 && outChannels[2].at<uchar>(y, x) == 255) {
-                outChannels[3].at<uchar>(y, x) = 0;  // Transparent
-            } else {
-                outChannels[3].at<uchar>(y, x) = 255;  // Opaque
-            }
-        }
-    }
-    
-    cv::merge(outChannels, output);
+    set_projected_bounds(projected_bounds, warpedGeoTransform, warpedWidth, warpedHeight);
+
+    // Create a 4-channel output (BGRA). The alpha band is warped with
+    // the colours when the renderer drew one (-trans); otherwise every
+    // pixel is opaque.
+    output.create(warpedHeight, warpedWidth, CV_8UC4);
+
+    if (num_bands < 4)
+        output.setTo(cv::Scalar(0, 0, 0, 255));
+
+    warpedDataset->RasterIO(GF_Read, 0, 0, warpedWidth, warpedHeight, output.data, warpedWidth,
+                            warpedHeight, GDT_Byte, num_bands, bandMap, 4,
+                            (GSpacing)output.step, 1);
     //cv::imwrite("warped_image.png", output);
 
     // CLeanup
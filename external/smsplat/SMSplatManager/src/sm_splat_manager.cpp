@@ -20,9 +20,23 @@ void SMSplatManager::setSplatLrpPath(const std::string& lrp_path) {
     }
 }
 
-SMSplatGenInfo SMSplatManager::generate(const SMSplatInputInfo& input_info) {
+SMSplatGenInfo SMSplatManager::generate(const SMSplatInputInfo& input_info,
+                                        const SMSplatProgress& progress,
+                                        const std::atomic<bool>* cancel) {
     auto total_start = std::chrono::high_resolution_clock::now();
-    
+
+    // The progress and cancel hooks only hold for this run
+    struct HookReset {
+        SplatProcessor* splat;
+        ~HookReset() {
+            splat->setProgress(SMSplatProgress());
+            splat->setCancelFlag(nullptr);
+        }
+    } hook_reset{splat_.get()};
+
+    splat_->setProgress(progress);
+    splat_->setCancelFlag(cancel);
+
     try {
         // SPLAT Processing timing
         auto splat_start = std::chrono::high_resolution_clock::now();
@@ -35,9 +49,14 @@ SMSplatGenInfo SMSplatManager::generate(const SMSplatInputInfo& input_info) {
         auto splat_end = std::chrono::high_resolution_clock::now();
         auto splat_duration = std::chrono::duration_cast<std::chrono::milliseconds>(splat_end - splat_start);
         std::cout << "TIME:::SPLAT Processing time----------: " << splat_duration.count() << " ms" << std::endl;
+        TerrainCache::Stats cache_stats = TerrainCache::instance().stats();
+        std::cout << "Terrain cache: " << cache_stats.hits << " hits, " << cache_stats.misses
+                  << " misses, " << cache_stats.evictions << " evictions, " << cache_stats.tiles
+                  << " tiles cached" << std::endl;
         // Get the generated image info
         generatedImageInfo = splat_->getGeneratedImageInfo();
         splat_->resetSplat();
+        splat_->CheckCancelled();
 
         // Get the image buffer from SPLAT
        const cv::Mat &inputBuffer = splat_->getImageBuffer();
@@ -53,6 +72,7 @@ SMSplatGenInfo SMSplatManager::generate(const SMSplatInputInfo& input_info) {
         std::cout << "Input buffer size: " << inputBuffer.size() << " bytes" << std::endl;
 
         auto gdal_start = std::chrono::high_resolution_clock::now();
+        if (progress) progress(SMSPLAT_REPROJECT, 0.0);
         if (gdal_handler_->translate_and_reproject_image_buffer(
                 inputBuffer,
                 outputBuffer,
@@ -72,6 +92,7 @@ SMSplatGenInfo SMSplatManager::generate(const SMSplatInputInfo& input_info) {
         } else {
             throw std::runtime_error("Failed to create reprojected PNG");
         }
+        if (progress) progress(SMSPLAT_REPROJECT, 1.0);
         auto gdal_end = std::chrono::high_resolution_clock::now();
         auto gdal_duration = std::chrono::duration_cast<std::chrono::milliseconds>(gdal_end - gdal_start);
         std::cout << "TIME:::GDAL Processing time----------: " << gdal_duration.count() << " ms" << std::endl;
@@ -114,6 +135,10 @@ SMSplatGenInfo SMSplatManager::generate(const SMSplatInputInfo& input_info) {
 
         std::cout << "✅ SMSplatManager::generate Complete ===" << std::endl;
         return generatedImageInfo;
+    } catch (const SplatCancelled &) {
+        spdlog::info("Generate cancelled");
+        splat_->resetSplat();
+        throw;
     } catch (const std::exception &e) {
         spdlog::error("Error in Generate processing: {}", e.what());
         throw;
@@ -0,0 +1,97 @@
+#include "mercator_resampler.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Source pixel holding "coordinate", as GDAL's nearest-neighbour warper
+// picks it, or -1 outside [0, size)
+int sourcePixel(double coordinate, int size) {
+    double pixel = std::floor(coordinate + 1e-10);
+
+    return (pixel >= 0.0 && pixel < size) ? (int)pixel : -1;
+}
+
+}  // namespace
+
+MercatorResampler::MercatorResampler(int src_width, int src_height,
+                                     const double src_geotransform[6], int dst_width,
+                                     int dst_height, const double dst_geotransform[6])
+    : dst_width_(dst_width), dst_height_(dst_height), columns_(dst_width), rows_(dst_height) {
+    const double rad2deg = 180.0 / M_PI;
+
+    for (int x = 0; x < dst_width; x++) {
+        double easting = dst_geotransform[0] + (x + 0.5) * dst_geotransform[1];
+        double longitude = easting / EARTH_RADIUS * rad2deg;
+
+        columns_[x] = sourcePixel((longitude - src_geotransform[0]) / src_geotransform[1],
+                                  src_width);
+    }
+
+    for (int y = 0; y < dst_height; y++) {
+        double northing = dst_geotransform[3] + (y + 0.5) * dst_geotransform[5];
+        double latitude = std::atan(std::sinh(northing / EARTH_RADIUS)) * rad2deg;
+
+        rows_[y] = sourcePixel((latitude - src_geotransform[3]) / src_geotransform[5],
+                               src_height);
+    }
+}
+
+bool MercatorResampler::supports(const double src_geotransform[6], int src_height,
+                                 const double dst_geotransform[6]) {
+    double north = src_geotransform[3];
+    double south = src_geotransform[3] + src_height * src_geotransform[5];
+
+    return src_geotransform[2] == 0.0 && src_geotransform[4] == 0.0 &&
+           src_geotransform[1] > 0.0 && src_geotransform[5] < 0.0 &&
+           dst_geotransform[2] == 0.0 && dst_geotransform[4] == 0.0 &&
+           dst_geotransform[1] > 0.0 && dst_geotransform[5] < 0.0 &&
+           north <= MAX_LATITUDE && south >= -MAX_LATITUDE;
+}
+
+void MercatorResampler::resample(const cv::Mat& input, cv::Mat& output) const {
+    const int channels = input.channels();
+    const unsigned char outside[4] = {0, 0, 0, (unsigned char)(channels == 4 ? 0 : 255)};
+    const size_t row_bytes = (size_t)dst_width_ * 4;
+
+    output.create(dst_height_, dst_width_, CV_8UC4);
+
+    for (int y = 0; y < dst_height_; y++) {
+        unsigned char* out = output.ptr<unsigned char>(y);
+
+        if (y > 0 && rows_[y] == rows_[y - 1]) {
+            memcpy(out, output.ptr<unsigned char>(y - 1), row_bytes);
+            continue;
+        }
+
+        if (rows_[y] < 0) {
+            for (int x = 0; x < dst_width_; x++) memcpy(out + 4 * x, outside, 4);
+            continue;
+        }
+
+        const unsigned char* in = input.ptr<unsigned char>(rows_[y]);
+
+        if (channels == 4) {
+            for (int x = 0; x < dst_width_; x++) {
+                int column = columns_[x];
+
+                memcpy(out + 4 * x, column < 0 ? outside : in + 4 * column, 4);
+            }
+        } else {
+            for (int x = 0; x < dst_width_; x++) {
+                int column = columns_[x];
+                unsigned char* pixel = out + 4 * x;
+
+                if (column < 0) {
+                    memcpy(pixel, outside, 4);
+                } else {
+                    pixel[0] = in[3 * column];
+                    pixel[1] = in[3 * column + 1];
+                    pixel[2] = in[3 * column + 2];
+                    pixel[3] = 255;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef MERCATOR_RESAMPLER_H
+#define MERCATOR_RESAMPLER_H
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Nearest-neighbour reprojection of a north-up EPSG:4326 raster onto a
+// north-up EPSG:3857 (Web Mercator) grid. Longitude maps linearly to
+// x and latitude to y alone, so the source column of every output
+// column and the source row of every output row are worked out once,
+// and each output row is gathered from a single source row (or copied
+// from the row above when both share one). Sampling follows GDAL's
+// warper: pixel centres are transformed and the source pixel is
+// floor(coordinate + 1e-10).
+class MercatorResampler {
+public:
+    static constexpr double EARTH_RADIUS = 6378137.0;  // EPSG:3857 sphere, meters
+    static constexpr double MAX_LATITUDE = 85.0511287798;  // Edge of the Web Mercator square
+
+    // Geotransforms use GDAL's six coefficient layout
+    MercatorResampler(int src_width, int src_height, const double src_geotransform[6],
+                      int dst_width, int dst_height, const double dst_geotransform[6]);
+
+    // Whether the grids are north-up, unrotated and inside Web Mercator's range
+    static bool supports(const double src_geotransform[6], int src_height,
+                         const double dst_geotransform[6]);
+
+    // Fills "output" (BGRA) from "input" (BGR or BGRA). Pixels off the
+    // source are zero, with alpha 255 for a BGR input as GDAL leaves them.
+    void resample(const cv::Mat& input, cv::Mat& output) const;
+
+private:
+    int dst_width_;
+    int dst_height_;
+    std::vector<int> columns_;  // Source column of each output column, -1 if off the source
+    std::vector<int> rows_;     // Source row of each output row, -1 if off the source
+};
+
+#endif // MERCATOR_RESAMPLER_H
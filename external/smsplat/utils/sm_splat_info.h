@@ -2,6 +2,7 @@
 #define SM_SPLAT_INFO_H
 
 #include <iosfwd>  // For std::ostream forward declaration
+#include <functional>
 #include <vector>
 #include <string>
 #include <opencv2/opencv.hpp>
@@ -40,6 +41,17 @@ struct SMSplatGenInfo {
     cv::Mat image_{};
 };
 
+// Stages of a generation, in the order they run
+enum SMSplatPhase {
+    SMSPLAT_TERRAIN,    // Loading the terrain tiles the coverage needs
+    SMSPLAT_SWEEP,      // Evaluating the radials around the transmitter
+    SMSPLAT_RENDER,     // Drawing the coverage map
+    SMSPLAT_REPROJECT   // Reprojecting the map to Web Mercator
+};
+
+// Receives the phase under way and the fraction of it done (0 to 1)
+typedef std::function<void(SMSplatPhase phase, double fraction)> SMSplatProgress;
+
 // Stream insertion operator overloads
 std::ostream& operator<<(std::ostream& os, const SMSplatInputInfo& info);
 std::ostream& operator<<(std::ostream& os, const SMSplatGenInfo& info);